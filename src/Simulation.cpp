@@ -0,0 +1,97 @@
+#include "core/Communicator.hpp"
+#include "core/Parameters.hpp"
+#include "solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#ifdef USE_MPI
+#include <mpi.h>
+#endif
+
+// Compiled once per precision; main() calls the one the config asks for.
+
+namespace PIC_REAL {
+
+int RunSimulation(int argc, char *argv[]) {
+#ifndef NDEBUG
+  std::cout << "Compiled with debug mode" << std::endl;
+#endif
+
+  // Parse parameters from command line
+  Parameters params;
+  if (!params.parseCommandLine(argc, argv)) {
+    return 1;
+  }
+
+#ifndef NDEBUG
+  // Display parameters
+  std::cout << params << std::endl;
+#endif
+
+  const DistributedConfig &dist = params.distributed;
+  if (dist.enabled() && !params.restartFile.empty()) {
+    std::cerr << "[main] A distributed run cannot resume from a checkpoint\n";
+    return 1;
+  }
+
+#ifdef USE_MPI
+  // One rank per MPI process, each on its own slab of rows.
+  if (dist.transport == DistributedConfig::Transport::MPI) {
+    MPI_Init(&argc, &argv);
+    bool root = true;
+    {
+      MpiCommunicator comm;
+      root = (comm.rank() == 0);
+      if (comm.size() > std::max(1, params.ny / (dist.halo + 1))) {
+        if (root)
+          std::cerr << "[main] " << comm.size() << " ranks of at least "
+                    << dist.halo + 1 << " rows do not fit in ny = "
+                    << params.ny << '\n';
+        MPI_Finalize();
+        return 1;
+      }
+      SemiLagrangian solver(params, &comm);
+      solver.Run();
+    }
+    MPI_Finalize();
+    if (root)
+      std::cout << "Simulation completed successfully!" << std::endl;
+    return 0;
+  }
+#endif
+
+  // Local ranks: one thread each, sharing the OpenMP threads.
+  if (dist.enabled()) {
+    LocalHub hub(dist.ranks);
+    const int threadsPerRank = std::max(1, MAX_THREADS() / dist.ranks);
+    std::vector<std::thread> ranks;
+    for (int r = 0; r < dist.ranks; ++r)
+      ranks.emplace_back([&params, &hub, r, threadsPerRank] {
+#ifdef USE_OPENMP
+        omp_set_num_threads(threadsPerRank);
+#else
+        (void)threadsPerRank;
+#endif
+        LocalCommunicator comm(hub, r);
+        SemiLagrangian solver(params, &comm);
+        solver.Run();
+      });
+    for (std::thread &rank : ranks)
+      rank.join();
+    std::cout << "Simulation completed successfully!" << std::endl;
+    return 0;
+  }
+
+  // Create and run solver
+  SemiLagrangian solver(params);
+  if (!params.restartFile.empty() && !solver.Restore(params.restartFile))
+    return 1;
+  solver.Run();
+
+  std::cout << "Simulation completed successfully!" << std::endl;
+  return 0;
+}
+
+} // namespace PIC_REAL
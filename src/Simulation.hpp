@@ -0,0 +1,25 @@
+#pragma once
+
+/**
+ * @file Simulation.hpp
+ * @brief Entry points of the float and double builds of the simulation.
+ *
+ * Simulation.cpp and everything it uses are compiled twice, into the
+ * namespaces @c real32 and @c real64 (see Precision.hpp). This header is
+ * precision-neutral: it is what main() includes to pick one at run time.
+ */
+
+namespace real32 {
+/**
+ * @brief Parse the command line, then run the simulation it configures.
+ * @param argc Argument count from @c main.
+ * @param argv Argument vector from @c main.
+ * @return Process exit code.
+ */
+int RunSimulation(int argc, char *argv[]);
+} // namespace real32
+
+namespace real64 {
+/// @copydoc real32::RunSimulation
+int RunSimulation(int argc, char *argv[]);
+} // namespace real64
@@ -0,0 +1,464 @@
+#include "../core/OutputWriter.hpp"
+#include "../core/Parameters.hpp"
+#include "../solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <nlohmann/json.hpp>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @file Benchmark.cpp
+ * @brief PIC_bench: throughput of the solver kernels in isolation.
+ *
+ * Every kernel runs on an n × n grid (walls on the border, pseudo-random
+ * non-solenoidal velocity) for each requested size and thread count. A
+ * measurement is the median over @c --reps timed calls after one untimed
+ * warm-up call; cached solver data (stencils, preconditioners, multigrid
+ * hierarchy) is built before the sweep and not timed. The smoke kernels
+ * use the configured @c SmokeLayout; the @c _tiled16 / @c _morton16
+ * kernels repeat a row-major one on a tiled copy of u.
+ *
+ * Reported per measurement:
+ * - @c cells_per_second: cells × work units (solver iterations) / time;
+ * - @c gb_per_second: the same times the kernel's compulsory memory
+ *   traffic per cell and unit (each array it streams read or written once,
+ *   see @c Kernel::bytesPerCell); a lower bound on the real traffic;
+ * - @c parallel_efficiency: t(T₀)·T₀ / (t(T)·T) against the smallest
+ *   thread count T₀ of the sweep.
+ *
+ * Usage:
+ * ```
+ * PIC_bench [--sizes 256,512,1024,2048,4096] [--threads 1,2,4]
+ *           [--reps 5] [--iters 20] [--out bench.json] [--dir bench_output]
+ *           [--precision float|double]
+ * ```
+ * This file is compiled once per precision like the solver; bench/main.cpp
+ * runs the build that @c --precision names.
+ */
+
+namespace PIC_REAL {
+
+/// Friend of SemiLagrangian: calls its private kernels.
+struct SemiLagrangianBench {
+  static Fields2D &fields(SemiLagrangian &s) { return *s.fields; }
+  static void advect(SemiLagrangian &s) { s.Advect(); }
+  static void advectSmoke(SemiLagrangian &s) { s.AdvectSmoke(); }
+  static void advectFused(SemiLagrangian &s) { s.AdvectFused(); }
+  static void updateVelocities(SemiLagrangian &s) { s.updateVelocities(); }
+  static void diffuse(SemiLagrangian &s) { s.Diffuse(); }
+  /// Decomposed projection (divergence, red-black solve, velocity update),
+  /// the shared one if the team is too small.
+  static void projectDecomposed(SemiLagrangian &s) {
+    if (!s.StepDecomposed(false))
+      s.MakeIncompressible();
+  }
+  static double residualNorm(const SemiLagrangian &s) {
+    return s.computeResidualNorm(s.density * s.dx * s.dx / s.dt);
+  }
+  /// Departure points of every u-face in index space (one RK2 trace).
+  static void traceU(SemiLagrangian &s, std::vector<varType> &xs,
+                     std::vector<varType> &ys) {
+    const Grid2D &u = s.fields->u;
+    xs.resize(u.A.size());
+    ys.resize(u.A.size());
+    SemiLagrangian::AdvectRow row = s.advectRow(0);
+    for (int j = 0; j < u.ny; ++j) {
+      for (int i = 0; i < u.nx; ++i) {
+        row.x0[i] = static_cast<varType>(i) * s.dx;
+        row.y0[i] = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * s.dy;
+      }
+      s.traceDepartureRow(u.nx, row, s.dt);
+      std::copy_n(row.xs, u.nx, xs.data() + static_cast<std::size_t>(u.nx) * j);
+      std::copy_n(row.ys, u.nx, ys.data() + static_cast<std::size_t>(u.nx) * j);
+    }
+  }
+  static void solvePressure(SemiLagrangian &s, SolverConfig::Type type,
+                            int iters) {
+    // A zero tolerance is never met: every solve runs @p iters iterations.
+    s.solvePressure(type, iters, 0.0);
+  }
+};
+
+namespace {
+
+using Bench = SemiLagrangianBench;
+
+/// One benchmarked kernel.
+struct Kernel {
+  std::string name;
+  double bytesPerCell;          ///< Compulsory traffic per cell and unit.
+  int units;                    ///< Work units per call (iterations).
+  std::function<void()> setup;  ///< Untimed, before every call.
+  std::function<void()> run;    ///< Timed call.
+};
+
+/// Command-line settings.
+struct Options {
+  std::vector<int> sizes = {256, 512, 1024, 2048, 4096};
+  std::vector<int> threads; ///< Default: 1, 2, 4, … up to the maximum.
+  int reps = 5;
+  int iters = 20;
+  std::string out = "bench.json";
+  std::string dir = "bench_output";
+};
+
+/// @return Comma-separated integers of @p text.
+std::vector<int> parseList(const std::string &text) {
+  std::vector<int> values;
+  std::stringstream ss(text);
+  std::string item;
+  while (std::getline(ss, item, ','))
+    if (!item.empty())
+      values.push_back(std::max(1, std::stoi(item)));
+  return values;
+}
+
+bool parseOptions(const int argc, char *argv[], Options &opt) {
+  for (int a = 1; a + 1 < argc; a += 2) {
+    const std::string_view flag = argv[a];
+    const std::string value = argv[a + 1];
+    if (flag == "--sizes")
+      opt.sizes = parseList(value);
+    else if (flag == "--threads")
+      opt.threads = parseList(value);
+    else if (flag == "--reps")
+      opt.reps = std::max(1, std::stoi(value));
+    else if (flag == "--iters")
+      opt.iters = std::max(1, std::stoi(value));
+    else if (flag == "--out")
+      opt.out = value;
+    else if (flag == "--dir")
+      opt.dir = value;
+    else if (flag == "--precision")
+      continue; // chosen by main()
+    else
+      return false;
+  }
+  if (argc % 2 == 0 || opt.sizes.empty())
+    return false;
+
+  if (opt.threads.empty()) {
+    for (int t = 1; t < MAX_THREADS(); t *= 2)
+      opt.threads.push_back(t);
+    opt.threads.push_back(MAX_THREADS());
+  }
+#ifndef USE_OPENMP
+  opt.threads = {1}; // single-threaded build
+#endif
+  std::sort(opt.threads.begin(), opt.threads.end());
+  opt.threads.erase(std::unique(opt.threads.begin(), opt.threads.end()),
+                    opt.threads.end());
+  return true;
+}
+
+void setThreads([[maybe_unused]] const int n) {
+#ifdef USE_OPENMP
+  omp_set_num_threads(n);
+#endif
+}
+
+/// @brief Fill u, v and the smoke with deterministic noise in [-1, 1].
+void fillNoise(Fields2D &f) {
+  uint64_t state = 0x9E3779B97F4A7C15ull;
+  auto next = [&state] {
+    state = state * 6364136223846793005ull + 1442695040888963407ull;
+    return static_cast<varType>(static_cast<double>(state >> 11) * 0x1p-52 -
+                                1.0);
+  };
+  for (Grid2D *g : {&f.u, &f.v})
+    for (varType &value : g->A)
+      value = next();
+  for (int j = 0; j < f.smokeMap.ny; ++j)
+    for (int i = 0; i < f.smokeMap.nx; ++i)
+      f.smokeMap.Set(i, j, next());
+}
+
+/// @brief Interpolate u at every point of a whole-grid trace, row-parallel.
+template <typename Layout>
+void interpolateAll(const BasicGrid2D<Layout> &u,
+                    const std::vector<varType> &xs,
+                    const std::vector<varType> &ys, const bool cubic,
+                    std::vector<varType> &out) {
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < u.ny; ++j) {
+    const std::size_t at = static_cast<std::size_t>(u.nx) * j;
+    if (cubic)
+      u.InterpolateCubicBatch(u.nx, xs.data() + at, ys.data() + at,
+                              REAL_LITERAL(0.0), REAL_LITERAL(0.5),
+                              out.data() + at);
+    else
+      u.InterpolateBatch(u.nx, xs.data() + at, ys.data() + at,
+                         REAL_LITERAL(0.0), REAL_LITERAL(0.5),
+                         out.data() + at);
+  }
+}
+
+/// @brief 5-point Laplacian of the interior of @p g through Get(), into
+///        @p out (row-major), row-parallel.
+template <typename Layout>
+void stencilAll(const BasicGrid2D<Layout> &g, std::vector<varType> &out) {
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 1; j < g.ny - 1; ++j)
+    for (int i = 1; i < g.nx - 1; ++i)
+      out[static_cast<std::size_t>(g.nx) * j + i] =
+          g.Get(i - 1, j) + g.Get(i + 1, j) + g.Get(i, j - 1) +
+          g.Get(i, j + 1) - REAL_LITERAL(4.0) * g.Get(i, j);
+}
+
+/// @return Median of @p v (reordered).
+double median(std::vector<double> &v) {
+  std::nth_element(v.begin(), v.begin() + v.size() / 2, v.end());
+  return v[v.size() / 2];
+}
+
+} // namespace
+
+int RunBenchmark(int argc, char *argv[]) {
+  const int hardwareThreads = MAX_THREADS();
+  Options opt;
+  if (!parseOptions(argc, argv, opt)) {
+    std::cout << "Usage: " << argv[0]
+              << " [--sizes 256,512,...] [--threads 1,2,...] [--reps N]"
+                 " [--iters N] [--out bench.json] [--dir bench_output]"
+                 " [--precision float|double]\n";
+    return 1;
+  }
+
+  namespace fs = std::filesystem;
+  const bool ownDir = !fs::exists(opt.dir);
+  fs::create_directories(opt.dir);
+
+  const double V = sizeof(varType);
+  nlohmann::json results = nlohmann::json::array();
+
+  for (const int n : opt.sizes) {
+    Parameters params;
+    params.nx = params.ny = n;
+    params.dx = params.dy = 1.0 / n;
+    params.dt = 0.5 * params.dx; // CFL 0.5 for |u| <= 1
+    params.nt = 0;
+    params.write_u = params.write_v = params.write_p = false;
+    params.folder = opt.dir;
+    params.profile.summary = false;
+    params.profile.history = 1;
+    // Viscous solves with nu·dt/dx² = 1, run for --iters iterations.
+    params.viscosity.nu = params.dx * params.dx / params.dt;
+    params.viscosity.maxIters = opt.iters;
+    params.viscosity.tolerance = 0.0;
+
+    // Every per-thread buffer is sized for the largest team of the sweep.
+    setThreads(opt.threads.back());
+    SemiLagrangian solver(params);
+    Fields2D &f = Bench::fields(solver);
+    f.SolidBorders();
+    fillNoise(f);
+    f.Div();
+
+    // One writer, rewound before every call so that it keeps overwriting
+    // the same file.
+    auto writer = [&](const char *name, const int level) {
+      OutputCompression zip;
+      zip.level = level;
+      return std::make_shared<OutputWriter>(opt.dir, name, nullptr, zip);
+    };
+    auto storeWriter = writer("bench_store", 0);
+    auto zlibWriter = writer("bench_zlib", 1);
+
+    // Interpolation at the departure points of one trace through the noise
+    // velocity, and at a uniformly displaced copy of the grid (the shared
+    // weights path of the cubic).
+    std::vector<varType> traceX, traceY, uniformX, uniformY;
+    std::vector<varType> interpolated(f.u.A.size());
+    Bench::traceU(solver, traceX, traceY);
+    uniformX.resize(traceX.size());
+    uniformY.resize(traceY.size());
+    for (int j = 0; j < f.u.ny; ++j)
+      for (int i = 0; i < f.u.nx; ++i) {
+        const std::size_t at = static_cast<std::size_t>(f.u.nx) * j + i;
+        uniformX[at] = static_cast<varType>(i) - REAL_LITERAL(0.3);
+        uniformY[at] = static_cast<varType>(j) + REAL_LITERAL(0.2);
+      }
+
+    // The same u in 16 × 16 tiles, in row and in Morton order (the layouts
+    // PIC_SMOKE_LAYOUT selects for the smoke), for the layout kernels.
+    TiledGrid2D<16> uTiled(f.u.nx, f.u.ny);
+    MortonGrid2D<16> uMorton(f.u.nx, f.u.ny);
+    uTiled.CopyFromRowMajor(f.u.A.data());
+    uMorton.CopyFromRowMajor(f.u.A.data());
+
+    auto coldStart = [&f] {
+      std::fill(f.p.A.begin(), f.p.A.end(), REAL_LITERAL(0.0));
+    };
+    auto solverKernel = [&](const char *name, const SolverConfig::Type type,
+                            const double bytes, const int units) {
+      return Kernel{name, bytes, units, coldStart, [&solver, type, units] {
+                      Bench::solvePressure(solver, type, units);
+                    }};
+    };
+
+    const SolverConfig &sc = params.solver;
+    const double stencilBytes = 4 * 4 + 3 * 8 + 4; // nb, N, 1/N, 4-N, cell
+    const double mgSweeps = sc.mgPreSmooth + sc.mgPostSmooth;
+    const std::vector<Kernel> kernels = {
+        {"advect", 4 * V, 1, [] {}, [&] { Bench::advect(solver); }},
+        {"advect_smoke", 4 * V, 1, [] {}, [&] { Bench::advectSmoke(solver); }},
+        // u, v and smoke read once, three back-buffers written
+        {"advect_fused", 6 * V, 1, [] {}, [&] { Bench::advectFused(solver); }},
+        solverKernel("jacobi", SolverConfig::Type::JACOBI,
+                     3 * V + stencilBytes + 2 * 8, opt.iters),
+        solverKernel("gauss_seidel", SolverConfig::Type::GAUSS_SEIDEL,
+                     3 * V + stencilBytes, opt.iters),
+        solverKernel("red_black_gauss_seidel",
+                     SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL,
+                     3 * V + stencilBytes, opt.iters),
+        // p, rhs, diag, invDiag of the slabs, one pass per colour
+        {"red_black_decomposed", 4 * V, opt.iters, coldStart,
+         [&] {
+           const SolverConfig saved = params.solver;
+           params.solver.maxIters = opt.iters;
+           params.solver.tolerance = 0.0;
+           Bench::projectDecomposed(solver);
+           params.solver = saved;
+         }},
+        // s, q, r, z, precon streamed about twice per iteration
+        solverKernel("pcg", SolverConfig::Type::PCG, 10 * 8, opt.iters),
+        // x, b, diag, invDiag per fine sweep; coarse levels add 1/3
+        solverKernel("multigrid", SolverConfig::Type::MULTIGRID,
+                     4.0 / 3.0 * (mgSweeps + 1) * 4 * V, opt.iters),
+        // the same cycles on float levels, plus the double fine residual
+        {"multigrid_mixed", 4.0 / 3.0 * (mgSweeps + 1) * 4 * 4 + 2 * 8 + 2 * V,
+         opt.iters, coldStart,
+         [&] {
+           params.solver.precision = SolverConfig::Precision::MIXED;
+           Bench::solvePressure(solver, SolverConfig::Type::MULTIGRID,
+                                opt.iters);
+           params.solver.precision = SolverConfig::Precision::WORKING;
+         }},
+        // u and v faces: x, b, r, z, s, q, streamed about twice
+        {"viscosity_pcg", 2 * (2 * V + 10 * 8), opt.iters, [] {},
+         [&] { Bench::diffuse(solver); }},
+        // r, z and four read/write passes over the box
+        solverKernel("spectral", SolverConfig::Type::SPECTRAL, 10 * 8, 1),
+        // x, y in, value out; the stencils mostly hit the cache
+        {"interpolate_linear", 4 * V, 1, [] {},
+         [&] { interpolateAll(f.u, traceX, traceY, false, interpolated); }},
+        {"interpolate_cubic", 4 * V, 1, [] {},
+         [&] { interpolateAll(f.u, traceX, traceY, true, interpolated); }},
+        {"interpolate_cubic_uniform", 4 * V, 1, [] {},
+         [&] {
+           interpolateAll(f.u, uniformX, uniformY, true, interpolated);
+         }},
+        {"interpolate_linear_tiled16", 4 * V, 1, [] {},
+         [&] {
+           interpolateAll(uTiled, traceX, traceY, false, interpolated);
+         }},
+        {"interpolate_linear_morton16", 4 * V, 1, [] {},
+         [&] {
+           interpolateAll(uMorton, traceX, traceY, false, interpolated);
+         }},
+        // five reads through Get(), mostly cache hits, one write
+        {"stencil_get", 2 * V, 1, [] {},
+         [&] { stencilAll(f.u, interpolated); }},
+        {"stencil_get_tiled16", 2 * V, 1, [] {},
+         [&] { stencilAll(uTiled, interpolated); }},
+        {"stencil_get_morton16", 2 * V, 1, [] {},
+         [&] { stencilAll(uMorton, interpolated); }},
+        // row-major copy for the output writers: tile-row segments
+        {"to_row_major", 2 * V, 1, [] {},
+         [&] { f.u.CopyToRowMajor(interpolated.data()); }},
+        {"to_row_major_tiled16", 2 * V, 1, [] {},
+         [&] { uTiled.CopyToRowMajor(interpolated.data()); }},
+        {"to_row_major_morton16", 2 * V, 1, [] {},
+         [&] { uMorton.CopyToRowMajor(interpolated.data()); }},
+        {"residual_norm", 2 * V + 1, 1, [] {},
+         [&] { (void)Bench::residualNorm(solver); }},
+        {"update_velocities", 5 * V + 2, 1, [] {},
+         [&] { Bench::updateVelocities(solver); }},
+        {"velocity_norm", 3 * V, 1, [] {},
+         [&] { f.VelocityNormCenterGrid(); }},
+        {"write_vti_store", 2 * V, 1, [&] { storeWriter->restoreState(0, {}); },
+         [&] { storeWriter->writeGrid2D(f.p, "p", 0.0); }},
+        {"write_vti_zlib", 2 * V, 1, [&] { zlibWriter->restoreState(0, {}); },
+         [&] { zlibWriter->writeGrid2D(f.p, "p", 0.0); }},
+    };
+
+    // Solvers size their cached per-thread scratch on first use: build it
+    // with the largest team, which every smaller one then fits into.
+    for (const Kernel &k : kernels) {
+      k.setup();
+      k.run();
+    }
+
+    const double cells = static_cast<double>(n) * n;
+    for (const Kernel &k : kernels) {
+      double base = 0.0; // t(T₀)·T₀
+      for (const int threads : opt.threads) {
+        setThreads(threads);
+        k.setup();
+        k.run(); // warm-up
+
+        std::vector<double> times(opt.reps);
+        for (double &t : times) {
+          k.setup();
+          const double start = GET_TIME();
+          k.run();
+          t = GET_TIME() - start;
+        }
+        const double best = *std::min_element(times.begin(), times.end());
+        const double seconds = median(times);
+        if (base == 0.0)
+          base = seconds * threads;
+
+        const double work = cells * k.units;
+        results.push_back({{"kernel", k.name},
+                           {"nx", n},
+                           {"ny", n},
+                           {"threads", threads},
+                           {"units", k.units},
+                           {"seconds", seconds},
+                           {"min_seconds", best},
+                           {"cells_per_second", work / seconds},
+                           {"gb_per_second",
+                            work * k.bytesPerCell / seconds * 1e-9},
+                           {"parallel_efficiency",
+                            base / (seconds * threads)}});
+        std::cout << n << "² " << k.name << " x" << threads << ": "
+                  << seconds * 1e3 << " ms, " << work / seconds * 1e-6
+                  << " Mcells/s\n";
+      }
+    }
+  }
+
+  nlohmann::json report = {{"precision", PRECISION_STRING},
+                           {"max_threads", hardwareThreads},
+                           {"reps", opt.reps},
+                           {"iterations", opt.iters},
+#ifdef HAVE_ZLIB
+                           {"zlib", true},
+#else
+                           {"zlib", false},
+#endif
+                           {"results", results}};
+  std::ofstream out(opt.out);
+  out << report.dump(2) << '\n';
+  if (!out) {
+    std::cerr << "[PIC_bench] Could not write '" << opt.out << "'\n";
+    return 1;
+  }
+  if (ownDir) {
+    std::error_code ec;
+    fs::remove_all(opt.dir, ec);
+  }
+  std::cout << "Results written to '" << opt.out << "'\n";
+  return 0;
+}
+
+} // namespace PIC_REAL
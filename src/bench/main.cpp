@@ -0,0 +1,36 @@
+#include <iostream>
+#include <string_view>
+
+// PIC_bench measures the kernels in one precision, the one --precision
+// names, else the one CMake was configured with (USE_FLOAT_PRECISION).
+// Benchmark.cpp is compiled once per precision, see Precision.hpp.
+
+namespace real32 {
+int RunBenchmark(int argc, char *argv[]);
+} // namespace real32
+
+namespace real64 {
+int RunBenchmark(int argc, char *argv[]);
+} // namespace real64
+
+int main(int argc, char *argv[]) {
+#ifdef PIC_DEFAULT_FLOAT
+  bool useFloat = true;
+#else
+  bool useFloat = false;
+#endif
+  for (int a = 1; a + 1 < argc; a += 2) {
+    const std::string_view flag = argv[a];
+    const std::string_view value = argv[a + 1];
+    if (flag != "--precision")
+      continue;
+    if (value != "float" && value != "double") {
+      std::cerr << "[PIC_bench] Unknown precision '" << value
+                << "', expected float or double\n";
+      return 1;
+    }
+    useFloat = (value == "float");
+  }
+  return useFloat ? real32::RunBenchmark(argc, argv)
+                  : real64::RunBenchmark(argc, argv);
+}
@@ -0,0 +1,102 @@
+#include "ActiveTiles.hpp"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace PIC_REAL {
+
+ActiveTiles::ActiveTiles(const int nx, const int ny, const int tile)
+    : nx_(std::max(nx, 0)), ny_(std::max(ny, 0)), tile_(std::max(tile, 1)),
+      tilesX_((nx_ + tile_ - 1) / tile_), tilesY_((ny_ + tile_ - 1) / tile_) {
+  const std::size_t rows = static_cast<std::size_t>(ny_) * tilesX_;
+  const std::size_t tiles = static_cast<std::size_t>(tilesY_) * tilesX_;
+  occupied_.assign(rows, 0);
+  nextOccupied_.assign(rows, 0);
+  written_.assign(tiles, 1);
+  nextWritten_.assign(tiles, 1);
+  active_.assign(tiles, 0);
+  cleared_.assign(tiles, 0);
+}
+
+void ActiveTiles::MarkCells(const int i0, const int i1, const int j0,
+                            const int j1) {
+  if (!enabled())
+    return;
+  const int a = std::max(i0, 0), b = std::min(i1, nx_);
+  const int c = std::max(j0, 0), d = std::min(j1, ny_);
+  if (a >= b || c >= d)
+    return;
+  for (int j = c; j < d; ++j)
+    for (int ti = a / tile_; ti <= (b - 1) / tile_; ++ti) {
+      occupied_[static_cast<std::size_t>(tilesX_) * j + ti] = 1;
+      written_[idx(ti, j / tile_)] = 1;
+    }
+}
+
+void ActiveTiles::Update(const SmokeGrid2D &grid, const varType threshold,
+                         const int reach) {
+  const int tx = tilesX_, ty = tilesY_;
+
+  // First step, or the grid was replaced: scan every row segment once. Both
+  // buffers may hold anything, so every tile stays written.
+  if (!valid_) {
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < ny_; ++j) {
+      for (int ti = 0; ti < tx; ++ti) {
+        bool occupied = false;
+        for (int i = ti * tile_; i < std::min((ti + 1) * tile_, nx_); ++i)
+          occupied |= std::abs(grid.Get(i, j)) > threshold;
+        occupied_[static_cast<std::size_t>(tx) * j + ti] = occupied;
+      }
+    }
+    std::fill(written_.begin(), written_.end(), 1);
+    std::fill(nextWritten_.begin(), nextWritten_.end(), 1);
+    valid_ = true;
+  }
+
+  // Occupied tiles (any of their row segments) into cleared_, used as
+  // scratch, then dilated by r tiles along x into active_ and along y back
+  // into cleared_.
+  const int r = (std::max(reach, 0) + tile_ - 1) / tile_;
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int tj = 0; tj < ty; ++tj)
+    for (int ti = 0; ti < tx; ++ti) {
+      bool occupied = false;
+      for (int j = tj * tile_; j < std::min((tj + 1) * tile_, ny_); ++j)
+        occupied |= occupied_[static_cast<std::size_t>(tx) * j + ti] != 0;
+      cleared_[idx(ti, tj)] = occupied;
+    }
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int tj = 0; tj < ty; ++tj)
+    for (int ti = 0; ti < tx; ++ti) {
+      bool near = false;
+      for (int t = std::max(ti - r, 0); t <= std::min(ti + r, tx - 1); ++t)
+        near |= cleared_[idx(t, tj)] != 0;
+      active_[idx(ti, tj)] = near;
+    }
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int tj = 0; tj < ty; ++tj)
+    for (int ti = 0; ti < tx; ++ti) {
+      bool near = false;
+      for (int t = std::max(tj - r, 0); t <= std::min(tj + r, ty - 1); ++t)
+        near |= active_[idx(ti, t)] != 0;
+      cleared_[idx(ti, tj)] = near;
+    }
+  std::swap(active_, cleared_);
+
+  // The back-buffer is rewritten on the active tiles and zeroed on those it
+  // held before: afterwards it is written exactly where active.
+  activeCount_ = 0;
+  for (std::size_t t = 0; t < active_.size(); ++t) {
+    cleared_[t] = nextWritten_[t] && !active_[t];
+    nextWritten_[t] = active_[t];
+    activeCount_ += active_[t];
+  }
+}
+
+void ActiveTiles::Swap() {
+  std::swap(occupied_, nextOccupied_);
+  std::swap(written_, nextWritten_);
+}
+
+} // namespace PIC_REAL
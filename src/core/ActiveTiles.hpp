@@ -0,0 +1,124 @@
+#pragma once
+#include "Grid2D.hpp"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @file ActiveTiles.hpp
+ * @brief Occupied tiles of a mostly empty, double-buffered cell grid.
+ */
+
+namespace PIC_REAL {
+
+/**
+ * @brief Tracks which @c tile × @c tile blocks of a double-buffered grid
+ *        (the smoke and its back-buffer) hold matter, so that advection
+ *        only visits those and a band around them.
+ *
+ * Two kinds of marks are kept for each buffer:
+ *  - occupancy, per row and tile column: the row segment may hold a value
+ *    above the threshold. Advection records it for every segment it
+ *    writes, and sources mark the cells they set, so the grid is never
+ *    scanned after the first step;
+ *  - written tiles: the tile may hold any non-zero value. The buffer is
+ *    zero outside them.
+ *
+ * A step then runs
+ * ```
+ *   Update(grid, threshold, reach)   occupied tiles dilated by reach cells
+ *                                    -> Active(); back-buffer tiles written
+ *                                    earlier but no longer active
+ *                                    -> Cleared()
+ *   per row j of the back-buffer:    compute the Active() tiles, zero the
+ *                                    Cleared() ones, SetNextOccupied()
+ *   Swap()                           with the grid buffers
+ * ```
+ * A cell outside the active tiles has its whole interpolation stencil more
+ * than @p reach cells away from any occupied tile, so it would only
+ * receive values at or below the threshold: it is left at zero.
+ *
+ * A default-constructed object is disabled (@c enabled() is false).
+ */
+class ActiveTiles {
+public:
+  ActiveTiles() = default;
+
+  /**
+   * @brief Track an @p nx × @p ny grid in tiles of @p tile cells.
+   *
+   * Every tile counts as written until the first @c Update(), which scans
+   * the grid once.
+   */
+  ActiveTiles(int nx, int ny, int tile);
+
+  /// @return @c true if tiles are tracked.
+  [[nodiscard]] bool enabled() const { return tile_ > 0; }
+
+  [[nodiscard]] int tile() const { return tile_; }     ///< Tile edge.
+  [[nodiscard]] int tilesX() const { return tilesX_; } ///< Tiles along x.
+  [[nodiscard]] int tilesY() const { return tilesY_; } ///< Tiles along y.
+
+  /**
+   * @brief Mark cells [@p i0, @p i1) × [@p j0, @p j1) of the current buffer
+   *        as occupied, after they were set from outside (sources). No-op
+   *        when disabled; clamped to the grid.
+   */
+  void MarkCells(int i0, int i1, int j0, int j1);
+
+  /// @brief Forget the marks: the next @c Update() scans the grid again
+  ///        (after the grid was overwritten, e.g. restored).
+  void Invalidate() { valid_ = false; }
+
+  /**
+   * @brief Select the tiles to advect this step.
+   * @param grid      Current buffer (scanned only after @c Invalidate()).
+   * @param threshold Values at or below it do not occupy a cell.
+   * @param reach     Cells a departure point and its interpolation stencil
+   *                  may lie away from the cell that is traced.
+   */
+  void Update(const SmokeGrid2D &grid, varType threshold, int reach);
+
+  /// @return @c true if tile (@p ti, @p tj) is advected this step.
+  [[nodiscard]] bool Active(int ti, int tj) const {
+    return active_[idx(ti, tj)] != 0;
+  }
+
+  /// @return @c true if tile (@p ti, @p tj) of the back-buffer must be
+  ///         zeroed this step.
+  [[nodiscard]] bool Cleared(int ti, int tj) const {
+    return cleared_[idx(ti, tj)] != 0;
+  }
+
+  /// @brief Record whether the segment of tile column @p ti in row @p j of
+  ///        the back-buffer is occupied. Rows may be set concurrently.
+  void SetNextOccupied(int j, int ti, bool occupied) {
+    nextOccupied_[static_cast<std::size_t>(tilesX_) * j + ti] = occupied;
+  }
+
+  /// @brief Follow a swap of the grid and its back-buffer.
+  void Swap();
+
+  /// @return Tiles selected by the last @c Update().
+  [[nodiscard]] std::size_t ActiveCount() const { return activeCount_; }
+
+private:
+  int nx_ = 0, ny_ = 0;                  ///< Grid size in cells.
+  int tile_ = 0;                         ///< Tile edge, 0 = disabled.
+  int tilesX_ = 0, tilesY_ = 0;          ///< Tiles along x and y.
+  bool valid_ = false;                   ///< Occupancy matches the grid.
+  std::size_t activeCount_ = 0;          ///< Tiles active this step.
+  std::vector<uint8_t> occupied_;        ///< ny × tilesX, current buffer.
+  std::vector<uint8_t> nextOccupied_;    ///< ny × tilesX, back-buffer.
+  std::vector<uint8_t> written_;         ///< Tiles, current buffer.
+  std::vector<uint8_t> nextWritten_;     ///< Tiles, back-buffer.
+  std::vector<uint8_t> active_;          ///< Tiles advected this step.
+  std::vector<uint8_t> cleared_;         ///< Back-buffer tiles to zero.
+
+  /// @brief Flat index of tile (ti, tj), row-major.
+  [[nodiscard]] std::size_t idx(int ti, int tj) const {
+    return static_cast<std::size_t>(tilesX_) * tj + ti;
+  }
+};
+
+} // namespace PIC_REAL
@@ -0,0 +1,92 @@
+#include "AsyncOutput.hpp"
+#include <algorithm>
+#include <exception>
+#include <iostream>
+
+namespace PIC_REAL {
+
+AsyncOutput::AsyncOutput(const int threads, const int maxBuffers)
+    : maxBuffers_(std::max(1, maxBuffers)) {
+  const int n = std::max(1, threads);
+  workers_.reserve(n);
+  for (int t = 0; t < n; ++t)
+    workers_.emplace_back(&AsyncOutput::run, this);
+}
+
+AsyncOutput::~AsyncOutput() {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    stop_ = true;
+  }
+  workReady_.notify_all();
+  for (std::thread &w : workers_)
+    w.join();
+}
+
+AsyncOutput::Buffer AsyncOutput::acquire() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  if (inFlight_ >= maxBuffers_) {
+    // Back-pressure: the writers are behind, wait for a buffer to return.
+    const double start = GET_TIME();
+    slotFree_.wait(lock, [this] { return inFlight_ < maxBuffers_; });
+    stall_ += GET_TIME() - start;
+  }
+  ++inFlight_;
+
+  if (free_.empty())
+    return {};
+  Buffer buffer = std::move(free_.back());
+  free_.pop_back();
+  return buffer;
+}
+
+void AsyncOutput::submit(Buffer buffer, Job job) {
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    queue_.push_back({std::move(buffer), std::move(job)});
+  }
+  workReady_.notify_one();
+}
+
+bool AsyncOutput::flush() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  idle_.wait(lock, [this] { return queue_.empty() && busy_ == 0; });
+  return !failed_;
+}
+
+double AsyncOutput::stallTime() const {
+  std::lock_guard<std::mutex> lock(mutex_);
+  return stall_;
+}
+
+void AsyncOutput::run() {
+  std::unique_lock<std::mutex> lock(mutex_);
+  for (;;) {
+    workReady_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+    if (queue_.empty())
+      return; // stopping, and every queued frame has been taken
+
+    Task task = std::move(queue_.front());
+    queue_.pop_front();
+    ++busy_;
+    lock.unlock();
+
+    bool ok = false;
+    try {
+      ok = task.job(task.buffer);
+    } catch (const std::exception &e) {
+      std::cerr << "[AsyncOutput] " << e.what() << '\n';
+    }
+
+    lock.lock();
+    failed_ |= !ok;
+    --busy_;
+    --inFlight_;
+    free_.push_back(std::move(task.buffer));
+    slotFree_.notify_one();
+    if (queue_.empty() && busy_ == 0)
+      idle_.notify_all();
+  }
+}
+
+} // namespace PIC_REAL
@@ -0,0 +1,107 @@
+#pragma once
+#include "Precision.hpp"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @file AsyncOutput.hpp
+ * @brief Background I/O threads with a bounded pool of snapshot buffers.
+ */
+
+namespace PIC_REAL {
+
+/**
+ * @brief Runs output jobs (encode + write one frame) on background threads.
+ *
+ * The simulation thread copies each field into a snapshot buffer taken from
+ * a fixed-size pool (@c acquire()) and hands buffer and job over with
+ * @c submit(); it then continues with the next time step while the workers
+ * compress and write. Finished buffers return to the pool with their
+ * capacity intact, so steady-state output allocates nothing.
+ *
+ * ### Back-pressure
+ * At most @c maxBuffers snapshots exist at any time. When the disk falls
+ * behind, @c acquire() blocks until a worker releases one, which bounds the
+ * memory held by queued frames; the time spent waiting is reported by
+ * @c stallTime().
+ *
+ * Jobs run in submission order but complete in any order; each one must
+ * only touch its own file.
+ */
+class AsyncOutput {
+public:
+  using Buffer = std::vector<varType>; ///< One snapshot (row-major values).
+  /// Writes one snapshot; returns @c false on failure.
+  using Job = std::function<bool(const Buffer &)>;
+
+  /**
+   * @brief Start the worker threads.
+   * @param threads    Number of I/O threads (at least 1).
+   * @param maxBuffers Snapshots allowed in flight (at least 1).
+   */
+  AsyncOutput(int threads, int maxBuffers);
+
+  /// Writes every queued frame, then joins the workers.
+  ~AsyncOutput();
+
+  AsyncOutput(const AsyncOutput &) = delete;
+  AsyncOutput &operator=(const AsyncOutput &) = delete;
+
+  /**
+   * @brief Take a snapshot buffer from the pool, blocking while all
+   *        @c maxBuffers are queued or being written.
+   * @return A recycled buffer (size unspecified, resize before use).
+   */
+  [[nodiscard]] Buffer acquire();
+
+  /**
+   * @brief Queue @p job on @p buffer; the buffer returns to the pool once
+   *        the job has run.
+   * @param buffer Snapshot obtained from @c acquire().
+   * @param job    Work to run on a background thread.
+   */
+  void submit(Buffer buffer, Job job);
+
+  /**
+   * @brief Block until every submitted job has finished.
+   * @return @c false if any job has failed (or thrown) so far. The failure
+   *         stays reported to every later caller, so each writer sharing
+   *         the queue and the end of the run see it.
+   */
+  bool flush();
+
+  /// @return Seconds the caller spent blocked in @c acquire() so far.
+  [[nodiscard]] double stallTime() const;
+
+private:
+  /// Queued unit of work.
+  struct Task {
+    Buffer buffer;
+    Job job;
+  };
+
+  mutable std::mutex mutex_;
+  std::condition_variable workReady_; ///< Queue non-empty, or stopping.
+  std::condition_variable slotFree_;  ///< A buffer returned to the pool.
+  std::condition_variable idle_;      ///< Queue drained, no job running.
+
+  std::deque<Task> queue_;    ///< Submitted, not yet started.
+  std::vector<Buffer> free_;  ///< Released buffers ready for reuse.
+  int maxBuffers_;            ///< Pool size.
+  int inFlight_ = 0;          ///< Buffers handed out and not yet released.
+  int busy_ = 0;              ///< Jobs currently running.
+  bool failed_ = false;       ///< A job has failed (kept until shutdown).
+  bool stop_ = false;         ///< Set by the destructor.
+  double stall_ = 0.0;        ///< Accumulated wait in acquire().
+
+  std::vector<std::thread> workers_;
+
+  /// Worker loop: pop, run, release, until stopped and drained.
+  void run();
+};
+
+} // namespace PIC_REAL
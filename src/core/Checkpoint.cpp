@@ -0,0 +1,207 @@
+#include "Checkpoint.hpp"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <system_error>
+
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#define CHECKPOINT_POSIX
+#endif
+
+namespace fs = std::filesystem;
+
+namespace {
+
+/// @return @p offset rounded up to the next payload boundary.
+std::size_t alignUp(const std::size_t offset) {
+  return (offset + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT *
+         CHECKPOINT_ALIGNMENT;
+}
+
+} // namespace
+
+// CheckpointWriter
+
+CheckpointWriter::CheckpointWriter(const CheckpointHeader &header)
+    : header_(header) {}
+
+void CheckpointWriter::add(const std::string &name, const void *data,
+                           const std::size_t bytes) {
+  entries_.push_back({name, data, bytes});
+}
+
+bool CheckpointWriter::write(const std::string &path) {
+  header_.numSections = static_cast<uint32_t>(entries_.size());
+
+  // Section table, with every payload on an aligned offset.
+  std::vector<CheckpointSection> table(entries_.size());
+  std::size_t offset = alignUp(sizeof(CheckpointHeader) +
+                               table.size() * sizeof(CheckpointSection));
+  for (std::size_t s = 0; s < entries_.size(); ++s) {
+    const std::string &name = entries_[s].name;
+    std::memcpy(table[s].name, name.data(),
+                std::min(name.size(), sizeof(table[s].name) - 1));
+    table[s].offset = offset;
+    table[s].bytes = entries_[s].bytes;
+    offset = alignUp(offset + entries_[s].bytes);
+  }
+
+  const std::string tmp = path + ".tmp";
+  std::FILE *out = std::fopen(tmp.c_str(), "wb");
+  if (!out) {
+    std::cerr << "[Checkpoint] Could not open '" << tmp << "'\n";
+    return false;
+  }
+
+  static const unsigned char zeros[CHECKPOINT_ALIGNMENT] = {};
+  std::size_t written = 0;
+  auto put = [&](const void *data, const std::size_t bytes) {
+    written += std::fwrite(data, 1, bytes, out);
+  };
+  auto padTo = [&](const std::size_t target) {
+    put(zeros, target - written);
+  };
+
+  put(&header_, sizeof(header_));
+  put(table.data(), table.size() * sizeof(CheckpointSection));
+  std::size_t expected = written;
+  for (std::size_t s = 0; s < entries_.size(); ++s) {
+    padTo(table[s].offset);
+    put(entries_[s].data, entries_[s].bytes);
+    expected = table[s].offset + table[s].bytes;
+  }
+
+  bool ok = written == expected && std::fflush(out) == 0;
+#ifdef CHECKPOINT_POSIX
+  // The rename below must not reach the disk before the data does.
+  ok = ok && ::fsync(::fileno(out)) == 0;
+#endif
+  ok = (std::fclose(out) == 0) && ok;
+
+  std::error_code ec;
+  if (ok)
+    fs::rename(tmp, path, ec);
+  if (!ok || ec) {
+    std::cerr << "[Checkpoint] Failed to write '" << path << "'\n";
+    fs::remove(tmp, ec);
+    return false;
+  }
+  return true;
+}
+
+// CheckpointReader
+
+CheckpointReader::~CheckpointReader() { close(); }
+
+void CheckpointReader::close() {
+#ifdef CHECKPOINT_POSIX
+  if (mapped_)
+    ::munmap(const_cast<unsigned char *>(base_), size_);
+#endif
+  base_ = nullptr;
+  size_ = 0;
+  mapped_ = false;
+  contents_.clear();
+  sections_.clear();
+}
+
+bool CheckpointReader::open(const std::string &path) {
+  close();
+
+#ifdef CHECKPOINT_POSIX
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd >= 0) {
+    struct stat st {};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+      void *map = ::mmap(nullptr, static_cast<std::size_t>(st.st_size),
+                         PROT_READ, MAP_PRIVATE, fd, 0);
+      if (map != MAP_FAILED) {
+        base_ = static_cast<const unsigned char *>(map);
+        size_ = static_cast<std::size_t>(st.st_size);
+        mapped_ = true;
+      }
+    }
+    ::close(fd); // the mapping stays valid
+  }
+#else
+  std::ifstream in(path, std::ios::binary);
+  if (in) {
+    contents_.assign(std::istreambuf_iterator<char>(in),
+                     std::istreambuf_iterator<char>());
+    base_ = contents_.data();
+    size_ = contents_.size();
+  }
+#endif
+  if (!base_) {
+    std::cerr << "[Checkpoint] Could not open '" << path << "'\n";
+    return false;
+  }
+
+  const CheckpointHeader expected;
+  if (size_ < sizeof(CheckpointHeader)) {
+    std::cerr << "[Checkpoint] '" << path << "' is truncated\n";
+    close();
+    return false;
+  }
+  std::memcpy(&header_, base_, sizeof(header_));
+  if (std::memcmp(header_.magic, expected.magic, sizeof(expected.magic)) !=
+          0 ||
+      header_.version != CHECKPOINT_VERSION) {
+    std::cerr << "[Checkpoint] '" << path
+              << "' is not a checkpoint of format version "
+              << CHECKPOINT_VERSION << '\n';
+    close();
+    return false;
+  }
+
+  const std::size_t tableEnd = sizeof(CheckpointHeader) +
+                               std::size_t{header_.numSections} *
+                                   sizeof(CheckpointSection);
+  if (size_ < tableEnd) {
+    std::cerr << "[Checkpoint] '" << path << "' is truncated\n";
+    close();
+    return false;
+  }
+  sections_.resize(header_.numSections);
+  std::memcpy(sections_.data(), base_ + sizeof(CheckpointHeader),
+              sections_.size() * sizeof(CheckpointSection));
+  for (CheckpointSection &s : sections_) {
+    s.name[sizeof(s.name) - 1] = '\0';
+    if (s.offset > size_ || s.bytes > size_ - s.offset) {
+      std::cerr << "[Checkpoint] '" << path << "': section '" << s.name
+                << "' lies beyond the end of the file\n";
+      close();
+      return false;
+    }
+  }
+  return true;
+}
+
+std::pair<const void *, std::size_t>
+CheckpointReader::section(const std::string &name) const {
+  for (const CheckpointSection &s : sections_)
+    if (name == s.name)
+      return {base_ + s.offset, static_cast<std::size_t>(s.bytes)};
+  return {nullptr, 0};
+}
+
+bool CheckpointReader::copy(const std::string &name, void *dst,
+                            const std::size_t bytes) const {
+  const auto [data, size] = section(name);
+  if (!data || size != bytes) {
+    std::cerr << "[Checkpoint] Section '" << name << "' is missing or has "
+              << size << " bytes instead of " << bytes << '\n';
+    return false;
+  }
+  if (bytes > 0)
+    std::memcpy(dst, data, bytes);
+  return true;
+}
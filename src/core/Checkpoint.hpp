@@ -0,0 +1,160 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @file Checkpoint.hpp
+ * @brief Binary checkpoint files: atomic writes, memory-mapped reads.
+ */
+
+/// Current checkpoint format version (bumped on incompatible changes).
+constexpr uint32_t CHECKPOINT_VERSION = 1;
+
+/// Alignment of every section payload inside the file, in bytes.
+constexpr std::size_t CHECKPOINT_ALIGNMENT = 64;
+
+/**
+ * @brief Fixed-size header at the start of a checkpoint file.
+ *
+ * All values are stored in host byte order; a checkpoint is meant to be
+ * reloaded on the machine (or cluster) that wrote it.
+ */
+struct CheckpointHeader {
+  char magic[8] = {'P', 'I', 'C', 'C', 'K', 'P', 'T', '\0'}; ///< File tag.
+  uint32_t version = CHECKPOINT_VERSION; ///< Format version.
+  uint32_t realBytes = 0;   ///< sizeof(varType) of the writing run (4 or 8).
+  int32_t nx = 0;           ///< Pressure cells in x.
+  int32_t ny = 0;           ///< Pressure cells in y.
+  int64_t step = 0;         ///< Last completed time step.
+  double time = 0.0;        ///< Simulated time at @c step.
+  uint64_t paramHash = 0;   ///< @c Parameters::configHash of the run.
+  uint32_t numSections = 0; ///< Entries in the section table.
+  uint32_t reserved = 0;    ///< Padding, written as 0.
+};
+
+/**
+ * @brief Entry of the section table that follows the header.
+ */
+struct CheckpointSection {
+  char name[24] = {}; ///< Null-terminated section name.
+  uint64_t offset = 0; ///< Payload start from the file start (aligned).
+  uint64_t bytes = 0;  ///< Payload size.
+};
+
+/**
+ * @brief Collects named byte ranges and writes them as one checkpoint.
+ *
+ * ### File layout
+ * ```
+ *   CheckpointHeader
+ *   CheckpointSection[numSections]
+ *   payloads, each starting at a multiple of CHECKPOINT_ALIGNMENT
+ * ```
+ * Sections only reference the caller's memory, which must stay unchanged
+ * until @c write() returns.
+ *
+ * The file is written next to its destination as @c "<path>.tmp", flushed
+ * to disk and renamed over @p path, so an interrupted write never replaces
+ * the previous checkpoint with a truncated one.
+ */
+class CheckpointWriter {
+public:
+  /// @param header Header to write; @c numSections is filled in.
+  explicit CheckpointWriter(const CheckpointHeader &header);
+
+  /**
+   * @brief Add a section.
+   * @param name  Section name (at most 23 characters, unique).
+   * @param data  First byte of the payload.
+   * @param bytes Payload size.
+   */
+  void add(const std::string &name, const void *data, std::size_t bytes);
+
+  /// @brief Add the contents of @p values as a section.
+  template <typename T, typename Alloc>
+  void add(const std::string &name, const std::vector<T, Alloc> &values) {
+    add(name, values.data(), values.size() * sizeof(T));
+  }
+
+  /**
+   * @brief Write the checkpoint atomically (temp file + rename).
+   * @param path Destination file.
+   * @return @c true on success; on failure @p path is left untouched.
+   */
+  bool write(const std::string &path);
+
+private:
+  /// Caller-owned payload of one section.
+  struct Entry {
+    std::string name;
+    const void *data;
+    std::size_t bytes;
+  };
+
+  CheckpointHeader header_;
+  std::vector<Entry> entries_;
+};
+
+/**
+ * @brief Read-only view of a checkpoint file.
+ *
+ * The file is memory-mapped where POSIX @c mmap is available (read in
+ * full otherwise), so opening a checkpoint costs one system call and the
+ * payloads are paged in only as they are copied out.
+ */
+class CheckpointReader {
+public:
+  CheckpointReader() = default;
+  ~CheckpointReader();
+
+  CheckpointReader(const CheckpointReader &) = delete;
+  CheckpointReader &operator=(const CheckpointReader &) = delete;
+
+  /**
+   * @brief Map @p path and validate its header and section table.
+   * @return @c false (with a message on stderr) if the file cannot be
+   *         opened or is not a checkpoint of this format version.
+   */
+  bool open(const std::string &path);
+
+  /// @return The header of the open file.
+  [[nodiscard]] const CheckpointHeader &header() const { return header_; }
+
+  /**
+   * @brief Locate a section.
+   * @return Payload pointer and size, or {nullptr, 0} if there is no
+   *         section called @p name.
+   */
+  [[nodiscard]] std::pair<const void *, std::size_t>
+  section(const std::string &name) const;
+
+  /**
+   * @brief Copy section @p name into @p dst.
+   * @param name  Section name.
+   * @param dst   Destination of @p count values.
+   * @param count Values expected in the section.
+   * @return @c false if the section is missing or holds a different size.
+   */
+  template <typename T>
+  bool read(const std::string &name, T *dst, std::size_t count) const {
+    return copy(name, dst, count * sizeof(T));
+  }
+
+private:
+  const unsigned char *base_ = nullptr; ///< Start of the file contents.
+  std::size_t size_ = 0;                ///< File size in bytes.
+  bool mapped_ = false;                 ///< @c base_ is an mmap region.
+  std::vector<unsigned char> contents_; ///< File contents without mmap.
+
+  CheckpointHeader header_;
+  std::vector<CheckpointSection> sections_;
+
+  /// @brief Copy @p bytes of section @p name, which must be that large.
+  bool copy(const std::string &name, void *dst, std::size_t bytes) const;
+
+  /// @brief Unmap / release the current file.
+  void close();
+};
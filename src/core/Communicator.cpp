@@ -0,0 +1,106 @@
+#include "Communicator.hpp"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#ifdef USE_MPI
+#include <climits>
+#include <mpi.h>
+#endif
+
+// LocalHub
+
+LocalHub::LocalHub(const int ranks)
+    : ranks_(ranks), values_(static_cast<std::size_t>(ranks), 0.0),
+      pending_(ranks) {}
+
+void LocalHub::send(const int from, const int to, const int tag,
+                    const void *data, const std::size_t bytes) {
+  const auto *begin = static_cast<const unsigned char *>(data);
+  std::vector<unsigned char> message(begin, begin + bytes);
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    mailboxes_[{from, to, tag}].push_back(std::move(message));
+  }
+  arrived_.notify_all();
+}
+
+void LocalHub::receive(const int from, const int to, const int tag,
+                       void *data, const std::size_t bytes) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  std::deque<std::vector<unsigned char>> &box = mailboxes_[{from, to, tag}];
+  arrived_.wait(lock, [&box] { return !box.empty(); });
+  const std::vector<unsigned char> &message = box.front();
+  if (message.size() != bytes)
+    throw std::runtime_error("LocalHub: message size mismatch");
+  std::memcpy(data, message.data(), bytes);
+  box.pop_front();
+}
+
+double LocalHub::allReduce(const int rank, const double value,
+                           const bool max) {
+  std::unique_lock<std::mutex> lock(mutex_);
+  values_[rank] = value;
+  if (--pending_ == 0) {
+    // Last to arrive: combine in rank order and release the others. None of
+    // them can join the next reduction before reading result_.
+    double r = values_[0];
+    for (int k = 1; k < ranks_; ++k)
+      r = max ? std::max(r, values_[k]) : r + values_[k];
+    result_ = r;
+    pending_ = ranks_;
+    ++generation_;
+    arrived_.notify_all();
+    return r;
+  }
+  const uint64_t generation = generation_;
+  arrived_.wait(lock, [&] { return generation_ != generation; });
+  return result_;
+}
+
+// LocalCommunicator
+
+void LocalCommunicator::sendRecv(const void *send, const std::size_t sendBytes,
+                                 const int dest, void *recv,
+                                 const std::size_t recvBytes, const int source,
+                                 const int tag) {
+  // Sends are buffered, so sending first cannot deadlock.
+  if (dest >= 0)
+    hub_.send(rank_, dest, tag, send, sendBytes);
+  if (source >= 0)
+    hub_.receive(source, rank_, tag, recv, recvBytes);
+}
+
+// MpiCommunicator
+
+#ifdef USE_MPI
+MpiCommunicator::MpiCommunicator() {
+  MPI_Comm_rank(MPI_COMM_WORLD, &rank_);
+  MPI_Comm_size(MPI_COMM_WORLD, &size_);
+}
+
+void MpiCommunicator::sendRecv(const void *send, const std::size_t sendBytes,
+                               const int dest, void *recv,
+                               const std::size_t recvBytes, const int source,
+                               const int tag) {
+  if (sendBytes > INT_MAX || recvBytes > INT_MAX)
+    throw std::runtime_error("MpiCommunicator: message over 2 GiB");
+  MPI_Sendrecv(send, static_cast<int>(sendBytes), MPI_BYTE,
+               dest >= 0 ? dest : MPI_PROC_NULL, tag, recv,
+               static_cast<int>(recvBytes), MPI_BYTE,
+               source >= 0 ? source : MPI_PROC_NULL, tag, MPI_COMM_WORLD,
+               MPI_STATUS_IGNORE);
+}
+
+double MpiCommunicator::allReduceSum(const double value) {
+  double result = 0.0;
+  MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_SUM, MPI_COMM_WORLD);
+  return result;
+}
+
+double MpiCommunicator::allReduceMax(const double value) {
+  double result = 0.0;
+  MPI_Allreduce(&value, &result, 1, MPI_DOUBLE, MPI_MAX, MPI_COMM_WORLD);
+  return result;
+}
+#endif
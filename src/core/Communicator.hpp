@@ -0,0 +1,136 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <tuple>
+#include <vector>
+
+/**
+ * @file Communicator.hpp
+ * @brief Message passing between the ranks of a distributed run.
+ */
+
+/**
+ * @brief Point-to-point and collective operations of one rank.
+ *
+ * The distributed solver only needs a blocking neighbour exchange and two
+ * reductions, so every backend implements exactly these: @c MpiCommunicator
+ * when MPI is available, and @c LocalCommunicator, which runs the ranks as
+ * threads of one process and is meant for testing on one machine.
+ */
+class Communicator {
+public:
+  virtual ~Communicator() = default;
+
+  /// @return This rank, in [0, size()).
+  [[nodiscard]] virtual int rank() const = 0;
+
+  /// @return Number of ranks.
+  [[nodiscard]] virtual int size() const = 0;
+
+  /**
+   * @brief Send to one rank and receive from another in one call, without
+   *        deadlocking when every rank does the same (like MPI_Sendrecv).
+   *
+   * @param send      Bytes to send.
+   * @param sendBytes Number of bytes to send.
+   * @param dest      Destination rank; negative to send nothing.
+   * @param recv      Receive buffer.
+   * @param recvBytes Number of bytes expected.
+   * @param source    Source rank; negative to receive nothing.
+   * @param tag       Message tag; matches sends and receives pairwise.
+   */
+  virtual void sendRecv(const void *send, std::size_t sendBytes, int dest,
+                        void *recv, std::size_t recvBytes, int source,
+                        int tag) = 0;
+
+  /// @return Sum of @p value over all ranks (the same on every rank).
+  [[nodiscard]] virtual double allReduceSum(double value) = 0;
+
+  /// @return Maximum of @p value over all ranks (the same on every rank).
+  [[nodiscard]] virtual double allReduceMax(double value) = 0;
+};
+
+/**
+ * @brief Shared mailboxes and reduction slots of the ranks of one process.
+ *
+ * Sends are buffered, so a send never waits for its receive; a receive
+ * blocks until a message with its (source, destination, tag) arrives.
+ * Reductions combine the values in rank order, so every rank gets the same
+ * bits whatever order the ranks arrive in.
+ */
+class LocalHub {
+public:
+  /// @param ranks Number of ranks sharing the hub.
+  explicit LocalHub(int ranks);
+
+  /// @return Number of ranks.
+  [[nodiscard]] int size() const { return ranks_; }
+
+  /// @brief Queue @p bytes bytes from @p from to @p to.
+  void send(int from, int to, int tag, const void *data, std::size_t bytes);
+
+  /// @brief Wait for and dequeue the next message from @p from to @p to.
+  void receive(int from, int to, int tag, void *data, std::size_t bytes);
+
+  /// @brief Sum (or maximum, with @p max) of @p value over all ranks.
+  double allReduce(int rank, double value, bool max);
+
+private:
+  using Key = std::tuple<int, int, int>; ///< (from, to, tag).
+
+  int ranks_;
+  std::mutex mutex_;
+  std::condition_variable arrived_;
+  std::map<Key, std::deque<std::vector<unsigned char>>> mailboxes_;
+
+  std::vector<double> values_; ///< Contribution of every rank.
+  int pending_ = 0;            ///< Ranks still to join this reduction.
+  uint64_t generation_ = 0;    ///< Completed reductions.
+  double result_ = 0.0;        ///< Result of the last reduction.
+};
+
+/// @brief Rank of a run whose ranks are threads sharing a @c LocalHub.
+class LocalCommunicator : public Communicator {
+public:
+  /// @param hub  Hub of the run (non-owning, must outlive this object).
+  /// @param rank This rank.
+  LocalCommunicator(LocalHub &hub, int rank) : hub_(hub), rank_(rank) {}
+
+  [[nodiscard]] int rank() const override { return rank_; }
+  [[nodiscard]] int size() const override { return hub_.size(); }
+  void sendRecv(const void *send, std::size_t sendBytes, int dest, void *recv,
+                std::size_t recvBytes, int source, int tag) override;
+  [[nodiscard]] double allReduceSum(double value) override {
+    return hub_.allReduce(rank_, value, false);
+  }
+  [[nodiscard]] double allReduceMax(double value) override {
+    return hub_.allReduce(rank_, value, true);
+  }
+
+private:
+  LocalHub &hub_;
+  int rank_;
+};
+
+#ifdef USE_MPI
+/// @brief Rank of an MPI run (MPI_COMM_WORLD, initialised by the caller).
+class MpiCommunicator : public Communicator {
+public:
+  MpiCommunicator();
+
+  [[nodiscard]] int rank() const override { return rank_; }
+  [[nodiscard]] int size() const override { return size_; }
+  void sendRecv(const void *send, std::size_t sendBytes, int dest, void *recv,
+                std::size_t recvBytes, int source, int tag) override;
+  [[nodiscard]] double allReduceSum(double value) override;
+  [[nodiscard]] double allReduceMax(double value) override;
+
+private:
+  int rank_ = 0;
+  int size_ = 1;
+};
+#endif
@@ -1,8 +1,11 @@
 #include "Fields.hpp"
+#include <algorithm>
 #include <cmath>
 
-void Fields2D::Div() {
-  for (int j = 0; j < ny; j++) {
+namespace PIC_REAL {
+
+void Fields2D::Div(const int j0, const int j1) {
+  for (int j = j0; j < j1; j++) {
     for (int i = 0; i < nx; i++) {
       const varType dudx = (u.Get(i + 1, j) - u.Get(i, j)) / dx;
       const varType dvdy = (v.Get(i, j + 1) - v.Get(i, j)) / dy;
@@ -11,11 +14,11 @@ void Fields2D::Div() {
   }
 }
 
-void Fields2D::VelocityNormCenterGrid() {
+void Fields2D::VelocityNormCenterGrid(const int j0, const int j1) {
   // Interpolate u and v from their staggered positions to cell centres, then
   // store the magnitude. The loop stops at nx-1 / ny-1 because the
   // cell-centre sample point (i + 0.5)*dx requires one ghost layer.
-  for (int j = 0; j < ny - 1; j++) {
+  for (int j = j0; j < std::min(j1, ny - 1); j++) {
     for (int i = 0; i < nx - 1; i++) {
       const varType x = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
       const varType y = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
@@ -53,3 +56,5 @@ void Fields2D::SolidBorders() {
     SetLabel(nx - 1, j, SOLID);
   }
 }
+
+} // namespace PIC_REAL
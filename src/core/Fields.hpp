@@ -1,6 +1,8 @@
 #pragma once
+#include "ActiveTiles.hpp"
 #include "Grid2D.hpp"
 #include <cstdint>
+#include <utility>
 #include <vector>
 
 /**
@@ -8,6 +10,8 @@
  * @brief Physical fields for a 2-D incompressible simulation on a MAC grid.
  */
 
+namespace PIC_REAL {
+
 /**
  * @brief All physical fields for a 2-D incompressible Navier-Stokes solver
  *        on a staggered (MAC / Marker-And-Cell) grid.
@@ -22,6 +26,20 @@
  * | @c normVelocity | (nx-1) × (ny-1)      | cell centres (diagnostic)   |
  * | @c smokeMap | (nx-1) × (ny-1)      | cell centres (diagnostic)   |
  *
+ * @c uNext, @c vNext and @c smokeNext are persistent back-buffers with the
+ * shapes of @c u, @c v and @c smokeMap. Advection writes the new values into
+ * them and then swaps, so no grid is allocated inside the time loop.
+ * With sparse smoke, @c smokeTiles tracks the tiles of both smoke buffers
+ * that hold smoke and swaps with them.
+ *
+ * The smoke grids use the configure-time @c SmokeLayout (row-major unless
+ * PIC_SMOKE_LAYOUT selects tiles); every other grid is row-major or padded.
+ *
+ * @c p and @c div share one padded layout with a one-cell ghost ring that
+ * stays zero: the pressure kernels read the four neighbours of a cell at
+ * fixed offsets (±1, ±stride), and a neighbour outside the domain adds
+ * nothing, without a bounds test. Only the interior is ever written.
+ *
  * Cell labels (FLUID / SOLID) are stored in a separate flat array and
  * accessed via @c Label() / @c SetLabel().
  */
@@ -42,17 +60,30 @@ public:
 
   Grid2D u;   ///< x-velocity, staggered: (nx+1) × ny.
   Grid2D v;   ///< y-velocity, staggered: nx × (ny+1).
-  Grid2D p;   ///< Pressure,   cell-centred: nx × ny.
-  Grid2D div; ///< Velocity divergence \f$ \nabla \cdot \mathbf{u} \f$
-              ///< (diagnostic): \f$ n_x \times n_y \f$.
+  PaddedGrid2D<1> p;   ///< Pressure,   cell-centred: nx × ny.
+  PaddedGrid2D<1> div; ///< Velocity divergence \f$ \nabla \cdot
+                       ///< \mathbf{u} \f$ (diagnostic): \f$ n_x \times n_y \f$.
   Grid2D
       normVelocity; ///< |u| interpolated to cell centres (diagnostic): nx × ny.
-  Grid2D smokeMap;  ///< smoke matter in each cell centres
+  SmokeGrid2D smokeMap; ///< smoke matter in each cell centres
+
+  Grid2D uNext;          ///< Back-buffer for @c u (advection target).
+  Grid2D vNext;          ///< Back-buffer for @c v (advection target).
+  SmokeGrid2D smokeNext; ///< Back-buffer for @c smokeMap (advection target).
 
   /// Velocity imposed on SOLID cells (0 = no-slip). Reserved for moving
   /// boundaries in future work.
   varType usolid = REAL_LITERAL(0.0);
 
+  /// Row of the whole domain that local row 0 holds: non-zero for the slab
+  /// of one rank of a distributed run, whose grids cover only its own rows
+  /// and halo. Scene objects place themselves in whole-domain rows.
+  int rowOffset = 0;
+
+  /// Occupied tiles of @c smokeMap and @c smokeNext (sparse smoke only,
+  /// disabled otherwise). Whoever sets smoke cells directly marks them.
+  ActiveTiles smokeTiles;
+
   /**
    * @brief Construct all fields and zero-initialise them.
    * @param nx      Number of pressure cells in x.
@@ -65,7 +96,8 @@ public:
   Fields2D(int nx, int ny, varType density, varType dt, varType dx, varType dy)
       : nx(nx), ny(ny), density(density), dt(dt), dx(dx), dy(dy), u(nx + 1, ny),
         v(nx, ny + 1), p(nx, ny), div(nx, ny), normVelocity(nx - 1, ny - 1),
-        smokeMap(nx - 1, ny - 1),
+        smokeMap(nx - 1, ny - 1), uNext(nx + 1, ny), vNext(nx, ny + 1),
+        smokeNext(nx - 1, ny - 1),
         labels(static_cast<std::size_t>(nx) * ny, FLUID) {}
 
   // Cell label accessors
@@ -85,7 +117,45 @@ public:
    * @param t New cell type.
    */
   void SetLabel(int i, int j, CellType t) {
-    labels[idx(i, j)] = static_cast<uint8_t>(t);
+    uint8_t &cell = labels[idx(i, j)];
+    if (cell != static_cast<uint8_t>(t)) {
+      cell = static_cast<uint8_t>(t);
+      ++labelsVersion;
+    }
+  }
+
+  /**
+   * @brief Counter bumped every time a cell actually changes type.
+   *
+   * Solvers that cache geometry-dependent data (preconditioners, stencils)
+   * compare this value against the one they were built with, so re-applying
+   * an unchanged solid mask every step does not trigger a rebuild.
+   */
+  [[nodiscard]] uint64_t LabelsVersion() const { return labelsVersion; }
+
+  /// @return All nx × ny labels, row-major (for checkpoints).
+  [[nodiscard]] const std::vector<uint8_t> &Labels() const { return labels; }
+
+  /**
+   * @brief Replace every label at once (restart from a checkpoint).
+   * @param src nx × ny labels, row-major.
+   */
+  void AssignLabels(const uint8_t *src) {
+    std::copy(src, src + labels.size(), labels.begin());
+    ++labelsVersion;
+  }
+
+  // Buffer swaps
+  /// @brief Make @c uNext / @c vNext the current velocity (O(1) swap).
+  void SwapVelocityBuffers() {
+    std::swap(u, uNext);
+    std::swap(v, vNext);
+  }
+
+  /// @brief Make @c smokeNext the current smoke field (O(1) swap).
+  void SwapSmokeBuffer() {
+    std::swap(smokeMap, smokeNext);
+    smokeTiles.Swap();
   }
 
   // Field update methods
@@ -99,13 +169,20 @@ public:
    *                     + \frac{v(i,j+1) - v(i,j)}{\Delta y}
    * \f$
    */
-  void Div();
+  void Div() { Div(0, ny); }
+
+  /// @brief @c Div() restricted to the cells of rows [@p j0, @p j1).
+  void Div(int j0, int j1);
 
   /**
    * @brief Interpolate the velocity magnitude |u| to cell centres and store
    *        the result in @c normVelocity.
    */
-  void VelocityNormCenterGrid();
+  void VelocityNormCenterGrid() { VelocityNormCenterGrid(0, ny - 1); }
+
+  /// @brief @c VelocityNormCenterGrid() restricted to rows [@p j0, @p j1)
+  ///        (clamped to the ny - 1 rows of @c normVelocity).
+  void VelocityNormCenterGrid(int j0, int j1);
 
   // Geometry helpers
 
@@ -123,8 +200,11 @@ public:
   void SolidBorders();
 
 private:
-  std::vector<uint8_t> labels; ///< Flat cell-type array, same layout as p.
+  std::vector<uint8_t> labels; ///< Flat cell-type array, row-major nx × ny.
+  uint64_t labelsVersion = 0;  ///< Incremented on every label change.
 
   /// @brief Flat index into @c labels (row-major, matching Grid2D).
   [[nodiscard]] int idx(int i, int j) const { return nx * j + i; }
 };
+
+} // namespace PIC_REAL
@@ -1,6 +1,189 @@
 #include "Grid2D.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
+
+namespace PIC_REAL {
+
+// Layouts
+
+template <int Tile, bool Morton>
+TiledLayout<Tile, Morton>::TiledLayout(const int nx, const int ny)
+    : tilesX_((nx + Tile - 1) / Tile), tilesY_((ny + Tile - 1) / Tile) {
+  if (!Morton)
+    return;
+
+  // Rank every tile by the interleaved bits of (ti, tj). Ranking instead of
+  // using the code directly keeps the storage dense for any tile count.
+  auto spread = [](uint32_t v) {
+    uint64_t x = v;
+    x = (x | (x << 16)) & 0x0000FFFF0000FFFFULL;
+    x = (x | (x << 8)) & 0x00FF00FF00FF00FFULL;
+    x = (x | (x << 4)) & 0x0F0F0F0F0F0F0F0FULL;
+    x = (x | (x << 2)) & 0x3333333333333333ULL;
+    x = (x | (x << 1)) & 0x5555555555555555ULL;
+    return x;
+  };
+  const int nTiles = tilesX_ * tilesY_;
+  std::vector<std::pair<uint64_t, int>> codes(nTiles);
+  for (int tj = 0; tj < tilesY_; ++tj)
+    for (int ti = 0; ti < tilesX_; ++ti)
+      codes[tilesX_ * tj + ti] = {spread(ti) | (spread(tj) << 1),
+                                  tilesX_ * tj + ti};
+  std::sort(codes.begin(), codes.end());
+  rank_.resize(nTiles);
+  for (int r = 0; r < nTiles; ++r)
+    rank_[codes[r].second] = r;
+}
+
+// Construction
+
+template <typename Layout, typename Real>
+BasicGrid2D<Layout, Real>::BasicGrid2D(int nx, int ny)
+    : nx(nx), ny(ny), layout(nx, ny), A(layout.size()) {
+  if constexpr (Layout::strided) {
+    // Every stored row, including halo rows and padding.
+    const int stride = layout.stride();
+    const int rows = static_cast<int>(A.size() / stride);
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < rows; ++j)
+      std::fill_n(A.data() + static_cast<std::size_t>(stride) * j, stride,
+                  Real{0});
+  } else {
+    const int nTiles = static_cast<int>(A.size() / Layout::tileSize);
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int t = 0; t < nTiles; ++t)
+      std::fill_n(A.data() + static_cast<std::size_t>(t) * Layout::tileSize,
+                  Layout::tileSize, Real{0});
+  }
+}
+
+// Row-major conversion
+//
+// Tiled layouts are converted one tile-row segment at a time: inside a tile
+// each row of Tile values is contiguous, so every copy is a short memcpy and
+// both sides are read / written sequentially within a grid row.
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::CopyToRowMajor(Real *dst) const {
+  if constexpr (Layout::rowMajor) {
+    std::copy(A.begin(), A.end(), dst);
+  } else if constexpr (Layout::strided) {
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < ny; ++j) {
+      const Real *src = A.data() + layout(0, j);
+      std::copy(src, src + nx, dst + static_cast<std::size_t>(nx) * j);
+    }
+  } else {
+    constexpr int T = Layout::tile;
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < ny; ++j) {
+      Real *row = dst + static_cast<std::size_t>(nx) * j;
+      for (int ti = 0; ti < layout.tilesX(); ++ti) {
+        const Real *src = A.data() + layout.tileOffset(ti, j / T) +
+                             static_cast<std::size_t>(j % T) * T;
+        const int len = std::min(T, nx - ti * T);
+        std::copy(src, src + len, row + ti * T);
+      }
+    }
+  }
+}
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::CopyFromRowMajor(const Real *src) {
+  if constexpr (Layout::rowMajor) {
+    std::copy(src, src + A.size(), A.begin());
+  } else if constexpr (Layout::strided) {
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < ny; ++j) {
+      const Real *row = src + static_cast<std::size_t>(nx) * j;
+      std::copy(row, row + nx, A.data() + layout(0, j));
+    }
+  } else {
+    constexpr int T = Layout::tile;
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < ny; ++j) {
+      const Real *row = src + static_cast<std::size_t>(nx) * j;
+      for (int ti = 0; ti < layout.tilesX(); ++ti) {
+        Real *dst = A.data() + layout.tileOffset(ti, j / T) +
+                       static_cast<std::size_t>(j % T) * T;
+        const int len = std::min(T, nx - ti * T);
+        std::copy(row + ti * T, row + ti * T + len, dst);
+      }
+    }
+  }
+}
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::GetRow(const int j, const int i0, const int n,
+                                       Real *dst) const {
+  if constexpr (Layout::strided) {
+    std::copy_n(A.data() + layout(i0, j), n, dst);
+  } else {
+    // Segments up to the next tile edge.
+    constexpr int T = Layout::tile;
+    for (int i = i0; i < i0 + n;) {
+      const int len = std::min(T - i % T, i0 + n - i);
+      std::copy_n(A.data() + layout(i, j), len, dst + (i - i0));
+      i += len;
+    }
+  }
+}
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::SetRow(const int j, const int i0, const int n,
+                                       const Real *src) {
+  if constexpr (Layout::strided) {
+    std::copy_n(src, n, A.data() + layout(i0, j));
+  } else {
+    constexpr int T = Layout::tile;
+    for (int i = i0; i < i0 + n;) {
+      const int len = std::min(T - i % T, i0 + n - i);
+      std::copy_n(src + (i - i0), len, A.data() + layout(i, j));
+      i += len;
+    }
+  }
+}
+
+// Ghost layers
+//
+// Columns first, then full rows: the row copies include the halo columns
+// just written, which fills the corners. Mirroring (layer g ← interior layer
+// g-1) puts the boundary on the cell face for any halo width.
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::FillGhosts(const GhostBoundary bc) {
+  constexpr int G = Layout::ghost;
+  if constexpr (G > 0) {
+    const bool mirror = (bc == GhostBoundary::NEUMANN);
+
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < ny; ++j) {
+      Real *row = A.data() + layout(0, j);
+      for (int g = 1; g <= G; ++g) {
+        row[-g] = mirror ? row[std::min(g - 1, nx - 1)] : Real{0};
+        row[nx - 1 + g] = mirror ? row[std::max(nx - g, 0)] : Real{0};
+      }
+    }
+
+    const int width = nx + 2 * G;
+    for (int g = 1; g <= G; ++g) {
+      Real *bottom = A.data() + layout(-G, -g);
+      Real *top = A.data() + layout(-G, ny - 1 + g);
+      if (mirror) {
+        const Real *srcB = A.data() + layout(-G, std::min(g - 1, ny - 1));
+        const Real *srcT = A.data() + layout(-G, std::max(ny - g, 0));
+        std::copy(srcB, srcB + width, bottom);
+        std::copy(srcT, srcT + width, top);
+      } else {
+        std::fill_n(bottom, width, Real{0});
+        std::fill_n(top, width, Real{0});
+      }
+    }
+  } else {
+    (void)bc;
+  }
+}
 
 // Bilinear interpolation
 //
@@ -19,8 +202,9 @@
 // is encapsulated there — this function is unchanged relative to the
 // column-major version.
 
-varType Grid2D::Interpolate(varType x, varType y, varType dx, varType dy,
-                            int field) const {
+template <typename Layout, typename Real>
+varType BasicGrid2D<Layout, Real>::Interpolate(varType x, varType y, varType dx,
+                                         varType dy, int field) const {
   varType i_real = x / dx;
   varType j_real = y / dy;
 
@@ -48,3 +232,312 @@ varType Grid2D::Interpolate(varType x, varType y, varType dx, varType dy,
              ((REAL_LITERAL(1.0) - fx) * f00 + fx * f10) +
          fy * ((REAL_LITERAL(1.0) - fx) * f01 + fx * f11);
 }
+
+// Batched bilinear interpolation
+//
+// Same arithmetic as Interpolate(), written so that every step maps onto a
+// vector instruction: truncating conversion plus a compare for floor,
+// min/max instead of std::clamp, and four gathers for the stencil. Every
+// lane is independent, which is what the simd pragma asserts.
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::InterpolateBatch(const int n, const varType *xs,
+                                           const varType *ys,
+                                           const varType offX,
+                                           const varType offY,
+                                           varType *out) const {
+  // Strided layouts index from their (0, 0) cell with their own pitch.
+  const varType *data = A.data();
+  int stride = nx;
+  if constexpr (Layout::strided) {
+    data += layout(0, 0);
+    stride = layout.stride();
+  }
+  const int iMax = nx - 2;
+  const int jMax = ny - 2;
+
+  OMP_PRAGMA(omp simd)
+  for (int k = 0; k < n; ++k) {
+    const varType i_real = xs[k] - offX;
+    const varType j_real = ys[k] - offY;
+
+    // floor() via truncation: std::floor does not vectorise under the
+    // default -ftrapping-math, a truncating conversion does.
+    int i0 = static_cast<int>(i_real);
+    int j0 = static_cast<int>(j_real);
+    i0 -= (i_real < static_cast<varType>(i0));
+    j0 -= (j_real < static_cast<varType>(j0));
+
+    const varType fx = i_real - static_cast<varType>(i0);
+    const varType fy = j_real - static_cast<varType>(j0);
+
+    i0 = std::min(std::max(i0, 0), iMax);
+    j0 = std::min(std::max(j0, 0), jMax);
+
+    varType f00, f10, f01, f11;
+    if constexpr (Layout::strided) {
+      const int base = stride * j0 + i0;
+      f00 = data[base];
+      f10 = data[base + 1];
+      f01 = data[base + stride];
+      f11 = data[base + stride + 1];
+    } else {
+      f00 = data[layout(i0, j0)];
+      f10 = data[layout(i0 + 1, j0)];
+      f01 = data[layout(i0, j0 + 1)];
+      f11 = data[layout(i0 + 1, j0 + 1)];
+    }
+
+    out[k] = (REAL_LITERAL(1.0) - fy) *
+                 ((REAL_LITERAL(1.0) - fx) * f00 + fx * f10) +
+             fy * ((REAL_LITERAL(1.0) - fx) * f01 + fx * f11);
+  }
+}
+
+// Monotone cubic interpolation
+//
+// Catmull-Rom weights of the nodes i0-1 … i0+2 at fraction t in [0, 1):
+//   w0 = (-t³ + 2t² - t) / 2      w1 = (3t³ - 5t² + 2) / 2
+//   w2 = (-3t³ + 4t² + t) / 2     w3 = (t³ - t²) / 2
+// They sum to 1 and reproduce linear data exactly. The 2-D value is the
+// tensor product, clamped to [min, max] of the inner 2 × 2 nodes.
+
+namespace {
+
+struct CubicWeights {
+  varType w0, w1, w2, w3;
+};
+
+inline CubicWeights catmullRom(const varType t) {
+  const varType t2 = t * t;
+  const varType t3 = t2 * t;
+  return {REAL_LITERAL(0.5) * (-t3 + REAL_LITERAL(2.0) * t2 - t),
+          REAL_LITERAL(0.5) *
+              (REAL_LITERAL(3.0) * t3 - REAL_LITERAL(5.0) * t2 +
+               REAL_LITERAL(2.0)),
+          REAL_LITERAL(0.5) *
+              (REAL_LITERAL(-3.0) * t3 + REAL_LITERAL(4.0) * t2 + t),
+          REAL_LITERAL(0.5) * (t3 - t2)};
+}
+
+/// Catmull-Rom blend of the four consecutive values at @p r.
+inline varType blend(const CubicWeights &w, const varType *r) {
+  return w.w0 * r[0] + w.w1 * r[1] + w.w2 * r[2] + w.w3 * r[3];
+}
+
+/// Value of cell (i, j): @p data is the (0, 0) cell for strided layouts,
+/// the storage start otherwise.
+template <typename Layout>
+inline varType cellValue(const varType *data, const Layout &layout,
+                         const int stride, const int i, const int j) {
+  if constexpr (Layout::strided)
+    return data[stride * j + i];
+  else
+    return data[layout(i, j)];
+}
+
+/// Catmull-Rom blend of columns c0, c1, c1+1, c3 of row @p r.
+template <typename Layout>
+inline varType cubicRow(const varType *data, const Layout &layout,
+                        const int stride, const CubicWeights &w, const int c0,
+                        const int c1, const int c3, const int r) {
+  return w.w0 * cellValue(data, layout, stride, c0, r) +
+         w.w1 * cellValue(data, layout, stride, c1, r) +
+         w.w2 * cellValue(data, layout, stride, c1 + 1, r) +
+         w.w3 * cellValue(data, layout, stride, c3, r);
+}
+
+/// General case of InterpolateCubicBatch(): weights and a gathered 4 × 4
+/// stencil per point, for points @p kBegin … @p kEnd - 1.
+template <typename Layout>
+void cubicGathered(const varType *data, const Layout &layout, const int stride,
+                   const int nx, const int ny, const int kBegin,
+                   const int kEnd, const varType *xs, const varType *ys,
+                   const varType offX, const varType offY, varType *out) {
+  const int iMax = nx - 2;
+  const int jMax = ny - 2;
+
+  OMP_PRAGMA(omp simd)
+  for (int k = kBegin; k < kEnd; ++k) {
+    const varType i_real = xs[k] - offX;
+    const varType j_real = ys[k] - offY;
+    int i0 = static_cast<int>(i_real);
+    int j0 = static_cast<int>(j_real);
+    i0 -= (i_real < static_cast<varType>(i0));
+    j0 -= (j_real < static_cast<varType>(j0));
+
+    const CubicWeights wx = catmullRom(i_real - static_cast<varType>(i0));
+    const CubicWeights wy = catmullRom(j_real - static_cast<varType>(j0));
+
+    i0 = std::min(std::max(i0, 0), iMax);
+    j0 = std::min(std::max(j0, 0), jMax);
+    const int c0 = std::max(i0 - 1, 0), c3 = std::min(i0 + 2, nx - 1);
+    const int s0 = std::max(j0 - 1, 0), s3 = std::min(j0 + 2, ny - 1);
+
+    const varType value =
+        wy.w0 * cubicRow(data, layout, stride, wx, c0, i0, c3, s0) +
+        wy.w1 * cubicRow(data, layout, stride, wx, c0, i0, c3, j0) +
+        wy.w2 * cubicRow(data, layout, stride, wx, c0, i0, c3, j0 + 1) +
+        wy.w3 * cubicRow(data, layout, stride, wx, c0, i0, c3, s3);
+    const varType f00 = cellValue(data, layout, stride, i0, j0);
+    const varType f10 = cellValue(data, layout, stride, i0 + 1, j0);
+    const varType f01 = cellValue(data, layout, stride, i0, j0 + 1);
+    const varType f11 = cellValue(data, layout, stride, i0 + 1, j0 + 1);
+    const varType lo = std::min(std::min(f00, f10), std::min(f01, f11));
+    const varType hi = std::max(std::max(f00, f10), std::max(f01, f11));
+    out[k] = std::min(std::max(value, lo), hi);
+  }
+}
+
+} // namespace
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::InterpolateCubicBatch(const int n,
+                                                const varType *xs,
+                                                const varType *ys,
+                                                const varType offX,
+                                                const varType offY,
+                                                varType *out) const {
+  // Strided layouts index from their (0, 0) cell with their own pitch.
+  const varType *data = A.data();
+  int pitch = nx;
+  if constexpr (Layout::strided) {
+    data += layout(0, 0);
+    pitch = layout.stride();
+  }
+  auto gathered = [&](const int kBegin, const int kEnd) {
+    cubicGathered(data, layout, pitch, nx, ny, kBegin, kEnd, xs, ys, offX,
+                  offY, out);
+  };
+
+  // Uniform displacement: one weight set and four contiguous source rows
+  // for the points whose stencil lies inside the grid. The displacement is
+  // taken from the middle point; the edges (clamped by the trace, or with
+  // stencils crossing the border) go through the general loop.
+  if constexpr (Layout::strided) {
+    if (n > 0) {
+      const int m = n / 2;
+      const varType i_real = xs[m] - offX - static_cast<varType>(m);
+      const varType j_real = ys[m] - offY;
+      const int i0 = static_cast<int>(std::floor(i_real));
+      const int j0 = static_cast<int>(std::floor(j_real));
+      // Point k uses columns i0+k-1 … i0+k+2.
+      const int kBegin = std::clamp(1 - i0, 0, n);
+      const int kEnd = std::clamp(nx - 2 - i0, kBegin, n);
+
+      varType spread = REAL_LITERAL(0.0);
+      OMP_PRAGMA(omp simd reduction(max : spread))
+      for (int k = kBegin; k < kEnd; ++k) {
+        const varType ex = xs[k] - xs[m] - static_cast<varType>(k - m);
+        const varType ey = ys[k] - ys[m];
+        spread = std::max(spread, std::max(std::abs(ex), std::abs(ey)));
+      }
+
+      if (j0 >= 1 && j0 + 2 <= ny - 1 && kEnd - kBegin > n / 2 &&
+          spread <= static_cast<varType>(CUBIC_UNIFORM_TOLERANCE)) {
+        const CubicWeights wx = catmullRom(i_real - static_cast<varType>(i0));
+        const CubicWeights wy = catmullRom(j_real - static_cast<varType>(j0));
+        const varType *r0 = data + pitch * (j0 - 1) + (i0 - 1);
+        const varType *r1 = r0 + pitch;
+        const varType *r2 = r1 + pitch;
+        const varType *r3 = r2 + pitch;
+
+        gathered(0, kBegin);
+        OMP_PRAGMA(omp simd)
+        for (int k = kBegin; k < kEnd; ++k) {
+          const varType value =
+              wy.w0 * blend(wx, r0 + k) + wy.w1 * blend(wx, r1 + k) +
+              wy.w2 * blend(wx, r2 + k) + wy.w3 * blend(wx, r3 + k);
+          const varType lo = std::min(std::min(r1[k + 1], r1[k + 2]),
+                                      std::min(r2[k + 1], r2[k + 2]));
+          const varType hi = std::max(std::max(r1[k + 1], r1[k + 2]),
+                                      std::max(r2[k + 1], r2[k + 2]));
+          out[k] = std::min(std::max(value, lo), hi);
+        }
+        gathered(kEnd, n);
+        return;
+      }
+    }
+  }
+
+  gathered(0, n);
+}
+
+// Min-max limiter
+//
+// Same stencil lookup as InterpolateBatch(); the four values are reduced to
+// their range instead of blended.
+
+template <typename Layout, typename Real>
+void BasicGrid2D<Layout, Real>::LimitBatch(const int n, const varType *xs,
+                                     const varType *ys, const varType offX,
+                                     const varType offY,
+                                     varType *values) const {
+  const varType *data = A.data();
+  int stride = nx;
+  if constexpr (Layout::strided) {
+    data += layout(0, 0);
+    stride = layout.stride();
+  }
+  const int iMax = nx - 2;
+  const int jMax = ny - 2;
+
+  OMP_PRAGMA(omp simd)
+  for (int k = 0; k < n; ++k) {
+    const varType i_real = xs[k] - offX;
+    const varType j_real = ys[k] - offY;
+    int i0 = static_cast<int>(i_real);
+    int j0 = static_cast<int>(j_real);
+    i0 -= (i_real < static_cast<varType>(i0));
+    j0 -= (j_real < static_cast<varType>(j0));
+    i0 = std::min(std::max(i0, 0), iMax);
+    j0 = std::min(std::max(j0, 0), jMax);
+
+    varType f00, f10, f01, f11;
+    if constexpr (Layout::strided) {
+      const int base = stride * j0 + i0;
+      f00 = data[base];
+      f10 = data[base + 1];
+      f01 = data[base + stride];
+      f11 = data[base + stride + 1];
+    } else {
+      f00 = data[layout(i0, j0)];
+      f10 = data[layout(i0 + 1, j0)];
+      f01 = data[layout(i0, j0 + 1)];
+      f11 = data[layout(i0 + 1, j0 + 1)];
+    }
+
+    const varType lo = std::min(std::min(f00, f10), std::min(f01, f11));
+    const varType hi = std::max(std::max(f00, f10), std::max(f01, f11));
+    const varType value = values[k];
+    values[k] = std::min(std::max(value, lo), hi);
+  }
+}
+
+// Instantiations
+
+template class TiledLayout<8, false>;
+template class TiledLayout<8, true>;
+template class TiledLayout<16, false>;
+template class TiledLayout<16, true>;
+template class BasicGrid2D<RowMajorLayout>;
+template class BasicGrid2D<TiledLayout<8, false>>;
+template class BasicGrid2D<TiledLayout<8, true>>;
+template class BasicGrid2D<TiledLayout<16, false>>;
+template class BasicGrid2D<TiledLayout<16, true>>;
+template class BasicGrid2D<PaddedLayout<1>>;
+template class BasicGrid2D<PaddedLayout<2>>;
+
+#ifndef USE_FLOAT
+// Float multigrid levels of the mixed-precision pressure solve: storage
+// only, the interpolation kernels read varType coordinates.
+template BasicGrid2D<PaddedLayout<1, float>, float>::BasicGrid2D(int, int);
+template void
+BasicGrid2D<PaddedLayout<1, float>, float>::CopyToRowMajor(float *) const;
+template void
+BasicGrid2D<PaddedLayout<1, float>, float>::CopyFromRowMajor(const float *);
+template void
+BasicGrid2D<PaddedLayout<1, float>, float>::FillGhosts(GhostBoundary);
+#endif
+
+} // namespace PIC_REAL
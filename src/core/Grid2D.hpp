@@ -1,5 +1,9 @@
 #pragma once
 #include "Precision.hpp"
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
 #include <vector>
 
 /**
@@ -7,45 +11,264 @@
  * @brief 2D scalar grid on a structured Cartesian mesh.
  */
 
+namespace PIC_REAL {
+
+/// Alignment of grid storage in bytes: one cache line, and a full AVX-512
+/// register.
+inline constexpr std::size_t GRID_ALIGNMENT = 64;
+
+/**
+ * @brief Allocator that default-initialises instead of value-initialising.
+ *
+ * @c std::vector<double>(n) zero-fills its storage on the constructing
+ * thread, which places every page on that thread's NUMA node. With this
+ * allocator the storage is left untouched, so the first parallel write
+ * decides where each page lives (first-touch placement).
+ *
+ * Storage is aligned to @c GRID_ALIGNMENT, so padded rows (see
+ * @c PaddedLayout) start on a cache line and vector loads never split one.
+ */
+template <typename T> struct DefaultInitAllocator : std::allocator<T> {
+  template <typename U> struct rebind {
+    using other = DefaultInitAllocator<U>;
+  };
+
+  using std::allocator<T>::allocator;
+
+  /// Allocate @p n values aligned to @c GRID_ALIGNMENT.
+  [[nodiscard]] T *allocate(std::size_t n) {
+    return static_cast<T *>(
+        ::operator new(n * sizeof(T), std::align_val_t{GRID_ALIGNMENT}));
+  }
+
+  /// Release storage obtained from @c allocate().
+  void deallocate(T *ptr, std::size_t n) noexcept {
+    ::operator delete(ptr, n * sizeof(T), std::align_val_t{GRID_ALIGNMENT});
+  }
+
+  /// Default-initialise (no-op for arithmetic types).
+  template <typename U> void construct(U *ptr) {
+    ::new (static_cast<void *>(ptr)) U;
+  }
+
+  /// Any other construction is forwarded unchanged.
+  template <typename U, typename... Args>
+  void construct(U *ptr, Args &&...args) {
+    ::new (static_cast<void *>(ptr)) U(std::forward<Args>(args)...);
+  }
+};
+
+// Storage layouts
+//
+// A layout maps cell (i, j) to an offset into the flat storage. It is a
+// compile-time policy of BasicGrid2D, so the mapping is inlined into every
+// Get()/Set() and the default row-major grid costs exactly what it did
+// before layouts existed.
+
+/**
+ * @brief Row-major layout: cell (i, j) at @c nx*j + i (the default).
+ */
+class RowMajorLayout {
+public:
+  static constexpr bool rowMajor = true; ///< Offsets are nx*j + i.
+  static constexpr bool strided = true;  ///< Rows are contiguous.
+  static constexpr int ghost = 0;        ///< No ghost layers.
+
+  RowMajorLayout(int nx, int ny) : nx_(nx), ny_(ny) {}
+
+  /// @return Number of stored values.
+  [[nodiscard]] std::size_t size() const {
+    return static_cast<std::size_t>(nx_) * ny_;
+  }
+
+  /// @return Storage offset of cell (i, j).
+  [[nodiscard]] std::size_t operator()(int i, int j) const {
+    return static_cast<std::size_t>(nx_) * j + i;
+  }
+
+  /// @return Distance between vertically adjacent cells.
+  [[nodiscard]] int stride() const { return nx_; }
+
+private:
+  int nx_, ny_;
+};
+
+/**
+ * @brief Tiled layout: the grid is cut into @p Tile × @p Tile blocks that
+ *        are each stored contiguously (row-major inside the tile).
+ *
+ * A bilinear or 5-point stencil then touches one or two tiles, i.e. a few
+ * cache lines and a single page, instead of rows that lie @c nx values
+ * apart. Tiles are ordered row-major, or along a Morton (Z-order) curve when
+ * @p Morton is set, which also keeps vertically adjacent tiles close.
+ * Partial tiles at the right / top edge are padded; padding cells are never
+ * addressed through @c Get() / @c Set().
+ *
+ * @tparam Tile   Tile edge in cells, a power of two (8 or 16 is typical).
+ * @tparam Morton Order tiles along a Z-curve instead of row by row.
+ */
+template <int Tile, bool Morton = false> class TiledLayout {
+  static_assert(Tile > 0 && (Tile & (Tile - 1)) == 0,
+                "TiledLayout: Tile must be a power of two");
+
+public:
+  static constexpr bool rowMajor = false;
+  static constexpr bool strided = false;
+  static constexpr int ghost = 0;
+  static constexpr int tile = Tile;              ///< Tile edge in cells.
+  static constexpr int tileSize = Tile * Tile;   ///< Values per tile.
+
+  TiledLayout(int nx, int ny);
+
+  /// @return Number of stored values (including edge padding).
+  [[nodiscard]] std::size_t size() const {
+    return static_cast<std::size_t>(tilesX_) * tilesY_ * tileSize;
+  }
+
+  /// @return Storage offset of the first value of tile (ti, tj).
+  [[nodiscard]] std::size_t tileOffset(int ti, int tj) const {
+    const int t = tilesX_ * tj + ti;
+    return static_cast<std::size_t>(Morton ? rank_[t] : t) * tileSize;
+  }
+
+  /// @return Storage offset of cell (i, j).
+  [[nodiscard]] std::size_t operator()(int i, int j) const {
+    return tileOffset(i / Tile, j / Tile) +
+           static_cast<std::size_t>((j % Tile) * Tile + i % Tile);
+  }
+
+  [[nodiscard]] int tilesX() const { return tilesX_; } ///< Tiles along x.
+  [[nodiscard]] int tilesY() const { return tilesY_; } ///< Tiles along y.
+
+private:
+  int tilesX_, tilesY_;
+  std::vector<int> rank_; ///< Morton rank of each row-major tile index.
+};
+
+/**
+ * @brief Row-major layout with a ghost-cell halo and a padded row stride.
+ *
+ * Around the nx × ny interior the grid stores @p Ghost extra layers on every
+ * side, addressable as cells (i, j) with i in [-Ghost, nx + Ghost) and j in
+ * [-Ghost, ny + Ghost). A stencil of radius up to @p Ghost therefore reads
+ * valid memory at every interior cell and needs no bounds checks: boundary
+ * conditions are applied once per sweep by filling the halo
+ * (@c BasicGrid2D::FillGhosts()) instead of being tested per cell.
+ *
+ * The first interior cell of every row is aligned to @c GRID_ALIGNMENT and
+ * the stride is a whole number of cache lines, so interior rows start on a
+ * vector boundary and rows never share a cache line between threads.
+ *
+ * @tparam Ghost Halo width in cells (1 for a 5-point stencil).
+ * @tparam Real  Stored scalar type, which sets the values per cache line.
+ */
+template <int Ghost, typename Real = varType> class PaddedLayout {
+  static_assert(Ghost > 0, "PaddedLayout: Ghost must be positive");
+
+  /// Values per aligned block.
+  static constexpr int lanes = static_cast<int>(GRID_ALIGNMENT / sizeof(Real));
+
+  static constexpr int roundUp(int n) {
+    return (n + lanes - 1) / lanes * lanes;
+  }
+
+public:
+  static constexpr bool rowMajor = false;
+  static constexpr bool strided = true;
+  static constexpr int ghost = Ghost; ///< Halo width in cells.
+
+  PaddedLayout(int nx, int ny)
+      : lead_(roundUp(Ghost)), stride_(roundUp(lead_ + nx + Ghost)),
+        rows_(ny + 2 * Ghost) {}
+
+  /// @return Number of stored values (halo and padding included).
+  [[nodiscard]] std::size_t size() const {
+    return static_cast<std::size_t>(stride_) * rows_;
+  }
+
+  /// @return Storage offset of cell (i, j); ghost cells have negative or
+  ///         out-of-range indices.
+  [[nodiscard]] std::size_t operator()(int i, int j) const {
+    return static_cast<std::size_t>(stride_) * (j + Ghost) + lead_ + i;
+  }
+
+  /// @return Distance between vertically adjacent cells.
+  [[nodiscard]] int stride() const { return stride_; }
+
+private:
+  int lead_;   ///< Offset of cell i = 0 inside its row (aligned).
+  int stride_; ///< Row pitch, a multiple of the alignment.
+  int rows_;   ///< Stored rows, interior plus halo.
+};
+
+/// Boundary condition applied to the halo by @c BasicGrid2D::FillGhosts().
+enum class GhostBoundary {
+  ZERO,    ///< Ghost cells hold 0 (homogeneous Dirichlet).
+  NEUMANN, ///< Ghost cells mirror the interior (zero normal gradient).
+};
+
 /**
  * @brief A flat, heap-allocated 2D scalar grid.
  *
- * Data is stored in **row-major** order: element (i, j) lives at
- * @c A[nx * j + i], so the i-index (x-direction) is the fast index.
+ * The mapping of cell (i, j) to the flat array @c A is set by the
+ * @p Layout policy. With the default @c RowMajorLayout (the @c Grid2D
+ * alias) element (i, j) lives at @c A[nx * j + i], so the i-index
+ * (x-direction) is the fast index.
  *
  * This layout matches the VTK ImageData convention for appended binary data,
  * where values are written x-fastest (for z … for y … for x), allowing the
  * raw @c A buffer to be passed directly to the writer without any
- * transposition.
+ * transposition. Other layouts go through @c CopyToRowMajor().
  *
  * All inner loops should therefore iterate over i in the innermost loop to
- * maximise cache locality.
+ * maximise cache locality. Kernels that index @c A directly assume the
+ * row-major layout; @c Get(), @c Set(), @c GetRow() / @c SetRow() and the
+ * interpolation kernels work for every layout.
  *
  * Grid dimensions are runtime values (read from a JSON config), so the
  * storage uses @c std::vector which is equivalent to a raw heap allocation
  * but provides automatic memory management and bounds-checking in debug builds.
+ *
+ * The stored scalar defaults to @c varType. Grids of another type (the float
+ * multigrid levels of the mixed-precision pressure solve) support
+ * construction, @c Get() / @c Set(), the row-major copies and
+ * @c FillGhosts(); the interpolation kernels exist for @c varType only.
+ *
+ * @tparam Layout Storage layout policy (@c RowMajorLayout, @c TiledLayout,
+ *                @c PaddedLayout).
+ * @tparam Real   Stored scalar type.
  */
-class Grid2D {
+template <typename Layout, typename Real = varType> class BasicGrid2D {
 public:
   int nx; ///< Number of cells in the x-direction.
   int ny; ///< Number of cells in the y-direction.
 
-  std::vector<varType> A; ///< Flat cell data, row-major: A[nx*j + i].
+  /// Storage type of @c A (see DefaultInitAllocator).
+  using Storage = std::vector<Real, DefaultInitAllocator<Real>>;
+
+  Layout layout; ///< Cell → storage offset mapping.
+  Storage A;     ///< Flat cell data, in @c layout order.
 
   /**
    * @brief Construct a zero-initialised grid of size @p nx × @p ny.
+   *
+   * Rows (tiles for tiled layouts) are zeroed in parallel with a static
+   * schedule, the same decomposition the row-parallel kernels use, so each
+   * thread first-touches the data it later works on.
+   *
    * @param nx Number of cells in x.
    * @param ny Number of cells in y.
    */
-  Grid2D(int nx, int ny) : nx(nx), ny(ny), A(nx * ny, varType{0}) {}
+  BasicGrid2D(int nx, int ny);
 
   /**
    * @brief Read the scalar value stored at cell (i, j).
-   * @param i Column index (x), must be in [0, nx).
-   * @param j Row    index (y), must be in [0, ny).
+   * @param i Column index (x), must be in [0, nx) (widened by the layout's
+   *          ghost layers).
+   * @param j Row    index (y), must be in [0, ny) (likewise).
    * @return  Value at (i, j).
    */
-  [[nodiscard]] varType Get(int i, int j) const { return A[nx * j + i]; }
+  [[nodiscard]] Real Get(int i, int j) const { return A[layout(i, j)]; }
 
   /**
    * @brief Write a scalar value into cell (i, j).
@@ -53,7 +276,7 @@ public:
    * @param j   Row    index (y), must be in [0, ny).
    * @param val Value to store.
    */
-  void Set(int i, int j, varType val) { A[nx * j + i] = val; }
+  void Set(int i, int j, Real val) { A[layout(i, j)] = val; }
 
   /**
    * @brief Check whether indices (i, j) lie inside the grid.
@@ -65,6 +288,39 @@ public:
     return i >= 0 && i < nx && j >= 0 && j < ny;
   }
 
+  /**
+   * @brief Copy the grid into @p dst in row-major order (nx × ny values).
+   *
+   * A plain copy for the row-major layout; padded layouts copy the
+   * interior of one row at a time, tiled layouts one tile row segment
+   * (@c Tile contiguous values).
+   */
+  void CopyToRowMajor(Real *dst) const;
+
+  /// @brief Inverse of @c CopyToRowMajor(): load nx × ny row-major values.
+  void CopyFromRowMajor(const Real *src);
+
+  /**
+   * @brief Copy cells i0 … i0+n-1 of row @p j into @p dst.
+   *
+   * The one-row form of @c CopyToRowMajor(), for kernels that work row by
+   * row on a grid of any layout; @c SetRow() stores such a row back.
+   */
+  void GetRow(int j, int i0, int n, Real *dst) const;
+
+  /// @brief Store @p n values from @p src into row @p j from column @p i0.
+  void SetRow(int j, int i0, int n, const Real *src);
+
+  /**
+   * @brief Apply a boundary condition by filling the ghost layers.
+   *
+   * Side columns are filled first and then whole rows (halo columns
+   * included), so corners receive a consistent value. With
+   * @c GhostBoundary::NEUMANN ghost layer g mirrors interior layer g-1 across
+   * the edge, which gives a zero normal gradient at the cell face. A no-op
+   * for layouts without ghost layers.
+   */
+  void FillGhosts(GhostBoundary bc);
   /**
    * @brief Bilinearly interpolate this grid at a physical position (x, y).
    *
@@ -86,4 +342,127 @@ public:
    */
   [[nodiscard]] varType Interpolate(varType x, varType y, varType dx,
                                     varType dy, int field) const;
+
+  /**
+   * @brief Bilinearly interpolate a batch of points (e.g. one grid row).
+   *
+   * Batched form of @c Interpolate() for points given in index space, i.e.
+   * @c xs = x/dx and @c ys = y/dy. The caller scales once (multiplying by a
+   * precomputed 1/dx) and can reuse the same @p xs / @p ys for several
+   * staggered grids, passing each grid's half-cell offset:
+   * (0, 0.5) for u, (0.5, 0) for v, (0.5, 0.5) for cell-centred data.
+   *
+   * Floor, clamp and weights are computed branch-free in a SIMD loop, so
+   * with @c -march=native the compiler emits AVX2 / AVX-512 lanes (with
+   * gathers for the stencil loads); without OpenMP the same loop is the
+   * scalar fallback. Results match @c Interpolate() up to rounding of the
+   * 1/dx scaling.
+   *
+   * @param n    Number of points.
+   * @param xs   x-coordinates in units of dx, @p n values.
+   * @param ys   y-coordinates in units of dy, @p n values.
+   * @param offX Stagger offset subtracted from @p xs.
+   * @param offY Stagger offset subtracted from @p ys.
+   * @param out  Interpolated values, @p n entries (must not alias inputs).
+   */
+  void InterpolateBatch(int n, const varType *xs, const varType *ys,
+                        varType offX, varType offY, varType *out) const;
+
+  /**
+   * @brief Monotone cubic interpolation of a batch of points.
+   *
+   * Same arguments and point convention as @c InterpolateBatch(), but on a
+   * 4 × 4 stencil with Catmull-Rom weights in x and y (indices clamped at
+   * the grid edges), and the result clamped to the range of the four
+   * bilinear nodes. The clamp keeps the interpolant monotone: no over- or
+   * undershoot next to sharp gradients, where an unclamped cubic rings.
+   *
+   * The weights are computed in the SIMD loop for every point. A batch
+   * whose points all share one fractional offset (one grid row displaced
+   * by a nearly uniform velocity: @c xs[k] = xs[0] + k and
+   * @c ys[k] = ys[0] to within @c CUBIC_UNIFORM_TOLERANCE cells) computes
+   * the two weight sets once and reuses them for every point, reading
+   * the four source rows contiguously instead of gathering the stencils.
+   *
+   * @param n    Number of points.
+   * @param xs   x-coordinates in units of dx, @p n values.
+   * @param ys   y-coordinates in units of dy, @p n values.
+   * @param offX Stagger offset subtracted from @p xs.
+   * @param offY Stagger offset subtracted from @p ys.
+   * @param out  Interpolated values, @p n entries (must not alias inputs).
+   */
+  void InterpolateCubicBatch(int n, const varType *xs, const varType *ys,
+                             varType offX, varType offY, varType *out) const;
+
+  /**
+   * @brief Clamp a batch of values to the range of their interpolation
+   *        stencils (min-max limiter of the error-corrected advection).
+   *
+   * Point @p k selects the same four cells as @c InterpolateBatch() with
+   * the same arguments; @p values[k] is clamped to their minimum and
+   * maximum, so a corrected value never leaves the range of the data it
+   * was interpolated from.
+   *
+   * @param n      Number of points.
+   * @param xs     x-coordinates in units of dx, @p n values.
+   * @param ys     y-coordinates in units of dy, @p n values.
+   * @param offX   Stagger offset subtracted from @p xs.
+   * @param offY   Stagger offset subtracted from @p ys.
+   * @param values Values to clamp in place, @p n entries.
+   */
+  void LimitBatch(int n, const varType *xs, const varType *ys, varType offX,
+                  varType offY, varType *values) const;
 };
+
+/// Largest deviation (in cells) from a uniform displacement for which
+/// @c InterpolateCubicBatch() reuses one set of weights for a whole batch.
+constexpr double CUBIC_UNIFORM_TOLERANCE = 1e-4;
+
+/// The simulation's grid type: row-major storage.
+using Grid2D = BasicGrid2D<RowMajorLayout>;
+
+/// Grid stored in @p Tile × @p Tile tiles (row-major tile order).
+template <int Tile = 16> using TiledGrid2D = BasicGrid2D<TiledLayout<Tile>>;
+
+/// Grid stored in @p Tile × @p Tile tiles ordered along a Morton curve.
+template <int Tile = 16>
+using MortonGrid2D = BasicGrid2D<TiledLayout<Tile, true>>;
+
+/// Grid with a @p Ghost-cell halo and aligned, padded rows.
+template <int Ghost = 1, typename Real = varType>
+using PaddedGrid2D = BasicGrid2D<PaddedLayout<Ghost, Real>, Real>;
+
+// Storage of the smoke (Fields2D::smokeMap and its back-buffer), chosen at
+// configure time with PIC_SMOKE_LAYOUT: row-major by default, else tiles of
+// PIC_SMOKE_TILE cells, Morton-ordered with PIC_SMOKE_MORTON. The smoke is
+// only advected and written, so it is the one field whose kernels all work
+// through Get() / Set(), the row copies and the interpolation kernels.
+#if defined(PIC_SMOKE_TILE) && PIC_SMOKE_TILE > 0
+#ifdef PIC_SMOKE_MORTON
+using SmokeLayout = TiledLayout<PIC_SMOKE_TILE, true>;
+#else
+using SmokeLayout = TiledLayout<PIC_SMOKE_TILE>;
+#endif
+#else
+using SmokeLayout = RowMajorLayout;
+#endif
+
+/// The smoke's grid type (see SmokeLayout).
+using SmokeGrid2D = BasicGrid2D<SmokeLayout>;
+
+// Defined in Grid2D.cpp and instantiated there for RowMajorLayout,
+// TiledLayout<8 | 16, false | true> and PaddedLayout<1 | 2>, plus the
+// storage members of PaddedGrid2D<1, float> in double builds.
+extern template class TiledLayout<8, false>;
+extern template class TiledLayout<8, true>;
+extern template class TiledLayout<16, false>;
+extern template class TiledLayout<16, true>;
+extern template class BasicGrid2D<RowMajorLayout>;
+extern template class BasicGrid2D<TiledLayout<8, false>>;
+extern template class BasicGrid2D<TiledLayout<8, true>>;
+extern template class BasicGrid2D<TiledLayout<16, false>>;
+extern template class BasicGrid2D<TiledLayout<16, true>>;
+extern template class BasicGrid2D<PaddedLayout<1>>;
+extern template class BasicGrid2D<PaddedLayout<2>>;
+
+} // namespace PIC_REAL
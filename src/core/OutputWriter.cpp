@@ -1,6 +1,9 @@
 #include "OutputWriter.hpp"
+#include <algorithm>
+#include <cstring>
 #include <filesystem>
 #include <iomanip>
+#include <iostream>
 #include <sstream>
 #include <stdexcept>
 
@@ -8,14 +11,17 @@
 #include <zlib.h>
 #endif
 
+namespace PIC_REAL {
+
 namespace fs = std::filesystem;
 
 // OutputWriter
 
 OutputWriter::OutputWriter(const std::string &output_dir,
-                           const std::string &pvd_name)
+                           const std::string &pvd_name, AsyncOutput *async,
+                           const OutputCompression zip)
     : output_dir_(output_dir), base_name_(pvd_name), current_step_(0),
-      pvd_finalised_(false) {
+      pvd_finalised_(false), async_(async), zip_(zip) {
   fs::create_directories(output_dir_);
 }
 
@@ -26,31 +32,94 @@ OutputWriter::~OutputWriter() {
     finalisePVD();
 }
 
+void OutputWriter::restoreState(const int frames,
+                                std::vector<std::string> entries) {
+  current_step_ = frames;
+  pvd_entries_ = std::move(entries);
+}
+
+void OutputWriter::setPiece(const int rank, std::vector<int> rowStarts) {
+  piece_rank_ = rank;
+  piece_rows_ = std::move(rowStarts);
+}
+
 // Private helpers
 
 // Internal helpers
 
 /**
- * @brief Write a 4-byte little-endian unsigned integer to a binary stream.
+ * @brief Store a 4-byte little-endian unsigned integer at @p dst.
  *
  * ParaView uses uint32_t header words to locate appended data by offset, so
  * every length field in the VTK binary block must be exactly 4 bytes.
  *
- * @param out Binary output stream.
- * @param v   Value to write.
+ * @param dst Destination (at least 4 bytes).
+ * @param v   Value to store.
  */
-static void writeU32(std::ofstream &out, uint32_t v) {
-  out.write(reinterpret_cast<const char *>(&v), sizeof(v));
+static void putU32(unsigned char *dst, uint32_t v) {
+  std::memcpy(dst, &v, sizeof(v));
+}
+
+#ifdef HAVE_ZLIB
+/**
+ * @brief Test whether @p n bytes are all zero, stopping at the first
+ *        non-zero 4 KiB chunk.
+ */
+static bool allZero(const unsigned char *p, const std::size_t n) {
+  constexpr std::size_t CHUNK = 4096;
+  for (std::size_t k = 0; k < n; k += CHUNK) {
+    unsigned char any = 0;
+    for (std::size_t e = std::min(n, k + CHUNK), m = k; m < e; ++m)
+      any |= p[m];
+    if (any != 0)
+      return false;
+  }
+  return true;
 }
+#endif
+
 std::string OutputWriter::formatFilename(const std::string &field_name,
-                                         int step) const {
+                                         int step,
+                                         const std::string &suffix) const {
   // Zero-pad the step number to four digits: "u_0042.vti"
   std::ostringstream oss;
   oss << field_name << '_' << std::setw(4) << std::setfill('0') << step
-      << ".vti";
+      << suffix;
   return oss.str();
 }
 
+bool OutputWriter::writePieceIndex(const std::string &pvti_path,
+                                   const int step) const {
+  std::ofstream out(pvti_path);
+  if (!out.is_open())
+    return false;
+
+  // Same whole extent and arrays as the pieces; each piece is referenced
+  // with its own extent (point indices, like the .vti files).
+  out << "<?xml version=\"1.0\"?>\n"
+      << "<VTKFile type=\"PImageData\" version=\"0.1\""
+      << " byte_order=\"LittleEndian\">\n"
+      << "  <PImageData WholeExtent=\"0 " << frame_nx_ << " 0 "
+      << frame_whole_ny_ << " 0 0\" GhostLevel=\"0\""
+      << " Origin=\"0.0 0.0 0.0\" Spacing=\"1.0 1.0 1.0\">\n"
+      << "    <PCellData Scalars=\"" << frame_names_.front() << "\">\n";
+  for (const std::string &name : frame_names_)
+    out << "      <PDataArray type=\"" << vtkTypeName() << "\" Name=\""
+        << name << "\" NumberOfComponents=\"1\"/>\n";
+  out << "    </PCellData>\n";
+  const int pieces = static_cast<int>(piece_rows_.size());
+  for (int k = 0; k < pieces; ++k) {
+    const int end = (k + 1 < pieces) ? piece_rows_[k + 1] : frame_whole_ny_;
+    out << "    <Piece Extent=\"0 " << frame_nx_ << ' ' << piece_rows_[k]
+        << ' ' << end << " 0 0\" Source=\""
+        << formatFilename(base_name_, step, "_p" + std::to_string(k) + ".vti")
+        << "\"/>\n";
+  }
+  out << "  </PImageData>\n"
+      << "</VTKFile>\n";
+  return static_cast<bool>(out);
+}
+
 void OutputWriter::appendPVDEntry(const std::string &vti_filename,
                                   double time_value) {
   std::ostringstream oss;
@@ -60,57 +129,175 @@ void OutputWriter::appendPVDEntry(const std::string &vti_filename,
 }
 
 std::vector<unsigned char>
-OutputWriter::preparePayload(const std::vector<varType> &values) {
-  const std::size_t rawBytes = values.size() * sizeof(varType);
-  const auto *rawPtr = reinterpret_cast<const unsigned char *>(values.data());
+OutputWriter::preparePayload(const varType *values, const std::size_t n,
+                             const OutputCompression &zip,
+                             const bool parallel) {
+  const std::size_t rawBytes = n * sizeof(varType);
+  const auto *rawPtr = reinterpret_cast<const unsigned char *>(values);
 
 #ifdef HAVE_ZLIB
-  // zlib: compress at Z_BEST_SPEED to minimise I/O size with low CPU cost.
-  uLongf compBound = compressBound(static_cast<uLong>(rawBytes));
-  std::vector<unsigned char> buf(compBound);
-  uLongf compLen = compBound;
-
-  const int ret = compress2(buf.data(), &compLen, rawPtr,
-                            static_cast<uLong>(rawBytes), Z_BEST_SPEED);
-  if (ret != Z_OK)
+  // Every block is deflated on its own into a slot of compressBound() bytes
+  // after the header; the slots are then packed towards the front. Blocks
+  // are independent, so they compress in parallel and ParaView inflates
+  // them one by one.
+  const std::size_t blockBytes = std::max<std::size_t>(zip.blockBytes, 1);
+  const int numBlocks =
+      static_cast<int>(std::max<std::size_t>(1, (rawBytes + blockBytes - 1) /
+                                                    blockBytes));
+  const std::size_t lastBytes =
+      rawBytes - static_cast<std::size_t>(numBlocks - 1) * blockBytes;
+  const std::size_t headerBytes = (3 + static_cast<std::size_t>(numBlocks)) *
+                                  sizeof(uint32_t);
+  const std::size_t slot = compressBound(static_cast<uLong>(blockBytes));
+
+  std::vector<unsigned char> buf(headerBytes + slot * numBlocks);
+  std::vector<std::size_t> compLen(numBlocks);
+  std::vector<uint8_t> empty(numBlocks, 0);
+  int failed = 0;
+
+  // Full blocks of zeros (the empty part of a sparse field) all deflate to
+  // the same bytes: they are only detected here and compressed once below.
+  OMP_PRAGMA(omp parallel for schedule(dynamic) reduction(+ : failed)
+                 if (parallel && numBlocks > 1))
+  for (int b = 0; b < numBlocks; ++b) {
+    const std::size_t len = (b + 1 < numBlocks) ? blockBytes : lastBytes;
+    const unsigned char *src = rawPtr + blockBytes * b;
+    if (len == blockBytes && allZero(src, len)) {
+      empty[b] = 1;
+      continue;
+    }
+    uLongf out = static_cast<uLongf>(slot);
+    const int ret = compress2(buf.data() + headerBytes + slot * b, &out, src,
+                              static_cast<uLong>(len), zip.level);
+    failed += (ret != Z_OK);
+    compLen[b] = out;
+  }
+  const int firstEmpty = static_cast<int>(
+      std::find(empty.begin(), empty.end(), 1) - empty.begin());
+  if (firstEmpty < numBlocks) {
+    const std::vector<unsigned char> zeros(blockBytes, 0);
+    unsigned char *deflated = buf.data() + headerBytes + slot * firstEmpty;
+    uLongf out = static_cast<uLongf>(slot);
+    failed += (compress2(deflated, &out, zeros.data(),
+                         static_cast<uLong>(blockBytes), zip.level) != Z_OK);
+    for (int b = firstEmpty; b < numBlocks; ++b)
+      if (empty[b]) {
+        compLen[b] = out;
+        if (b != firstEmpty)
+          std::memcpy(buf.data() + headerBytes + slot * b, deflated, out);
+      }
+  }
+  if (failed > 0)
     throw std::runtime_error("OutputWriter: zlib compress2 failed");
 
-  buf.resize(compLen); // trim to actual compressed size
+  putU32(buf.data(), static_cast<uint32_t>(numBlocks));
+  putU32(buf.data() + 4, static_cast<uint32_t>(blockBytes));
+  putU32(buf.data() + 8, static_cast<uint32_t>(lastBytes));
+  std::size_t end = headerBytes;
+  for (int b = 0; b < numBlocks; ++b) {
+    putU32(buf.data() + 12 + 4 * static_cast<std::size_t>(b),
+           static_cast<uint32_t>(compLen[b]));
+    // Packed data never overtakes a slot that is still to be moved.
+    std::memmove(buf.data() + end, buf.data() + headerBytes + slot * b,
+                 compLen[b]);
+    end += compLen[b];
+  }
+  buf.resize(end);
   return buf;
 #else
-  // No compression: return a verbatim copy of the raw bytes.
-  return std::vector<unsigned char>(rawPtr, rawPtr + rawBytes);
+  // No compression: a single word with the raw byte count, then the bytes.
+  (void)zip;
+  (void)parallel;
+  std::vector<unsigned char> buf(sizeof(uint32_t) + rawBytes);
+  putU32(buf.data(), static_cast<uint32_t>(rawBytes));
+  std::copy(rawPtr, rawPtr + rawBytes, buf.data() + sizeof(uint32_t));
+  return buf;
 #endif
 }
 
 // Public
 
-bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id) {
+varType *OutputWriter::beginFrame(const int nx, const int ny,
+                                  std::vector<std::string> names,
+                                  const int wholeNy) {
   if (pvd_finalised_)
-    return false;
+    return nullptr;
+  frame_nx_ = nx;
+  frame_ny_ = ny;
+  frame_whole_ny_ = (wholeNy > 0) ? wholeNy : ny;
+  frame_names_ = std::move(names);
+  const std::size_t n =
+      frame_names_.size() * static_cast<std::size_t>(nx) * ny;
+  if (async_) {
+    snapshot_ = async_->acquire();
+    snapshot_.resize(n);
+    return snapshot_.data();
+  }
+  values_.resize(n);
+  return values_.data();
+}
+
+bool OutputWriter::endFrame(const double time) {
+  // A piece is named after its rank and indexed by the .pvti of rank 0.
+  const bool piece = piece_rank_ >= 0;
+  const int row0 = piece ? piece_rows_[piece_rank_] : 0;
+  const std::string vti_name =
+      piece ? formatFilename(base_name_, current_step_,
+                             "_p" + std::to_string(piece_rank_) + ".vti")
+            : formatFilename(base_name_, current_step_);
+  std::string vti_path = output_dir_ + "/" + vti_name;
 
-  const int nx = grid.nx;
-  const int ny = grid.ny;
-  const uint32_t rawBytes = static_cast<uint32_t>(static_cast<std::size_t>(nx) *
-                                                  ny * sizeof(varType));
+  if (!async_) {
+    if (!writeFile(values_, frame_nx_, frame_ny_, row0, frame_whole_ny_,
+                   frame_names_, vti_path, zip_, true))
+      return false;
+  } else {
+    // The frame is numbered and indexed now, in step order; only the encode
+    // and the file write run in the background.
+    async_->submit(std::move(snapshot_),
+                   [nx = frame_nx_, ny = frame_ny_, row0,
+                    wholeNy = frame_whole_ny_, names = frame_names_,
+                    path = std::move(vti_path),
+                    zip = zip_](const AsyncOutput::Buffer &v) {
+                     if (writeFile(v, nx, ny, row0, wholeNy, names, path, zip,
+                                   false))
+                       return true;
+                     std::cerr << "[OutputWriter] Cannot write " << path
+                               << '\n';
+                     return false;
+                   });
+  }
 
-  // Collect grid data in VTK x-fastest (row-major) order.
-  // We use grid.Get(i, j) rather than touching grid.A directly so this code
-  // is correct regardless of the internal storage layout of Grid2D.
-  // VTK ImageData expects values ordered: for j=0..ny-1 { for i=0..nx-1 }.
-  std::vector<varType> values;
-  values.reserve(static_cast<std::size_t>(nx) * ny);
-  for (int j = 0; j < ny; ++j)
-    for (int i = 0; i < nx; ++i)
-      values.push_back(grid.Get(i, j));
+  // Update PVD index (rank 0 only for pieces: it lists the .pvti)
+  if (!piece) {
+    appendPVDEntry(vti_name, time);
+  } else if (piece_rank_ == 0) {
+    const std::string pvti_name =
+        formatFilename(base_name_, current_step_, ".pvti");
+    if (!writePieceIndex(output_dir_ + "/" + pvti_name, current_step_))
+      return false;
+    appendPVDEntry(pvti_name, time);
+  }
+  ++current_step_;
+  return true;
+}
 
-  // Compress (or copy) payload
-  const std::vector<unsigned char> payload = preparePayload(values);
+bool OutputWriter::writeFile(const std::vector<varType> &values, const int nx,
+                             const int ny, const int row0, const int wholeNy,
+                             const std::vector<std::string> &names,
+                             const std::string &vti_path,
+                             const OutputCompression &zip,
+                             const bool parallel) {
+  // Every array is already in VTK x-fastest (row-major) order:
+  // for j=0..ny-1 { for i=0..nx-1 }.
+  const std::size_t cells = static_cast<std::size_t>(nx) * ny;
+  std::vector<std::vector<unsigned char>> payloads;
+  payloads.reserve(names.size());
+  for (std::size_t a = 0; a < names.size(); ++a)
+    payloads.push_back(
+        preparePayload(values.data() + a * cells, cells, zip, parallel));
 
   // Open output file
-  const std::string vti_name = formatFilename(id, current_step_);
-  const std::string vti_path = output_dir_ + "/" + vti_name;
-
   std::ofstream out(vti_path, std::ios::binary);
   if (!out.is_open())
     return false;
@@ -132,18 +319,25 @@ bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id) {
       // WholeExtent is in *points*. A grid of nx×ny cells has nx+1 × ny+1
       // corner points, so point indices run 0..nx in x and 0..ny in y.
       // CellData array size = nx*ny, row stride = nx. Consistent with data.
-      << "  <ImageData WholeExtent=\"0 " << nx << " 0 " << ny << " 0 0\""
+      // The piece of a distributed run covers rows row0..row0+ny of it.
+      << "  <ImageData WholeExtent=\"0 " << nx << " 0 " << wholeNy
+      << " 0 0\""
       << " Origin=\"0.0 0.0 0.0\""
       << " Spacing=\"1.0 1.0 1.0\">\n"
-      << "    <Piece Extent=\"0 " << nx << " 0 " << ny
+      << "    <Piece Extent=\"0 " << nx << ' ' << row0 << ' ' << row0 + ny
       << " 0 0\">\n"
       // CellData: one value per cell (not per corner point).
-      << "      <CellData Scalars=\"" << id << "\">\n"
-      << "        <DataArray type=\"" << vtkTypeName() << "\""
-      << " Name=\"" << id << "\""
-      << " NumberOfComponents=\"1\""
-      << " format=\"appended\" offset=\"0\"/>\n"
-      << "      </CellData>\n"
+      << "      <CellData Scalars=\"" << names.front() << "\">\n";
+  // Each array's offset is its byte position inside the appended data.
+  std::size_t offset = 0;
+  for (std::size_t a = 0; a < names.size(); ++a) {
+    xml << "        <DataArray type=\"" << vtkTypeName() << "\""
+        << " Name=\"" << names[a] << "\""
+        << " NumberOfComponents=\"1\""
+        << " format=\"appended\" offset=\"" << offset << "\"/>\n";
+    offset += payloads[a].size();
+  }
+  xml << "      </CellData>\n"
       << "    </Piece>\n"
       << "  </ImageData>\n"
       << "  <AppendedData encoding=\"raw\">\n"
@@ -152,33 +346,31 @@ bool OutputWriter::writeGrid2D(const Grid2D &grid, const std::string &id) {
   const std::string xmlStr = xml.str();
   out.write(xmlStr.data(), static_cast<std::streamsize>(xmlStr.size()));
 
-  // Write binary header + payload
-#ifdef HAVE_ZLIB
-  // VTK single-block compressed header (4 × uint32_t):
-  writeU32(out, 1);        // numBlocks
-  writeU32(out, rawBytes); // uncompressed block size
-  writeU32(out, rawBytes); // last partial block size
-  writeU32(out, static_cast<uint32_t>(payload.size())); // compressed size
-#else
-  writeU32(out, rawBytes); // single word: raw byte count
-#endif
-
-  out.write(reinterpret_cast<const char *>(payload.data()),
-            static_cast<std::streamsize>(payload.size()));
+  // Write binary header + payload of every array
+  for (const std::vector<unsigned char> &payload : payloads)
+    out.write(reinterpret_cast<const char *>(payload.data()),
+              static_cast<std::streamsize>(payload.size()));
 
   out << "\n  </AppendedData>\n"
       << "</VTKFile>\n";
-
-  // Update PVD index
-  appendPVDEntry(vti_name, static_cast<double>(current_step_));
-  ++current_step_;
-  return true;
+  return static_cast<bool>(out);
 }
 
 void OutputWriter::finalisePVD() {
   if (pvd_finalised_)
     return;
 
+  // The index must not be written before the frames it lists.
+  if (async_ && !async_->flush())
+    std::cerr << "[OutputWriter] Warning: some '" << base_name_
+              << "' frames could not be written\n";
+
+  // Rank 0 indexes the pieces of every rank.
+  if (piece_rank_ > 0) {
+    pvd_finalised_ = true;
+    return;
+  }
+
   const std::string pvd_path = output_dir_ + "/" + base_name_ + ".pvd";
   std::ofstream out(pvd_path);
   if (!out.is_open())
@@ -194,3 +386,5 @@ void OutputWriter::finalisePVD() {
 
   pvd_finalised_ = true;
 }
+
+} // namespace PIC_REAL
@@ -1,4 +1,5 @@
 #pragma once
+#include "AsyncOutput.hpp"
 #include "Grid2D.hpp"
 #include "Precision.hpp"
 #include <fstream>
@@ -10,6 +11,14 @@
  * @brief VTK ImageData (.vti) writer with PVD time-series index.
  */
 
+namespace PIC_REAL {
+
+/// zlib settings of the .vti appended data (ignored without zlib).
+struct OutputCompression {
+  int level = 1;                      ///< zlib level, 0–9 (1 = best speed).
+  std::size_t blockBytes = 128 << 10; ///< Uncompressed bytes per block.
+};
+
 /**
  * @brief Writes simulation fields to disk as VTK ImageData files (.vti)
  *        and maintains a PVD time-series index for ParaView.
@@ -23,20 +32,42 @@
  *   <name>.pvd         ← ParaView collection index (written on destruction)
  * ```
  *
- * ### Binary payload format inside each .vti
+ * A frame holds one or more cell arrays of the same nx × ny piece
+ * (@c beginFrame() / @c endFrame()); @c writeGrid2D() is the one-array case.
+ * Each array has its own block in the appended data, located by the
+ * @c offset attribute of its DataArray.
+ *
+ * ### Binary payload format of each array
  * Without zlib:
  * ```
  *   uint32_t  rawByteCount
- *   varType[] values          (nx * ny elements, storage order)
+ *   varType[] values          (nx * ny elements, row-major)
  * ```
- * With zlib (VTK compressed-block format, single block):
+ * With zlib (VTK compressed-block format):
  * ```
- *   uint32_t  numBlocks      (= 1)
- *   uint32_t  blockSize      (= rawByteCount)
- *   uint32_t  lastBlockSize  (= rawByteCount)
- *   uint32_t  compressedSize
- *   byte[]    compressed data
+ *   uint32_t  numBlocks
+ *   uint32_t  blockSize              (uncompressed bytes per block)
+ *   uint32_t  lastBlockSize          (uncompressed bytes of the last block)
+ *   uint32_t  compressedSize[numBlocks]
+ *   byte[]    compressed blocks, back to back
  * ```
+ * The raw data is cut into blocks of @c OutputCompression::blockBytes that
+ * are deflated independently, in parallel (OpenMP) for synchronous writes.
+ * Blocks of zeros, such as the empty part of a sparse smoke field, are
+ * deflated once per array and copied.
+ *
+ * ### Asynchronous mode
+ * Given an @c AsyncOutput, a frame is filled directly into a pooled
+ * snapshot buffer and @c endFrame() only queues the encode + write; the
+ * frame number and PVD entry are assigned immediately, so the index stays in
+ * step order however the background writes complete. @c finalisePVD() waits
+ * for the queue.
+ *
+ * ### Distributed runs
+ * After @c setPiece() every rank writes only its own rows of a frame, as
+ * @c \<name\>_0042_p\<rank\>.vti (the Extent of a piece of the whole
+ * domain). Rank 0 also writes @c \<name\>_0042.pvti, which lists the pieces
+ * of all ranks, and the .pvd indexes those; the other ranks keep no index.
  */
 class OutputWriter {
 public:
@@ -45,8 +76,13 @@ public:
    * @param output_dir Directory where .vti files will be written.
    * @param pvd_name   Base name used for both the .vti prefix and the .pvd
    * file.
+   * @param async      Background writer shared by several writers, or
+   *                   @c nullptr to write synchronously (non-owning, must
+   *                   outlive this object).
+   * @param zip        Compression level and block size.
    */
-  OutputWriter(const std::string &output_dir, const std::string &pvd_name);
+  OutputWriter(const std::string &output_dir, const std::string &pvd_name,
+               AsyncOutput *async = nullptr, OutputCompression zip = {});
 
   /// Finalises the PVD index on destruction if not already done.
   ~OutputWriter();
@@ -58,40 +94,158 @@ public:
   /**
    * @brief Serialise one grid to a .vti file and append a PVD entry.
    *
-   * Grid data is copied directly from @c grid.A (storage order), so the
-   * access pattern is perfectly sequential — no transposition is performed.
+   * The grid is converted to VTK's x-fastest order with
+   * @c CopyToRowMajor(): a straight copy of @c grid.A for row-major grids,
+   * one interior row at a time for padded ones and tile-row segments for
+   * tiled ones (a tiled smoke, see @c SmokeLayout). The conversion buffer is
+   * kept between calls (a pooled snapshot buffer in asynchronous mode).
    *
-   * @param grid  Grid to write.
+   * @param grid  Grid to write (any storage layout).
    * @param id    Field name embedded in the VTK XML (e.g. @c "u", @c "p").
-   * @return @c true on success, @c false if the file could not be opened or
-   *         the PVD has already been finalised.
+   * @param time  Simulation time of the frame (PVD @c timestep attribute).
+   * @return @c true on success (asynchronous mode: once queued), @c false if
+   *         the file could not be opened or the PVD has already been
+   *         finalised.
    */
-  bool writeGrid2D(const Grid2D &grid, const std::string &id);
+  template <typename Layout>
+  bool writeGrid2D(const BasicGrid2D<Layout> &grid, const std::string &id,
+                   double time) {
+    varType *dst = beginFrame(grid.nx, grid.ny, {id});
+    if (!dst)
+      return false;
+    grid.CopyToRowMajor(dst);
+    return endFrame(time);
+  }
+
+  /**
+   * @brief Start a frame of several cell arrays sharing one nx × ny piece.
+   *
+   * The caller fills the returned buffer with one array per name, each
+   * nx × ny values in row-major order, stored back to back in the order of
+   * @p names, and then calls @c endFrame(). The buffer is @c values_, or a
+   * pooled snapshot in asynchronous mode.
+   *
+   * @param nx      Cells in x.
+   * @param ny      Cells in y (of this rank's piece after @c setPiece()).
+   * @param names   Array names embedded in the VTK XML.
+   * @param wholeNy Cells in y of the whole domain, for pieces; 0 = @p ny.
+   * @return Buffer of names.size() · nx · ny values, or @c nullptr if the
+   *         PVD has already been finalised.
+   */
+  [[nodiscard]] varType *beginFrame(int nx, int ny,
+                                    std::vector<std::string> names,
+                                    int wholeNy = 0);
+
+  /**
+   * @brief Write (or queue) the frame filled since @c beginFrame() and
+   *        append its PVD entry.
+   * @param time Simulation time of the frame (PVD @c timestep attribute).
+   * @return @c true on success (asynchronous mode: once queued).
+   */
+  bool endFrame(double time);
 
   /**
    * @brief Write the PVD index file and mark the writer as finalised.
    *
+   * In asynchronous mode, first waits until every queued frame is on disk.
    * Called automatically by the destructor if not called explicitly.
    * Subsequent calls are no-ops.
    */
   void finalisePVD();
 
+  /// @return Base name of the .vti files and the .pvd.
+  [[nodiscard]] const std::string &name() const { return base_name_; }
+
+  /// @return Frames written so far, i.e. the number of the next frame.
+  [[nodiscard]] int frameCount() const { return current_step_; }
+
+  /// @return PVD @c \<DataSet\> lines of the frames written so far.
+  [[nodiscard]] const std::vector<std::string> &pvdEntries() const {
+    return pvd_entries_;
+  }
+
+  /**
+   * @brief Continue the series of an earlier run (restart): the next frame
+   *        gets number @p frames and the index keeps @p entries.
+   * @param frames  Frames already written.
+   * @param entries Their PVD @c \<DataSet\> lines.
+   */
+  void restoreState(int frames, std::vector<std::string> entries);
+
+  /**
+   * @brief Write the frames as one rank's piece of a distributed run.
+   *
+   * Piece k of a frame starts at row @p rowStarts[k] and ends where piece
+   * k + 1 starts (the last one at the frame's @c wholeNy), so the same
+   * split serves grids with one row more or less than the pressure.
+   *
+   * @param rank      Rank of this writer.
+   * @param rowStarts First row of every rank's piece, in rank order.
+   */
+  void setPiece(int rank, std::vector<int> rowStarts);
+
 private:
   std::string output_dir_; ///< Destination directory.
   std::string base_name_;  ///< Prefix for .vti files and stem for the .pvd.
   int current_step_;       ///< Monotonically increasing frame counter.
   bool pvd_finalised_;     ///< Guard against double-finalisation.
+  AsyncOutput *async_;     ///< Background writer, or null (synchronous).
+  OutputCompression zip_;  ///< zlib level and block size.
+  int piece_rank_ = -1;    ///< Rank of a piece writer, -1 for whole frames.
+  std::vector<int> piece_rows_; ///< First row of every rank's piece.
 
   std::vector<std::string> pvd_entries_; ///< Accumulated XML DataSet lines.
+  std::vector<varType> values_; ///< Frame buffer (synchronous mode).
+
+  // Frame under construction (beginFrame() … endFrame())
+  int frame_nx_ = 0;                     ///< Cells in x.
+  int frame_ny_ = 0;                     ///< Cells in y.
+  int frame_whole_ny_ = 0;               ///< Cells in y of the domain.
+  std::vector<std::string> frame_names_; ///< Array names, in buffer order.
+  AsyncOutput::Buffer snapshot_;         ///< Frame buffer (async mode).
+
+  /**
+   * @brief Encode @p values and write them as a complete .vti file.
+   *
+   * Touches no writer state, so it is safe on the background threads.
+   *
+   * @param values   names.size() row-major arrays (nx × ny), back to back.
+   * @param nx       Cells in x.
+   * @param ny       Cells in y.
+   * @param row0     First row of the piece in the whole domain.
+   * @param wholeNy  Cells in y of the whole domain.
+   * @param names    Array names embedded in the VTK XML.
+   * @param vti_path Destination file.
+   * @param zip      Compression level and block size.
+   * @param parallel Compress the blocks with an OpenMP team (off on the
+   *                 background threads, which already run in parallel).
+   * @return @c true on success.
+   */
+  static bool writeFile(const std::vector<varType> &values, int nx, int ny,
+                        int row0, int wholeNy,
+                        const std::vector<std::string> &names,
+                        const std::string &vti_path,
+                        const OutputCompression &zip, bool parallel);
+
+  /**
+   * @brief Write the .pvti index of the pieces of the current frame.
+   * @param pvti_path Destination file.
+   * @param step      Zero-based frame index (names the piece files).
+   * @return @c true on success.
+   */
+  bool writePieceIndex(const std::string &pvti_path, int step) const;
 
   /**
    * @brief Build the .vti filename for a given field and step.
    * @param field_name Field identifier (e.g. @c "u").
    * @param step       Zero-based frame index.
+   * @param suffix     End of the name: @c "_p3.vti" for a piece,
+   *                   @c ".pvti" for a piece index.
    * @return Filename string, e.g. @c "u_0042.vti".
    */
-  [[nodiscard]] std::string formatFilename(const std::string &field_name,
-                                           int step) const;
+  [[nodiscard]] std::string
+  formatFilename(const std::string &field_name, int step,
+                 const std::string &suffix = ".vti") const;
 
   /**
    * @brief Append one @c \<DataSet\> line to the PVD entry list.
@@ -101,16 +255,19 @@ private:
   void appendPVDEntry(const std::string &vti_filename, double time_value);
 
   /**
-   * @brief Compress @p values with zlib (if available) or return raw bytes.
+   * @brief Build the appended binary block of one array: the VTK header
+   *        word(s) followed by the zlib-compressed blocks (or the raw bytes
+   *        without zlib).
    *
-   * The returned buffer is the payload that follows the VTK binary header —
-   * it does **not** include the uint32_t header word(s).
-   *
-   * @param values Source data in simulation precision.
-   * @return Compressed (or raw) byte buffer ready to write.
+   * @param values   Source data in simulation precision.
+   * @param n        Number of values.
+   * @param zip      Compression level and block size.
+   * @param parallel Compress the blocks with an OpenMP team.
+   * @return Bytes of this array in the appended data section.
    */
   [[nodiscard]] static std::vector<unsigned char>
-  preparePayload(const std::vector<varType> &values);
+  preparePayload(const varType *values, std::size_t n,
+                 const OutputCompression &zip, bool parallel);
 
   /// @return VTK type string: @c "Float32" or @c "Float64".
   static constexpr const char *vtkTypeName() noexcept {
@@ -121,3 +278,5 @@ private:
 #endif
   }
 };
+
+} // namespace PIC_REAL
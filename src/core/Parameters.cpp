@@ -1,10 +1,13 @@
 #include "Parameters.hpp"
 #include "Fields.hpp"
+#include <algorithm>
 #include <cstring>
 #include <fstream>
 #include <iostream>
 #include <string_view>
 
+namespace PIC_REAL {
+
 // SolverConfig
 
 SolverConfig SolverConfig::fromJson(const nlohmann::json &j) {
@@ -16,35 +19,432 @@ SolverConfig SolverConfig::fromJson(const nlohmann::json &j) {
   if (j.contains("tolerance"))
     cfg.tolerance = j["tolerance"].get<double>();
 
+  if (j.contains("warm_start"))
+    cfg.warmStart = j["warm_start"].get<bool>();
+
+  // Map a JSON solver name onto Type; unknown names leave @p out untouched.
+  auto parseType = [](const std::string &t, Type &out) {
+    for (Type candidate :
+         {Type::JACOBI, Type::GAUSS_SEIDEL, Type::RED_BLACK_GAUSS_SEIDEL,
+          Type::PCG, Type::MULTIGRID, Type::SPECTRAL}) {
+      if (t == typeName(candidate)) {
+        out = candidate;
+        return true;
+      }
+    }
+    return false;
+  };
+
   if (j.contains("type")) {
     const std::string t = j["type"].get<std::string>();
-    if (t == "jacobi")
-      cfg.type = Type::JACOBI;
-    else if (t == "gauss_seidel")
-      cfg.type = Type::GAUSS_SEIDEL;
-    else if (t == "red_black_gauss_seidel")
-      cfg.type = Type::RED_BLACK_GAUSS_SEIDEL;
-    else
+    if (!parseType(t, cfg.type))
       std::cerr << "[SolverConfig] Unknown solver type '" << t
                 << "' – defaulting to gauss_seidel.\n";
   }
+
+  if (j.contains("fallback")) {
+    const std::string t = j["fallback"].get<std::string>();
+    if (!parseType(t, cfg.fallback) || cfg.fallback == Type::SPECTRAL) {
+      std::cerr << "[SolverConfig] Invalid fallback solver '" << t
+                << "' – defaulting to pcg.\n";
+      cfg.fallback = Type::PCG;
+    }
+  }
+
+  if (j.contains("preconditioner")) {
+    const std::string pc = j["preconditioner"].get<std::string>();
+    if (pc == "none")
+      cfg.preconditioner = Preconditioner::NONE;
+    else if (pc == "mic0")
+      cfg.preconditioner = Preconditioner::MIC0;
+    else if (pc == "multigrid")
+      cfg.preconditioner = Preconditioner::MULTIGRID;
+    else if (pc == "spectral")
+      cfg.preconditioner = Preconditioner::SPECTRAL;
+    else
+      std::cerr << "[SolverConfig] Unknown preconditioner '" << pc
+                << "' – defaulting to mic0.\n";
+  }
+
+  if (j.contains("mic_tau"))
+    cfg.micTau = j["mic_tau"].get<double>();
+
+  if (j.contains("mic_sigma"))
+    cfg.micSigma = j["mic_sigma"].get<double>();
+
+  if (j.contains("mg_cycle")) {
+    const std::string c = j["mg_cycle"].get<std::string>();
+    if (c == "v")
+      cfg.mgCycle = Cycle::V;
+    else if (c == "w")
+      cfg.mgCycle = Cycle::W;
+    else
+      std::cerr << "[SolverConfig] Unknown multigrid cycle '" << c
+                << "' – defaulting to v.\n";
+  }
+
+  if (j.contains("mg_pre_smooth"))
+    cfg.mgPreSmooth = j["mg_pre_smooth"].get<int>();
+
+  if (j.contains("mg_post_smooth"))
+    cfg.mgPostSmooth = j["mg_post_smooth"].get<int>();
+
+  if (j.contains("mg_coarse_sweeps"))
+    cfg.mgCoarseSweeps = j["mg_coarse_sweeps"].get<int>();
+
+  if (j.contains("mg_min_size"))
+    cfg.mgMinSize = std::max(2, j["mg_min_size"].get<int>());
+
+  if (j.contains("precision")) {
+    const std::string p = j["precision"].get<std::string>();
+    if (p == "working")
+      cfg.precision = Precision::WORKING;
+    else if (p == "mixed")
+      cfg.precision = Precision::MIXED;
+    else
+      std::cerr << "[SolverConfig] Unknown precision '" << p
+                << "' – defaulting to working.\n";
+    if (cfg.precision == Precision::MIXED && !cfg.usesMultigrid())
+      std::cerr << "[SolverConfig] Mixed precision applies to multigrid "
+                   "cycles only – ignored by "
+                << cfg.typeName() << ".\n";
+  }
   return cfg;
 }
 
-std::string SolverConfig::typeName() const {
-  switch (type) {
+std::string SolverConfig::typeName(const Type t) {
+  switch (t) {
   case Type::JACOBI:
     return "jacobi";
   case Type::GAUSS_SEIDEL:
     return "gauss_seidel";
   case Type::RED_BLACK_GAUSS_SEIDEL:
     return "red_black_gauss_seidel";
+  case Type::PCG:
+    return "pcg";
+  case Type::MULTIGRID:
+    return "multigrid";
+  case Type::SPECTRAL:
+    return "spectral";
+  }
+  return "unknown"; // unreachable, silences -Wreturn-type
+}
+
+std::string SolverConfig::preconditionerName() const {
+  switch (preconditioner) {
+  case Preconditioner::NONE:
+    return "none";
+  case Preconditioner::MIC0:
+    return "mic0";
+  case Preconditioner::MULTIGRID:
+    return "multigrid";
+  case Preconditioner::SPECTRAL:
+    return "spectral";
   }
   return "unknown"; // unreachable, silences -Wreturn-type
 }
 
+bool SolverConfig::usesMultigrid() const {
+  const Type used = (type == Type::SPECTRAL) ? fallback : type;
+  return used == Type::MULTIGRID ||
+         (used == Type::PCG && preconditioner == Preconditioner::MULTIGRID);
+}
+
+// TransportConfig
+
+TransportConfig TransportConfig::fromJson(const nlohmann::json &j) {
+  TransportConfig cfg;
+
+  if (j.contains("scheme")) {
+    const std::string s = j["scheme"].get<std::string>();
+    if (s == "semi_lagrangian")
+      cfg.scheme = Scheme::SEMI_LAGRANGIAN;
+    else if (s == "pic")
+      cfg.scheme = Scheme::PIC;
+    else if (s == "flip")
+      cfg.scheme = Scheme::FLIP;
+    else if (s == "apic")
+      cfg.scheme = Scheme::APIC;
+    else
+      std::cerr << "[TransportConfig] Unknown transport scheme '" << s
+                << "' – defaulting to semi_lagrangian.\n";
+  }
+
+  if (j.contains("advection")) {
+    const std::string s = j["advection"].get<std::string>();
+    if (s == "semi_lagrangian")
+      cfg.advection = Advection::SEMI_LAGRANGIAN;
+    else if (s == "maccormack")
+      cfg.advection = Advection::MACCORMACK;
+    else if (s == "bfecc")
+      cfg.advection = Advection::BFECC;
+    else
+      std::cerr << "[TransportConfig] Unknown advection scheme '" << s
+                << "' – defaulting to semi_lagrangian.\n";
+  }
+
+  if (j.contains("interpolation")) {
+    auto parse = [](const nlohmann::json &value, Interpolation &dst) {
+      const std::string s = value.get<std::string>();
+      if (s == "linear")
+        dst = Interpolation::LINEAR;
+      else if (s == "cubic")
+        dst = Interpolation::CUBIC;
+      else
+        std::cerr << "[TransportConfig] Unknown interpolation '" << s
+                  << "' – defaulting to linear.\n";
+    };
+    const nlohmann::json &interp = j["interpolation"];
+    if (interp.is_string()) {
+      parse(interp, cfg.velocityInterpolation);
+      cfg.smokeInterpolation = cfg.velocityInterpolation;
+    } else {
+      if (interp.contains("velocity"))
+        parse(interp["velocity"], cfg.velocityInterpolation);
+      if (interp.contains("smoke"))
+        parse(interp["smoke"], cfg.smokeInterpolation);
+    }
+  }
+
+  if (j.contains("flip_ratio"))
+    cfg.flipRatio = std::clamp(j["flip_ratio"].get<double>(), 0.0, 1.0);
+
+  if (j.contains("particles_per_cell"))
+    cfg.particlesPerCell = std::max(1, j["particles_per_cell"].get<int>());
+
+  if (j.contains("sort_interval"))
+    cfg.sortInterval = std::max(0, j["sort_interval"].get<int>());
+
+  // The per-cell bounds follow particles_per_cell unless given explicitly.
+  cfg.minPerCell = cfg.particlesPerCell / 2;
+  cfg.maxPerCell = 3 * cfg.particlesPerCell;
+  if (j.contains("min_particles_per_cell"))
+    cfg.minPerCell = std::max(0, j["min_particles_per_cell"].get<int>());
+  if (j.contains("max_particles_per_cell"))
+    cfg.maxPerCell = std::max(0, j["max_particles_per_cell"].get<int>());
+  return cfg;
+}
+
+std::string TransportConfig::schemeName() const {
+  switch (scheme) {
+  case Scheme::SEMI_LAGRANGIAN:
+    return "semi_lagrangian";
+  case Scheme::PIC:
+    return "pic";
+  case Scheme::FLIP:
+    return "flip";
+  case Scheme::APIC:
+    return "apic";
+  }
+  return "unknown"; // unreachable, silences -Wreturn-type
+}
+
+std::string TransportConfig::advectionName() const {
+  switch (advection) {
+  case Advection::SEMI_LAGRANGIAN:
+    return "semi_lagrangian";
+  case Advection::MACCORMACK:
+    return "maccormack";
+  case Advection::BFECC:
+    return "bfecc";
+  }
+  return "unknown"; // unreachable, silences -Wreturn-type
+}
+
+std::string
+TransportConfig::interpolationName(const Interpolation interpolation) {
+  return interpolation == Interpolation::CUBIC ? "cubic" : "linear";
+}
+
+// OutputConfig
+
+OutputConfig OutputConfig::fromJson(const nlohmann::json &j) {
+  OutputConfig cfg;
+  if (j.contains("combined"))
+    cfg.combined = j["combined"].get<bool>();
+  if (j.contains("async"))
+    cfg.async = j["async"].get<bool>();
+  if (j.contains("io_threads"))
+    cfg.ioThreads = std::max(1, j["io_threads"].get<int>());
+  if (j.contains("queue_depth"))
+    cfg.queueDepth = std::max(1, j["queue_depth"].get<int>());
+  if (j.contains("compression_level"))
+    cfg.compressionLevel = std::clamp(j["compression_level"].get<int>(), 0, 9);
+  if (j.contains("block_size_kib"))
+    cfg.blockSizeKiB = std::clamp(j["block_size_kib"].get<int>(), 4, 65536);
+  return cfg;
+}
+
+// TimeStepConfig
+
+TimeStepConfig TimeStepConfig::fromJson(const nlohmann::json &j) {
+  TimeStepConfig cfg;
+  if (j.contains("adaptive"))
+    cfg.adaptive = j["adaptive"].get<bool>();
+  if (j.contains("cfl"))
+    cfg.cfl = std::max(1e-6, j["cfl"].get<double>());
+  if (j.contains("dt_min"))
+    cfg.dtMin = std::max(0.0, j["dt_min"].get<double>());
+  if (j.contains("dt_max"))
+    cfg.dtMax = std::max(0.0, j["dt_max"].get<double>());
+  if (j.contains("output_interval"))
+    cfg.outputInterval = std::max(0.0, j["output_interval"].get<double>());
+  if (j.contains("end_time"))
+    cfg.endTime = std::max(0.0, j["end_time"].get<double>());
+  return cfg;
+}
+
+// ViscosityConfig
+
+ViscosityConfig ViscosityConfig::fromJson(const nlohmann::json &j) {
+  ViscosityConfig cfg;
+  if (j.contains("nu"))
+    cfg.nu = std::max(0.0, j["nu"].get<double>());
+
+  if (j.contains("scheme")) {
+    const std::string s = j["scheme"].get<std::string>();
+    if (s == "backward_euler")
+      cfg.scheme = Scheme::BACKWARD_EULER;
+    else if (s == "crank_nicolson")
+      cfg.scheme = Scheme::CRANK_NICOLSON;
+    else
+      std::cerr << "[ViscosityConfig] Unknown scheme '" << s
+                << "' – defaulting to backward_euler.\n";
+  }
+
+  if (j.contains("solver")) {
+    const std::string s = j["solver"].get<std::string>();
+    if (s == "pcg")
+      cfg.solver = SolverConfig::Type::PCG;
+    else if (s == "red_black_gauss_seidel")
+      cfg.solver = SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL;
+    else
+      std::cerr << "[ViscosityConfig] Unsupported solver '" << s
+                << "' – defaulting to pcg.\n";
+  }
+
+  if (j.contains("max_iterations"))
+    cfg.maxIters = std::max(1, j["max_iterations"].get<int>());
+  if (j.contains("tolerance"))
+    cfg.tolerance = j["tolerance"].get<double>();
+  return cfg;
+}
+
+std::string ViscosityConfig::schemeName() const {
+  return scheme == Scheme::CRANK_NICOLSON ? "crank_nicolson"
+                                          : "backward_euler";
+}
+
+// CheckpointConfig
+
+CheckpointConfig CheckpointConfig::fromJson(const nlohmann::json &j) {
+  CheckpointConfig cfg;
+  if (j.contains("interval"))
+    cfg.interval = std::max(0, j["interval"].get<int>());
+  if (j.contains("file"))
+    cfg.file = j["file"].get<std::string>();
+  return cfg;
+}
+
+// ProfileConfig
+
+ProfileConfig ProfileConfig::fromJson(const nlohmann::json &j) {
+  ProfileConfig cfg;
+  if (j.contains("summary"))
+    cfg.summary = j["summary"].get<bool>();
+  if (j.contains("timeline"))
+    cfg.timeline = j["timeline"].get<std::string>();
+  if (j.contains("history"))
+    cfg.history = std::max(1, j["history"].get<int>());
+  return cfg;
+}
+
+// DecompositionConfig
+
+DecompositionConfig DecompositionConfig::fromJson(const nlohmann::json &j) {
+  DecompositionConfig cfg;
+  if (j.contains("enabled"))
+    cfg.enabled = j["enabled"].get<bool>();
+  if (j.contains("check_interval"))
+    cfg.checkInterval = std::max(1, j["check_interval"].get<int>());
+  return cfg;
+}
+
+// DistributedConfig
+
+DistributedConfig DistributedConfig::fromJson(const nlohmann::json &j) {
+  DistributedConfig cfg;
+  if (j.contains("ranks"))
+    cfg.ranks = std::max(1, j["ranks"].get<int>());
+  if (j.contains("transport")) {
+    const std::string s = j["transport"].get<std::string>();
+    if (s == "local")
+      cfg.transport = Transport::LOCAL;
+    else if (s == "mpi")
+#ifdef USE_MPI
+      cfg.transport = Transport::MPI;
+#else
+      std::cerr << "[DistributedConfig] Built without MPI – transport 'mpi' "
+                   "replaced by local ranks.\n";
+#endif
+    else
+      std::cerr << "[DistributedConfig] Unknown transport '" << s
+                << "' – defaulting to local.\n";
+  }
+  if (j.contains("halo"))
+    cfg.halo = std::max(1, j["halo"].get<int>());
+  if (j.contains("check_interval"))
+    cfg.checkInterval = std::max(1, j["check_interval"].get<int>());
+  return cfg;
+}
+
+std::string DistributedConfig::transportName() const {
+  return transport == Transport::MPI ? "mpi" : "local";
+}
+
+// SparseSmokeConfig
+
+SparseSmokeConfig SparseSmokeConfig::fromJson(const nlohmann::json &j) {
+  SparseSmokeConfig cfg;
+  if (j.contains("enabled"))
+    cfg.enabled = j["enabled"].get<bool>();
+  if (j.contains("tile"))
+    cfg.tile = std::max(1, j["tile"].get<int>());
+  if (j.contains("threshold"))
+    cfg.threshold = std::max(0.0, j["threshold"].get<double>());
+  if (j.contains("band"))
+    cfg.band = std::max(0, j["band"].get<int>());
+  return cfg;
+}
+
 // Parameters
 
+namespace {
+
+/**
+ * @brief FNV-1a hash of the keys that define the simulated problem.
+ *
+ * Run length, output and checkpoint settings may change between a run and
+ * its restart, so they are left out. nlohmann::json keeps object keys
+ * sorted, which makes the dump independent of their order in the file.
+ */
+uint64_t hashConfig(nlohmann::json j) {
+  for (const char *key :
+       {"nt", "sampling_rate", "folder", "filename", "write_u", "write_v",
+        "write_p", "write_div", "write_norm_velocity", "write_smoke",
+        "output", "checkpoint", "profile", "decomposition", "distributed"})
+    j.erase(key);
+
+  uint64_t h = 14695981039346656037ull;
+  for (const char c : j.dump()) {
+    h ^= static_cast<unsigned char>(c);
+    h *= 1099511628211ull;
+  }
+  return h;
+}
+
+} // namespace
+
 void Parameters::loadFromJson(const nlohmann::json &j) {
   // Helper lambda: assign a field only if the key is present in the JSON.
   // Using a lambda avoids repeating the j.contains / j[key].get<T>() pattern.
@@ -92,6 +492,117 @@ void Parameters::loadFromJson(const nlohmann::json &j) {
   // Solver
   if (j.contains("solver"))
     solver = SolverConfig::fromJson(j["solver"]);
+
+  // Domain decomposition: the slabs relax the pressure with red-black
+  // Gauss-Seidel, the only solver whose sweeps need nothing but halo rows.
+  if (j.contains("decomposition"))
+    decomposition = DecompositionConfig::fromJson(j["decomposition"]);
+  if (decomposition.enabled &&
+      solver.type != SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL) {
+    std::cerr << "[Parameters] The decomposed step relaxes the pressure with "
+                 "red_black_gauss_seidel – solver '"
+              << solver.typeName() << "' ignored.\n";
+    solver.type = SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL;
+  }
+
+  // Viscosity
+  if (j.contains("viscosity"))
+    viscosity = ViscosityConfig::fromJson(j["viscosity"]);
+
+  // Transport
+  if (j.contains("transport"))
+    transport = TransportConfig::fromJson(j["transport"]);
+
+  // Sparse smoke: the active tiles are those of one first-order trace; the
+  // error-corrected schemes read the smoke of two or three of them.
+  if (j.contains("sparse_smoke"))
+    sparseSmoke = SparseSmokeConfig::fromJson(j["sparse_smoke"]);
+  if (sparseSmoke.enabled &&
+      transport.advection != TransportConfig::Advection::SEMI_LAGRANGIAN) {
+    std::cerr << "[Parameters] Sparse smoke needs semi_lagrangian advection "
+                 "– advection '"
+              << transport.advectionName() << "' keeps the dense smoke.\n";
+    sparseSmoke.enabled = false;
+  }
+
+  // Output pipeline
+  if (j.contains("output"))
+    output = OutputConfig::fromJson(j["output"]);
+
+  // Profiling
+  if (j.contains("profile"))
+    profile = ProfileConfig::fromJson(j["profile"]);
+
+  // Time stepping (dt_max defaults to the fixed dt)
+  if (j.contains("time_step"))
+    timeStep = TimeStepConfig::fromJson(j["time_step"]);
+  if (timeStep.dtMax <= 0.0)
+    timeStep.dtMax = dt;
+  timeStep.dtMin = std::min(timeStep.dtMin, timeStep.dtMax);
+
+  // Checkpoints
+  if (j.contains("checkpoint"))
+    checkpoint = CheckpointConfig::fromJson(j["checkpoint"]);
+  if (checkpoint.file.empty())
+    checkpoint.file = folder + "/checkpoint.bin";
+  configHash = hashConfig(j);
+
+  // Distributed run: every rank owns a slab of rows and sees its
+  // neighbours through halo rows only, which the red-black pressure sweeps
+  // and the semi-Lagrangian traces get by with. Features that need the
+  // whole grid at once are switched off.
+  if (j.contains("distributed"))
+    distributed = DistributedConfig::fromJson(j["distributed"]);
+  if (distributed.enabled()) {
+    auto drop = [](const std::string &what) {
+      std::cerr << "[Parameters] Not supported by a distributed run – "
+                << what << ".\n";
+    };
+    if (solver.type != SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL) {
+      drop("solver '" + solver.typeName() +
+           "' replaced by red_black_gauss_seidel");
+      solver.type = SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL;
+    }
+    if (transport.usesParticles() ||
+        transport.advection != TransportConfig::Advection::SEMI_LAGRANGIAN) {
+      drop("transport '" + transport.schemeName() + "', advection '" +
+           transport.advectionName() + "' replaced by semi_lagrangian");
+      transport.scheme = TransportConfig::Scheme::SEMI_LAGRANGIAN;
+      transport.advection = TransportConfig::Advection::SEMI_LAGRANGIAN;
+    }
+    if (viscosity.nu > 0.0) {
+      drop("viscosity ignored");
+      viscosity.nu = 0.0;
+    }
+    if (decomposition.enabled) {
+      drop("decomposition ignored");
+      decomposition.enabled = false;
+    }
+    if (checkpoint.interval > 0) {
+      drop("no checkpoints");
+      checkpoint.interval = 0;
+    }
+    if (sparseSmoke.enabled) {
+      drop("sparse smoke ignored");
+      sparseSmoke.enabled = false;
+    }
+    // A trace must move at least one row and keep its stencil in the halo.
+    const int minHalo = transport.stencilReach() + 1;
+    if (distributed.halo < minHalo) {
+      drop("halo of " + std::to_string(distributed.halo) +
+           " rows raised to " + std::to_string(minHalo) +
+           " (interpolation stencil plus one row)");
+      distributed.halo = minHalo;
+    }
+    // Each rank fills its neighbours' halos from its own rows alone.
+    const int maxRanks = std::max(1, ny / (distributed.halo + 1));
+    if (distributed.ranks > maxRanks) {
+      drop(std::to_string(distributed.ranks) + " ranks of at least " +
+           std::to_string(distributed.halo + 1) + " rows reduced to " +
+           std::to_string(maxRanks));
+      distributed.ranks = maxRanks;
+    }
+  }
 }
 
 void Parameters::applyToFields(Fields2D &fields) const {
@@ -136,32 +647,132 @@ bool Parameters::loadFromFile(const std::string &path) {
 }
 
 bool Parameters::parseCommandLine(int argc, char *argv[]) {
-  // Expect exactly:  <prog> -c <path>  or  <prog> --config <path>
-  if (argc == 3) {
-    const std::string_view flag = argv[1];
+  // Expect:  <prog> -c <path> [--restart <checkpoint>], in any order
+  std::string config;
+  bool ok = (argc % 2 == 1); // flag / value pairs
+  for (int a = 1; ok && a + 1 < argc; a += 2) {
+    const std::string_view flag = argv[a];
     if (flag == "-c" || flag == "--config")
-      return loadFromFile(argv[2]);
+      config = argv[a + 1];
+    else if (flag == "--restart")
+      restartFile = argv[a + 1];
+    else
+      ok = false;
   }
-  printUsage(argv[0]);
-  return false;
+  if (!ok || config.empty()) {
+    printUsage(argv[0]);
+    return false;
+  }
+  return loadFromFile(config);
 }
 
 void Parameters::printUsage(const char *prog) {
   // RTFM
-  std::cout << "Usage: " << prog << " -c <config.json>\n";
+  std::cout << "Usage: " << prog
+            << " -c <config.json> [--restart <checkpoint.bin>]\n";
 }
 
 std::ostream &operator<<(std::ostream &os, const Parameters &p) {
   os << "\n=== Simulation Parameters ===\n"
      << "  Grid    : " << p.nx << " x " << p.ny << "  dx=" << p.dx
-     << "  dy=" << p.dy << '\n'
-     << "  Time    : nt=" << p.nt << "  dt=" << p.dt << '\n'
-     << "  Density : " << p.density << '\n'
-     << "  Sampling: every " << p.sampling_rate << " step(s)" << '\n'
+     << "  dy=" << p.dy << "  " << PRECISION_STRING << '\n'
+     << "  Time    : "
+     << (p.timeStep.endTime > 0.0
+             ? "until t=" + std::to_string(p.timeStep.endTime)
+             : "nt=" + std::to_string(p.nt))
+     << (p.timeStep.adaptive
+             ? "  adaptive dt, CFL " + std::to_string(p.timeStep.cfl) +
+                   " in [" + std::to_string(p.timeStep.dtMin) + ", " +
+                   std::to_string(p.timeStep.dtMax) + "]"
+             : "  dt=" + std::to_string(p.dt))
+     << '\n'
+     << "  Density : " << p.density
+     << (p.viscosity.nu > 0.0
+             ? "  nu=" + std::to_string(p.viscosity.nu) + " (" +
+                   p.viscosity.schemeName() + ", " +
+                   SolverConfig::typeName(p.viscosity.solver) + ")"
+             : std::string())
+     << '\n'
+     << "  Sampling: "
+     << (p.timeStep.outputInterval > 0.0
+             ? "every " + std::to_string(p.timeStep.outputInterval) + " s"
+             : "every " + std::to_string(p.sampling_rate) + " step(s)")
+     << '\n'
      << "  Solver  : " << p.solver.typeName()
      << "  maxIter=" << p.solver.maxIters << "  tol=" << p.solver.tolerance
+     << "  warm=" << p.solver.warmStart
+     << (p.solver.type == SolverConfig::Type::PCG
+             ? "  precond=" + p.solver.preconditionerName()
+             : std::string())
+     << (p.solver.type == SolverConfig::Type::SPECTRAL
+             ? "  fallback=" + SolverConfig::typeName(p.solver.fallback)
+             : std::string())
+     << (p.solver.type == SolverConfig::Type::MULTIGRID ||
+                 p.solver.preconditioner ==
+                     SolverConfig::Preconditioner::MULTIGRID
+             ? std::string("  cycle=") +
+                   (p.solver.mgCycle == SolverConfig::Cycle::W ? "w" : "v")
+             : std::string())
+     << (p.solver.usesMultigrid() &&
+                 p.solver.precision == SolverConfig::Precision::MIXED
+             ? "  precision=mixed"
+             : std::string())
+     << (p.decomposition.enabled
+             ? "  decomposed, residual every " +
+                   std::to_string(p.decomposition.checkInterval) + " iters"
+             : std::string())
+     << (p.distributed.enabled()
+             ? "  distributed (" + p.distributed.transportName() + ", " +
+                   (p.distributed.transport ==
+                            DistributedConfig::Transport::MPI
+                        ? std::string("one rank per process")
+                        : std::to_string(p.distributed.ranks) + " ranks") +
+                   "), halo " + std::to_string(p.distributed.halo) +
+                   " rows, residual every " +
+                   std::to_string(p.distributed.checkInterval) + " iters"
+             : std::string())
+     << '\n'
+     << "  Advect  : " << p.transport.schemeName()
+     << (p.transport.advection != TransportConfig::Advection::SEMI_LAGRANGIAN
+             ? "  grid: " + p.transport.advectionName()
+             : std::string())
+     << "  interp: velocity "
+     << TransportConfig::interpolationName(p.transport.velocityInterpolation)
+     << ", smoke "
+     << TransportConfig::interpolationName(p.transport.smokeInterpolation)
+     << (p.sparseSmoke.enabled
+             ? "  sparse smoke: " + std::to_string(p.sparseSmoke.tile) +
+                   "-cell tiles, threshold " +
+                   std::to_string(p.sparseSmoke.threshold) + ", band " +
+                   std::to_string(p.sparseSmoke.band)
+             : std::string())
+     << (p.transport.scheme == TransportConfig::Scheme::FLIP
+             ? "  flip_ratio=" + std::to_string(p.transport.flipRatio)
+             : std::string())
+     << (p.transport.usesParticles()
+             ? "  ppc=" + std::to_string(p.transport.particlesPerCell) +
+                   " [" + std::to_string(p.transport.minPerCell) + ", " +
+                   std::to_string(p.transport.maxPerCell) +
+                   "]  sort every " + std::to_string(p.transport.sortInterval)
+             : std::string())
+     << '\n'
+     << "  Output  : folder='" << p.folder << "'"
+     << (p.output.combined ? "  combined" : "  per field")
+     << (p.output.async ? "  async: " + std::to_string(p.output.ioThreads) +
+                              " thread(s), " +
+                              std::to_string(p.output.queueDepth) +
+                              " frame(s) queued"
+                        : std::string("  sync"))
+     << "  zlib level " << p.output.compressionLevel << ", "
+     << p.output.blockSizeKiB << " KiB blocks\n"
+     << "  Restart : "
+     << (p.checkpoint.interval > 0
+             ? "checkpoint every " + std::to_string(p.checkpoint.interval) +
+                   " step(s) to '" + p.checkpoint.file + "'"
+             : std::string("no checkpoints"))
+     << (p.restartFile.empty() ? std::string()
+                               : "  resume from '" + p.restartFile + "'")
      << '\n'
-     << "  Output  : folder='" << p.folder << "'\n"
      << "  Write   : u=" << p.write_u << " v=" << p.write_v
      << " p=" << p.write_p << " div=" << p.write_div
      << " norm=" << p.write_norm_velocity << '\n'
@@ -174,3 +785,5 @@ std::ostream &operator<<(std::ostream &os, const Parameters &p) {
      << "=============================\n";
   return os;
 }
+
+} // namespace PIC_REAL
@@ -1,5 +1,6 @@
 #pragma once
 #include "SceneObjects.hpp"
+#include <cstdint>
 #include <nlohmann/json.hpp>
 #include <ostream>
 #include <string>
@@ -9,6 +10,8 @@
  * @brief Simulation configuration loaded from a JSON file.
  */
 
+namespace PIC_REAL {
+
 // Forward declaration — avoids pulling Fields2D into every translation unit
 // that only needs grid dimensions or time-step values.
 class Fields2D;
@@ -22,18 +25,59 @@ struct SolverConfig {
   enum class Type {
     JACOBI,       ///< Jacobi iteration (parallelisable, slow convergence).
     GAUSS_SEIDEL, ///< Gauss-Seidel (faster convergence, sequential).
-    RED_BLACK_GAUSS_SEIDEL ///< Red-black GS (parallelisable + fast
-                           ///< convergence).
+    RED_BLACK_GAUSS_SEIDEL, ///< Red-black GS (parallelisable + fast
+                            ///< convergence).
+    PCG,       ///< Preconditioned Conjugate Gradient over the FLUID cells.
+    MULTIGRID, ///< Geometric multigrid cycles on the residual equation.
+    SPECTRAL   ///< Direct DCT/DST solve; rectangular fluid regions only.
+  };
+
+  /// Preconditioners available to the Krylov (PCG) solver.
+  enum class Preconditioner {
+    NONE,     ///< Plain Conjugate Gradient.
+    MIC0,      ///< Modified Incomplete Cholesky, level 0.
+    MULTIGRID, ///< One geometric multigrid cycle per application.
+    SPECTRAL   ///< Exact solve on the fluid bounding box, obstacles filled.
+  };
+
+  /// Arithmetic of the multigrid hierarchy.
+  enum class Precision {
+    WORKING, ///< Levels stored and smoothed in @c varType (default).
+    MIXED    ///< Levels in float; residual and update of p stay in varType.
+  };
+
+  /// Multigrid recursion shape.
+  enum class Cycle {
+    V, ///< One coarse-grid visit per level.
+    W  ///< Two coarse-grid visits per level (more robust, ~2x work).
   };
 
   Type type = Type::GAUSS_SEIDEL; ///< Solver algorithm.
   int maxIters = 1000;            ///< Maximum number of iterations per step.
   double tolerance = 1e-2;        ///< Relative residual convergence threshold.
+  bool warmStart = true; ///< Start from the previous step's pressure field.
+
+  Preconditioner preconditioner = Preconditioner::MIC0; ///< PCG only.
+  /// Solver used by SPECTRAL when the fluid region is not a rectangle.
+  Type fallback = Type::PCG;
+  double micTau = 0.97;   ///< MIC(0) modification parameter (0 = plain IC).
+  double micSigma = 0.25; ///< MIC(0) safety threshold on the pivot.
+
+  Cycle mgCycle = Cycle::V; ///< Multigrid cycle type.
+  int mgPreSmooth = 2;      ///< Red-black sweeps before restriction.
+  int mgPostSmooth = 2;     ///< Red-black sweeps after prolongation.
+  int mgCoarseSweeps = 32;  ///< Red-black sweeps on the coarsest level.
+  int mgMinSize = 8;        ///< Stop coarsening below this many cells.
+  /// Storage of the multigrid levels (solver and preconditioner).
+  Precision precision = Precision::WORKING;
 
   /**
    * @brief Construct a SolverConfig from a JSON object.
    *
-   * Recognised keys: @c "type", @c "max_iterations", @c "tolerance".
+   * Recognised keys: @c "type", @c "max_iterations", @c "tolerance",
+   * @c "warm_start", @c "preconditioner", @c "fallback", @c "mic_tau",
+   * @c "mic_sigma", @c "mg_cycle", @c "mg_pre_smooth", @c "mg_post_smooth",
+   * @c "mg_coarse_sweeps", @c "mg_min_size", @c "precision".
    * Unknown solver types fall back to GAUSS_SEIDEL with a warning.
    *
    * @param j JSON object node.
@@ -42,7 +86,336 @@ struct SolverConfig {
   [[nodiscard]] static SolverConfig fromJson(const nlohmann::json &j);
 
   /// @return The solver type as a lowercase string (matches JSON key values).
-  [[nodiscard]] std::string typeName() const;
+  [[nodiscard]] std::string typeName() const { return typeName(type); }
+
+  /// @return @p t as a lowercase string (matches JSON key values).
+  [[nodiscard]] static std::string typeName(Type t);
+
+  /// @return The preconditioner as a lowercase string (matches JSON values).
+  [[nodiscard]] std::string preconditionerName() const;
+
+  /// @return @c true if the configured solve runs multigrid cycles (as the
+  ///         solver, the PCG preconditioner or the spectral fallback).
+  [[nodiscard]] bool usesMultigrid() const;
+};
+
+// TransportConfig
+/**
+ * @brief Configuration of the velocity transport (advection) scheme.
+ */
+struct TransportConfig {
+  /// Available transport schemes.
+  enum class Scheme {
+    SEMI_LAGRANGIAN, ///< Grid-only RK2 backward trace (default).
+    PIC,             ///< Particle-in-Cell: particles take the grid velocity.
+    FLIP,            ///< PIC/FLIP blend controlled by @c flipRatio.
+    APIC             ///< Affine PIC: particles carry a velocity gradient.
+  };
+
+  /// Grid advection of the semi-Lagrangian velocity and of the smoke.
+  enum class Advection {
+    SEMI_LAGRANGIAN, ///< One RK2 backward trace, bilinear (default).
+    MACCORMACK,      ///< Backward + forward trace, error-corrected, limited.
+    BFECC            ///< Back and forth error compensation, limited.
+  };
+
+  /// Interpolation of a field at the departure points of its advection.
+  enum class Interpolation {
+    LINEAR, ///< Bilinear, 2 × 2 nodes (default).
+    CUBIC   ///< Monotone (clamped) Catmull-Rom, 4 × 4 nodes.
+  };
+
+  Scheme scheme = Scheme::SEMI_LAGRANGIAN; ///< Transport scheme.
+  /// Grid advection scheme (smoke always; velocity with SEMI_LAGRANGIAN).
+  Advection advection = Advection::SEMI_LAGRANGIAN;
+  /// Interpolation of the advected velocity (semi-Lagrangian transport).
+  Interpolation velocityInterpolation = Interpolation::LINEAR;
+  /// Interpolation of the advected smoke.
+  Interpolation smokeInterpolation = Interpolation::LINEAR;
+  /// FLIP share of the particle update (0 = pure PIC, 1 = pure FLIP).
+  double flipRatio = 0.95;
+  int particlesPerCell = 4; ///< Particles seeded per FLUID cell.
+  /// Re-sort particles by cell every N steps (0 = never).
+  int sortInterval = 10;
+  /// On re-sort, top up FLUID cells holding fewer particles (0 = off).
+  /// Defaults to half of @c particlesPerCell.
+  int minPerCell = 2;
+  /// On re-sort, drop particles beyond this count per cell (0 = off).
+  /// Defaults to three times @c particlesPerCell.
+  int maxPerCell = 12;
+
+  /**
+   * @brief Construct a TransportConfig from a JSON object.
+   *
+   * Recognised keys: @c "scheme", @c "advection", @c "interpolation",
+   * @c "flip_ratio", @c "particles_per_cell", @c "sort_interval",
+   * @c "min_particles_per_cell", @c "max_particles_per_cell".
+   * @c "interpolation" is @c "linear" or @c "cubic" for both fields, or an
+   * object with @c "velocity" and @c "smoke" keys.
+   * Unknown schemes fall back to SEMI_LAGRANGIAN with a warning.
+   *
+   * @param j JSON object node.
+   * @return  Populated TransportConfig.
+   */
+  [[nodiscard]] static TransportConfig fromJson(const nlohmann::json &j);
+
+  /// @return @c true for the particle-based schemes.
+  [[nodiscard]] bool usesParticles() const {
+    return scheme != Scheme::SEMI_LAGRANGIAN;
+  }
+
+  /// @return Cells the interpolation stencil reaches past a departure
+  ///         point: 2 when either field is cubic, else 1.
+  [[nodiscard]] int stencilReach() const {
+    return (velocityInterpolation == Interpolation::CUBIC ||
+            smokeInterpolation == Interpolation::CUBIC)
+               ? 2
+               : 1;
+  }
+
+  /// @return The scheme as a lowercase string (matches JSON key values).
+  [[nodiscard]] std::string schemeName() const;
+
+  /// @return The advection scheme as a lowercase string (JSON key value).
+  [[nodiscard]] std::string advectionName() const;
+
+  /// @return @p interpolation as a lowercase string (JSON key value).
+  [[nodiscard]] static std::string
+  interpolationName(Interpolation interpolation);
+};
+
+// OutputConfig
+/**
+ * @brief Configuration of the .vti output pipeline.
+ */
+struct OutputConfig {
+  /// Write every enabled field into one .vti per output step (one .pvd per
+  /// run), with u and v averaged to cell centres; otherwise one file series
+  /// per field.
+  bool combined = false;
+  /// Encode and write frames on background threads (see AsyncOutput).
+  bool async = false;
+  int ioThreads = 2; ///< Background writer threads (async only).
+  /// Output frames that may be queued before the solver waits (async only).
+  /// Every frame holds one snapshot per written field; 2 double-buffers.
+  int queueDepth = 2;
+  /// zlib level: 0 (store) … 9 (smallest), 1 favours speed.
+  int compressionLevel = 1;
+  /// Uncompressed size of each independently compressed block, in KiB.
+  int blockSizeKiB = 128;
+
+  /**
+   * @brief Construct an OutputConfig from a JSON object.
+   *
+   * Recognised keys: @c "combined", @c "async", @c "io_threads",
+   * @c "queue_depth", @c "compression_level", @c "block_size_kib".
+   *
+   * @param j JSON object node.
+   * @return  Populated OutputConfig.
+   */
+  [[nodiscard]] static OutputConfig fromJson(const nlohmann::json &j);
+};
+
+// TimeStepConfig
+/**
+ * @brief Configuration of the time-step control and the output schedule.
+ */
+struct TimeStepConfig {
+  /// Choose dt every step from the CFL condition instead of the fixed
+  /// @c Parameters::dt (which then only serves as the fallback bound).
+  bool adaptive = false;
+  double cfl = 0.5;   ///< Target max(|u|·dt/dx, |v|·dt/dy).
+  double dtMin = 0.0; ///< Lower bound of the adaptive dt (0 = none).
+  double dtMax = 0.0; ///< Upper bound of the adaptive dt (0: the fixed dt).
+  /// Physical time between output frames; 0 writes every
+  /// @c Parameters::sampling_rate steps. With adaptive stepping, the steps
+  /// before a frame are shortened evenly so that one lands on its time.
+  double outputInterval = 0.0;
+  /// Simulated time at which the run stops; 0 runs @c Parameters::nt steps.
+  double endTime = 0.0;
+
+  /**
+   * @brief Construct a TimeStepConfig from a JSON object.
+   *
+   * Recognised keys: @c "adaptive", @c "cfl", @c "dt_min", @c "dt_max",
+   * @c "output_interval", @c "end_time".
+   *
+   * @param j JSON object node.
+   * @return  Populated TimeStepConfig.
+   */
+  [[nodiscard]] static TimeStepConfig fromJson(const nlohmann::json &j);
+};
+
+// ViscosityConfig
+/**
+ * @brief Configuration of the implicit viscous diffusion of the velocity.
+ */
+struct ViscosityConfig {
+  /// Time discretisation of the diffusion term.
+  enum class Scheme {
+    BACKWARD_EULER, ///< Fully implicit, first order, strongly damping.
+    CRANK_NICOLSON  ///< Half implicit, half explicit, second order.
+  };
+
+  double nu = 0.0; ///< Kinematic viscosity (m²/s); 0 disables the stage.
+  Scheme scheme = Scheme::BACKWARD_EULER; ///< Time discretisation.
+  /// Solver of the Helmholtz systems: PCG (Jacobi-preconditioned) or
+  /// RED_BLACK_GAUSS_SEIDEL.
+  SolverConfig::Type solver = SolverConfig::Type::PCG;
+  int maxIters = 100;      ///< Maximum iterations per step.
+  double tolerance = 1e-6; ///< Relative residual convergence threshold.
+
+  /**
+   * @brief Construct a ViscosityConfig from a JSON object.
+   *
+   * Recognised keys: @c "nu", @c "scheme", @c "solver",
+   * @c "max_iterations", @c "tolerance". Solvers other than @c "pcg" and
+   * @c "red_black_gauss_seidel" fall back to PCG with a warning.
+   *
+   * @param j JSON object node.
+   * @return  Populated ViscosityConfig.
+   */
+  [[nodiscard]] static ViscosityConfig fromJson(const nlohmann::json &j);
+
+  /// @return The scheme as a lowercase string (matches JSON values).
+  [[nodiscard]] std::string schemeName() const;
+};
+
+// CheckpointConfig
+/**
+ * @brief Configuration of the periodic restart checkpoints.
+ */
+struct CheckpointConfig {
+  int interval = 0; ///< Write a checkpoint every N steps (0 = never).
+  /// Checkpoint file, overwritten atomically each time; empty selects
+  /// @c "<folder>/checkpoint.bin".
+  std::string file;
+
+  /**
+   * @brief Construct a CheckpointConfig from a JSON object.
+   *
+   * Recognised keys: @c "interval", @c "file".
+   *
+   * @param j JSON object node.
+   * @return  Populated CheckpointConfig.
+   */
+  [[nodiscard]] static CheckpointConfig fromJson(const nlohmann::json &j);
+};
+
+// ProfileConfig
+/**
+ * @brief Configuration of the per-step phase profiler.
+ */
+struct ProfileConfig {
+  bool summary = true; ///< Print the phase table at the end of the run.
+  /// Per-step timeline written at the end of the run (CSV, or JSON for a
+  /// ".json" name); empty = none.
+  std::string timeline;
+  int history = 10000; ///< Steps kept for the timeline and percentiles.
+
+  /**
+   * @brief Construct a ProfileConfig from a JSON object.
+   *
+   * Recognised keys: @c "summary", @c "timeline", @c "history".
+   *
+   * @param j JSON object node.
+   * @return  Populated ProfileConfig.
+   */
+  [[nodiscard]] static ProfileConfig fromJson(const nlohmann::json &j);
+};
+
+// DecompositionConfig
+/**
+ * @brief Configuration of the domain-decomposed execution of a time step.
+ */
+struct DecompositionConfig {
+  /// Run each step in one parallel region over per-thread row slabs that
+  /// own their pressure data and exchange halo rows point to point.
+  bool enabled = false;
+  /// Test the pressure residual (a global reduction) every N red-black
+  /// iterations; the sweeps in between only synchronise with neighbours.
+  int checkInterval = 4;
+
+  /**
+   * @brief Construct a DecompositionConfig from a JSON object.
+   *
+   * Recognised keys: @c "enabled", @c "check_interval".
+   *
+   * @param j JSON object node.
+   * @return  Populated DecompositionConfig.
+   */
+  [[nodiscard]] static DecompositionConfig fromJson(const nlohmann::json &j);
+};
+
+// DistributedConfig
+/**
+ * @brief Configuration of a run split over several ranks (row slabs of the
+ *        grid, one per rank, exchanging halo rows by messages).
+ */
+struct DistributedConfig {
+  /// Message passing between the ranks.
+  enum class Transport {
+    LOCAL, ///< The ranks are threads of this process (default).
+    MPI    ///< One MPI process per rank (builds with MPI only).
+  };
+
+  /// Ranks of a LOCAL run; an MPI run has one per process instead.
+  int ranks = 1;
+  Transport transport = Transport::LOCAL; ///< Message-passing backend.
+  /// Rows of u, v and the smoke copied from each neighbour every step; must
+  /// cover the departure distance in cells plus the interpolation stencil.
+  /// Raised to the stencil plus one row; a step whose traces would travel
+  /// further advects in sub-steps.
+  int halo = 3;
+  /// Reduce the pressure residual over the ranks every N red-black
+  /// iterations.
+  int checkInterval = 4;
+
+  /**
+   * @brief Construct a DistributedConfig from a JSON object.
+   *
+   * Recognised keys: @c "ranks", @c "transport" (@c "local" or @c "mpi"),
+   * @c "halo", @c "check_interval". @c "mpi" falls back to @c "local" with
+   * a warning in a build without MPI.
+   *
+   * @param j JSON object node.
+   * @return  Populated DistributedConfig.
+   */
+  [[nodiscard]] static DistributedConfig fromJson(const nlohmann::json &j);
+
+  /// @return @c true if the run is split over ranks.
+  [[nodiscard]] bool enabled() const {
+    return ranks > 1 || transport == Transport::MPI;
+  }
+
+  /// @return The transport as a lowercase string (matches JSON key values).
+  [[nodiscard]] std::string transportName() const;
+};
+
+// SparseSmokeConfig
+/**
+ * @brief Configuration of the sparse smoke advection, which traces only the
+ *        tiles of the smoke holding matter and a band around them.
+ */
+struct SparseSmokeConfig {
+  bool enabled = false; ///< Advect the active tiles only.
+  int tile = 16;        ///< Tile edge in cells.
+  /// Smoke at or below this value does not keep a tile active; it is
+  /// dropped once no tile near it is.
+  double threshold = 1e-6;
+  /// Cells added around the distance a trace can travel in a step (plus
+  /// the interpolation stencil) when the active tiles are dilated.
+  int band = 1;
+
+  /**
+   * @brief Construct a SparseSmokeConfig from a JSON object.
+   *
+   * Recognised keys: @c "enabled", @c "tile", @c "threshold", @c "band".
+   *
+   * @param j JSON object node.
+   * @return  Populated SparseSmokeConfig.
+   */
+  [[nodiscard]] static SparseSmokeConfig fromJson(const nlohmann::json &j);
 };
 
 // Parameters
@@ -65,8 +438,11 @@ public:
   int ny = 100;     ///< Number of pressure cells in y.
   int nt = 100;     ///< Total number of time steps to simulate.
 
+  TimeStepConfig timeStep; ///< Adaptive dt and time-based output.
+
   // Physics
   double density = 1000.0; ///< Fluid density (kg/m³).
+  ViscosityConfig viscosity; ///< Implicit viscous diffusion.
 
   // Output
   int sampling_rate = 1;          ///< Write output every N steps.
@@ -82,15 +458,34 @@ public:
   bool write_div = false;           ///< Write divergence field (diagnostic).
   bool write_norm_velocity = false; ///< Write velocity magnitude (diagnostic).
   bool write_smoke = false;         ///< Write smoke (diagnostic).
+  OutputConfig output;              ///< Output pipeline settings.
+
+  // Restart
+  CheckpointConfig checkpoint; ///< Periodic checkpoint settings.
+  std::string restartFile;     ///< Checkpoint to resume from (--restart).
+  /// Hash of the config without the output / run-length keys; a restart
+  /// from a checkpoint with a different hash continues a different setup.
+  uint64_t configHash = 0;
+
+  // Profiling
+  ProfileConfig profile; ///< Phase timing settings.
 
   // Solver
-  SolverConfig solver; ///< Pressure solver settings.
+  SolverConfig solver;       ///< Pressure solver settings.
+  TransportConfig transport; ///< Velocity transport settings.
+  /// Domain-decomposed execution (pressure solved with red-black GS).
+  DecompositionConfig decomposition;
+  /// Multi-rank execution (red-black GS, semi-Lagrangian transport only).
+  DistributedConfig distributed;
+  /// Smoke advected on its active tiles only (semi-Lagrangian smoke).
+  SparseSmokeConfig sparseSmoke;
 
   // Life cycle
   Parameters() = default;
 
   /**
-   * @brief Parse @c -c / @c --config \<path\> from @c argv and load the file.
+   * @brief Parse @c -c / @c --config \<path\> from @c argv and load the file,
+   *        plus an optional @c --restart \<checkpoint\>.
    * @param argc Argument count from @c main.
    * @param argv Argument vector from @c main.
    * @return @c true on success, @c false on error (usage is printed).
@@ -135,3 +530,5 @@ private:
   /// Print command-line usage to stdout.
   static void printUsage(const char *prog);
 };
+
+} // namespace PIC_REAL
@@ -2,16 +2,22 @@
 
 /**
  * @file Precision.hpp
- * @brief Compile-time floating-point precision selection.
+ * @brief Floating-point precision of a translation unit.
  *
- * Define either USE_FLOAT or USE_DOUBLE via CMake to select the working
- * precision for the entire simulation. All numerical fields, grids, and
- * solver variables use @c varType.
+ * CMake compiles the simulation twice, once with USE_FLOAT and once with
+ * USE_DOUBLE, and main() picks one from the config. All numerical fields,
+ * grids, and solver variables use @c varType, and everything that depends
+ * on it is declared in the namespace @c PIC_REAL (@c real32 or @c real64)
+ * so that both copies link into one executable. The namespace is inline:
+ * code of either precision names its types without qualification.
  */
 
 #ifdef USE_FLOAT
 
+#define PIC_REAL real32 ///< Namespace of the float build.
+inline namespace PIC_REAL {
 using varType = float; ///< Simulation floating-point type (32-bit).
+} // namespace PIC_REAL
 
 #define REAL_EPSILON 1e-6f   ///< Small epsilon for float comparisons.
 #define REAL_LITERAL(x) x##f ///< Suffix literal with 'f' for float precision.
@@ -19,7 +25,10 @@ using varType = float; ///< Simulation floating-point type (32-bit).
 
 #elif defined(USE_DOUBLE)
 
+#define PIC_REAL real64 ///< Namespace of the double build.
+inline namespace PIC_REAL {
 using varType = double; ///< Simulation floating-point type (64-bit).
+} // namespace PIC_REAL
 
 #define REAL_EPSILON 1e-15 ///< Small epsilon for double comparisons.
 #define REAL_LITERAL(x) x  ///< No suffix needed for double precision.
@@ -36,6 +45,9 @@ using varType = double; ///< Simulation floating-point type (64-bit).
 // supress wunusedPragma if not compiled with openmp
 #define OMP_PRAGMA(...) _Pragma(#__VA_ARGS__)
 #define GET_TIME() (omp_get_wtime())
+#define THREAD_NUM() (omp_get_thread_num())   ///< Calling thread id.
+#define MAX_THREADS() (omp_get_max_threads()) ///< Size of a parallel team.
+#define TEAM_SIZE() (omp_get_num_threads())   ///< Size of the current team.
 #else
 #include <chrono>
 inline double _wall_time() {
@@ -45,4 +57,7 @@ inline double _wall_time() {
 #define GET_TIME() (_wall_time())
 // Expanded to nothing otherwise
 #define OMP_PRAGMA(...)
+#define THREAD_NUM() (0)
+#define MAX_THREADS() (1)
+#define TEAM_SIZE() (1)
 #endif
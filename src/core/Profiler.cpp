@@ -0,0 +1,220 @@
+#include "Profiler.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <limits>
+#include <numeric>
+#include <utility>
+
+namespace PIC_REAL {
+
+namespace {
+
+/// @return Nearest-rank percentile @p q (0–1) of @p v (reordered).
+double percentile(std::vector<double> &v, const double q) {
+  if (v.empty())
+    return 0.0;
+  const std::size_t rank = static_cast<std::size_t>(
+      std::max(1.0, std::ceil(q * static_cast<double>(v.size()))));
+  std::nth_element(v.begin(), v.begin() + (rank - 1), v.end());
+  return v[rank - 1];
+}
+
+/// @return @c true if @p s ends with @p suffix.
+bool endsWith(const std::string &s, const std::string &suffix) {
+  return s.size() >= suffix.size() &&
+         s.compare(s.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+} // namespace
+
+Profiler::Profiler(std::vector<std::string> phases,
+                   std::vector<std::string> counters,
+                   const std::size_t history)
+    : phases_(std::move(phases)), counters_(std::move(counters)),
+      history_(std::max<std::size_t>(1, history)) {
+  phases_.emplace_back("other");
+  columns_ = phases_.size() + counters_.size();
+  rows_.assign(history_ * columns_, 0.0);
+  steps_.assign(history_, 0);
+  total_.assign(columns_, 0.0);
+  samples_.assign(counters_.size(), 0);
+  min_.assign(counters_.size(), std::numeric_limits<double>::infinity());
+  max_.assign(counters_.size(), -std::numeric_limits<double>::infinity());
+  row_ = rows_.data();
+  open_.reserve(16);
+  last_ = GET_TIME();
+}
+
+void Profiler::beginStep(const int step) {
+  const std::size_t slot = recorded_ % history_;
+  row_ = rows_.data() + slot * columns_;
+  std::fill(row_, row_ + phases_.size(), 0.0);
+  std::fill(row_ + phases_.size(), row_ + columns_,
+            std::numeric_limits<double>::quiet_NaN()); // no sample yet
+  steps_[slot] = step;
+  open_.clear();
+  last_ = GET_TIME();
+}
+
+void Profiler::endStep() {
+  charge();
+  const std::size_t numPhases = phases_.size();
+  for (std::size_t c = 0; c < numPhases; ++c)
+    total_[c] += row_[c];
+  for (std::size_t c = 0; c < counters_.size(); ++c) {
+    const double value = row_[numPhases + c];
+    if (std::isnan(value))
+      continue;
+    total_[numPhases + c] += value;
+    ++samples_[c];
+    min_[c] = std::min(min_[c], value);
+    max_[c] = std::max(max_[c], value);
+  }
+  ++recorded_;
+}
+
+void Profiler::enter(const int phase) {
+  charge();
+  open_.push_back(phase);
+}
+
+void Profiler::leave() {
+  charge();
+  if (!open_.empty())
+    open_.pop_back();
+}
+
+std::size_t Profiler::ringRow(const std::size_t k) const {
+  const std::size_t first = recorded_ > history_ ? recorded_ % history_ : 0;
+  return (first + k) % history_;
+}
+
+std::vector<double> Profiler::column(const std::size_t c) const {
+  const std::size_t kept = std::min(recorded_, history_);
+  std::vector<double> v;
+  v.reserve(kept);
+  for (std::size_t k = 0; k < kept; ++k) {
+    const double value = rows_[ringRow(k) * columns_ + c];
+    if (!std::isnan(value))
+      v.push_back(value);
+  }
+  return v;
+}
+
+void Profiler::printSummary(std::ostream &os) const {
+  if (recorded_ == 0)
+    return;
+  const std::size_t kept = std::min(recorded_, history_);
+  const std::size_t numPhases = phases_.size();
+  const double steps = static_cast<double>(recorded_);
+
+  // Wall time of each kept step: the sum of its phases.
+  std::vector<double> stepTime(kept, 0.0);
+  for (std::size_t k = 0; k < kept; ++k) {
+    const double *row = rows_.data() + ringRow(k) * columns_;
+    stepTime[k] = std::accumulate(row, row + numPhases, 0.0);
+  }
+  const double wall = std::accumulate(total_.begin(),
+                                      total_.begin() + numPhases, 0.0);
+
+  const std::ios::fmtflags flags = os.flags();
+  const std::streamsize precision = os.precision();
+  os << "\nProfile: " << recorded_ << " step(s)";
+  if (kept < recorded_)
+    os << ", percentiles over the last " << kept;
+  os << '\n'
+     << std::left << std::setw(22) << "  phase" << std::right << std::setw(11)
+     << "total [s]" << std::setw(11) << "mean [ms]" << std::setw(11)
+     << "p50 [ms]" << std::setw(11) << "p99 [ms]" << std::setw(8) << "share"
+     << '\n'
+     << std::fixed;
+
+  auto phaseRow = [&](const std::string &name, const double total,
+                      std::vector<double> v) {
+    const double p50 = percentile(v, 0.50);
+    const double p99 = percentile(v, 0.99);
+    os << "  " << std::left << std::setw(20) << name << std::right
+       << std::setprecision(3) << std::setw(11) << total << std::setw(11)
+       << 1e3 * total / steps << std::setw(11) << 1e3 * p50 << std::setw(11)
+       << 1e3 * p99 << std::setprecision(1) << std::setw(7)
+       << (wall > 0.0 ? 100.0 * total / wall : 0.0) << "%\n";
+  };
+  for (std::size_t c = 0; c < numPhases; ++c)
+    if (total_[c] > 0.0)
+      phaseRow(phases_[c], total_[c], column(c));
+  phaseRow("step", wall, stepTime);
+
+  // Counters: distribution of the per-step samples.
+  if (std::any_of(samples_.begin(), samples_.end(),
+                  [](const std::size_t n) { return n > 0; })) {
+    os << std::left << std::setw(22) << "  counter" << std::right
+       << std::setw(11) << "min" << std::setw(11) << "mean" << std::setw(11)
+       << "p50" << std::setw(11) << "p99" << std::setw(11) << "max" << '\n'
+       << std::defaultfloat << std::setprecision(4);
+    for (std::size_t c = 0; c < counters_.size(); ++c) {
+      if (samples_[c] == 0)
+        continue; // never recorded in this run
+      std::vector<double> v = column(numPhases + c);
+      const double mean =
+          total_[numPhases + c] / static_cast<double>(samples_[c]);
+      const double p50 = percentile(v, 0.50);
+      const double p99 = percentile(v, 0.99);
+      os << "  " << std::left << std::setw(20) << counters_[c] << std::right
+         << std::setw(11) << min_[c] << std::setw(11) << mean << std::setw(11)
+         << p50 << std::setw(11) << p99 << std::setw(11) << max_[c] << '\n';
+    }
+  }
+  os.flags(flags);
+  os.precision(precision);
+}
+
+bool Profiler::writeTimeline(const std::string &path) const {
+  std::ofstream out(path);
+  if (!out.is_open())
+    return false;
+
+  const std::size_t kept = std::min(recorded_, history_);
+  const bool json = endsWith(path, ".json");
+  out << std::setprecision(9);
+
+  if (json) {
+    // {"columns": [...], "steps": [[step, v0, v1, ...], ...]}
+    out << "{\n  \"columns\": [\"step\"";
+    for (const std::string &name : phases_)
+      out << ", \"" << name << '"';
+    for (const std::string &name : counters_)
+      out << ", \"" << name << '"';
+    out << "],\n  \"steps\": [";
+  } else {
+    out << "step";
+    for (const std::string &name : phases_)
+      out << ',' << name;
+    for (const std::string &name : counters_)
+      out << ',' << name;
+    out << '\n';
+  }
+
+  for (std::size_t k = 0; k < kept; ++k) {
+    const std::size_t r = ringRow(k);
+    const double *row = rows_.data() + r * columns_;
+    if (json)
+      out << (k ? ",\n    [" : "\n    [") << steps_[r];
+    else
+      out << steps_[r];
+    for (std::size_t c = 0; c < columns_; ++c) {
+      out << ',' << (json ? " " : "");
+      if (!std::isnan(row[c]))
+        out << row[c];
+      else if (json)
+        out << "null"; // counter not set in this step
+    }
+    out << (json ? "]" : "\n");
+  }
+  if (json)
+    out << "\n  ]\n}\n";
+  return static_cast<bool>(out);
+}
+
+} // namespace PIC_REAL
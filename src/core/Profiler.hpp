@@ -0,0 +1,127 @@
+#pragma once
+#include "Precision.hpp"
+#include <cstddef>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/**
+ * @file Profiler.hpp
+ * @brief Always-on per-step phase timings and counters.
+ */
+
+namespace PIC_REAL {
+
+/**
+ * @brief Records how long each phase of every time step takes, plus a few
+ *        per-step counters, at the cost of one clock read per phase
+ *        boundary.
+ *
+ * Phases nest: entering a phase pauses the enclosing one, so every second
+ * of a step is charged to exactly one phase (the innermost open one, or
+ * "other" when none is open) and the phase times of a step add up to its
+ * wall time.
+ *
+ * ### Storage
+ * Each step is one row (phase times, then counters) of a ring buffer
+ * allocated up front for the last @c history steps; nothing is allocated
+ * while the simulation runs. Totals, means, minima and maxima cover every
+ * step, the percentiles and the timeline the steps still in the ring.
+ *
+ * A counter holds one value per step (an iteration count, a residual, dt),
+ * so it is summarised by its distribution, never summed. A step that does
+ * not set a counter has no sample of it: NaN in the ring, empty in the
+ * timeline.
+ *
+ * Not thread-safe: phases are entered and left by the thread driving the
+ * time loop, outside OpenMP regions.
+ */
+class Profiler {
+public:
+  /**
+   * @param phases   Phase names (timeline columns); "other" is appended.
+   * @param counters Counter names (timeline columns after the phases).
+   * @param history  Steps kept in the ring buffer (at least 1).
+   */
+  Profiler(std::vector<std::string> phases, std::vector<std::string> counters,
+           std::size_t history);
+
+  /// @brief Charges the enclosed region to one phase (RAII).
+  class Scope {
+  public:
+    Scope(Profiler &profiler, int phase) : profiler_(profiler) {
+      profiler_.enter(phase);
+    }
+    ~Scope() { profiler_.leave(); }
+
+    Scope(const Scope &) = delete;
+    Scope &operator=(const Scope &) = delete;
+
+  private:
+    Profiler &profiler_;
+  };
+
+  /// @brief Start the row of time step @p step.
+  void beginStep(int step);
+
+  /// @brief Close the current row (time since the last boundary: "other").
+  void endStep();
+
+  /// @brief Enter @p phase, pausing the current one.
+  void enter(int phase);
+
+  /// @brief Leave the innermost phase, resuming the enclosing one.
+  void leave();
+
+  /// @brief Set the sample of counter @p counter in the current step.
+  void count(int counter, double value) {
+    row_[phases_.size() + counter] = value;
+  }
+
+  /**
+   * @brief Print total, mean, p50 and p99 of every phase that ran, and min,
+   *        mean, p50, p99 and max of every counter that has samples.
+   */
+  void printSummary(std::ostream &os) const;
+
+  /**
+   * @brief Write the steps in the ring buffer, oldest first: CSV with one
+   *        row per step, or JSON when @p path ends in ".json".
+   * @return @c false if the file could not be written.
+   */
+  bool writeTimeline(const std::string &path) const;
+
+private:
+  std::vector<std::string> phases_;   ///< Phase names, "other" last.
+  std::vector<std::string> counters_; ///< Counter names.
+  std::size_t columns_;               ///< Phases + counters per row.
+  std::size_t history_;               ///< Rows in the ring.
+
+  std::vector<double> rows_;  ///< history_ × columns_ values.
+  std::vector<int> steps_;    ///< Step number of every row.
+  std::vector<double> total_; ///< Column sums over every recorded step.
+  std::vector<std::size_t> samples_; ///< Steps that set each counter.
+  std::vector<double> min_;          ///< Smallest sample of each counter.
+  std::vector<double> max_;          ///< Largest sample of each counter.
+  std::size_t recorded_ = 0;  ///< Steps recorded so far.
+  double *row_;               ///< Row of the current step.
+
+  std::vector<int> open_; ///< Stack of open phases (innermost last).
+  double last_ = 0.0;     ///< Time of the last phase boundary.
+
+  /// @brief Charge the time since the last boundary to the current phase.
+  void charge() {
+    const double now = GET_TIME();
+    row_[open_.empty() ? phases_.size() - 1 : open_.back()] += now - last_;
+    last_ = now;
+  }
+
+  /// @return The values of column @p c in the ring, oldest first, without
+  ///         the steps that did not set it.
+  [[nodiscard]] std::vector<double> column(std::size_t c) const;
+
+  /// @return Index of the ring row holding the @p k-th oldest kept step.
+  [[nodiscard]] std::size_t ringRow(std::size_t k) const;
+};
+
+} // namespace PIC_REAL
@@ -4,6 +4,8 @@
 #include <iostream>
 #include <stdexcept>
 
+namespace PIC_REAL {
+
 // Expression resolver
 int resolveInt(const nlohmann::json &val,
                const std::map<std::string, int> &vars) {
@@ -88,34 +90,36 @@ int resolveInt(const nlohmann::json &val,
 
 void RectangleObject::applySolid(Fields2D &f) const {
   const int iMax = std::min(x2, f.nx - 1);
-  const int jMax = std::min(y2, f.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
+  const int jMax = std::min(y2 - f.rowOffset, f.ny - 1);
+  for (int j = std::max(y1 - f.rowOffset, 0); j <= jMax; ++j)
     for (int i = std::max(x1, 0); i <= iMax; ++i)
       f.SetLabel(i, j, Fields2D::SOLID);
 }
 
 void RectangleObject::applyVelocityU(Fields2D &f) const {
   const int iMax = std::min(x2, f.u.nx - 1);
-  const int jMax = std::min(y2, f.u.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
+  const int jMax = std::min(y2 - f.rowOffset, f.u.ny - 1);
+  for (int j = std::max(y1 - f.rowOffset, 0); j <= jMax; ++j)
     for (int i = std::max(x1, 0); i <= iMax; ++i)
       f.u.Set(i, j, val);
 }
 
 void RectangleObject::applyVelocityV(Fields2D &f) const {
   const int iMax = std::min(x2, f.v.nx - 1);
-  const int jMax = std::min(y2, f.v.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
+  const int jMax = std::min(y2 - f.rowOffset, f.v.ny - 1);
+  for (int j = std::max(y1 - f.rowOffset, 0); j <= jMax; ++j)
     for (int i = std::max(x1, 0); i <= iMax; ++i)
       f.v.Set(i, j, val);
 }
 
 void RectangleObject::applySmoke(Fields2D &f) const {
   const int iMax = std::min(x2, f.smokeMap.nx - 1);
-  const int jMax = std::min(y2, f.smokeMap.ny - 1);
-  for (int j = std::max(y1, 0); j <= jMax; ++j)
+  const int jMax = std::min(y2 - f.rowOffset, f.smokeMap.ny - 1);
+  const int jMin = std::max(y1 - f.rowOffset, 0);
+  for (int j = jMin; j <= jMax; ++j)
     for (int i = std::max(x1, 0); i <= iMax; ++i)
       f.smokeMap.Set(i, j, val);
+  f.smokeTiles.MarkCells(x1, iMax + 1, jMin, jMax + 1);
 }
 
 // CylinderObject
@@ -123,7 +127,7 @@ void RectangleObject::applySmoke(Fields2D &f) const {
 void CylinderObject::applySolid(Fields2D &f) const {
   const int r2 = r * r;
   for (int j = 0; j < f.ny; ++j) {
-    const int ddy = j - cy;
+    const int ddy = j + f.rowOffset - cy;
     for (int i = 0; i < f.nx; ++i) {
       const int ddx = i - cx;
       if (ddx * ddx + ddy * ddy <= r2)
@@ -200,3 +204,5 @@ parseSceneObjects(const nlohmann::json &node,
 
   return result;
 }
+
+} // namespace PIC_REAL
@@ -23,8 +23,13 @@
  * Coordinate values may be integer literals **or** simple arithmetic
  * expressions referencing `nx` and `ny` (e.g. `"nx/2 - 10"`).
  * See @c resolveInt() for the supported grammar.
+ *
+ * Rows are those of the whole domain; on the slab of a distributed run
+ * (@c Fields2D::rowOffset) an object only touches the rows the slab holds.
  */
 
+namespace PIC_REAL {
+
 /**
  * @brief Abstract base for all scene primitives.
  *
@@ -128,3 +133,5 @@ makeSceneObject(const std::string &type, const nlohmann::json &j,
 std::vector<std::unique_ptr<SceneObject>>
 parseSceneObjects(const nlohmann::json &node,
                   const std::map<std::string, int> &vars);
+
+} // namespace PIC_REAL
@@ -0,0 +1,177 @@
+#include "Transforms.hpp"
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+constexpr double PI = 3.14159265358979323846;
+}
+
+// FFTPlan
+
+FFTPlan::FFTPlan(const int n) : n_(n), m_(n), pow2_((n & (n - 1)) == 0) {
+  if (n < 1)
+    throw std::invalid_argument("FFTPlan: length must be >= 1");
+
+  if (!pow2_) {
+    // Bluestein needs a linear convolution of length 2n-1 without wrap-around.
+    m_ = 1;
+    while (m_ < 2 * n_ - 1)
+      m_ <<= 1;
+  }
+
+  twiddle_.resize(static_cast<std::size_t>(m_ / 2));
+  for (int k = 0; k < m_ / 2; ++k)
+    twiddle_[k] = std::polar(1.0, -2.0 * PI * k / m_);
+
+  if (pow2_)
+    return;
+
+  // Chirp w_j = e^{iπ j²/n}. j² is reduced modulo 2n first so the angle stays
+  // small and accurate for large n.
+  chirp_.resize(static_cast<std::size_t>(n_));
+  for (int j = 0; j < n_; ++j) {
+    const long long j2 = (static_cast<long long>(j) * j) % (2LL * n_);
+    chirp_[j] = std::polar(1.0, PI * static_cast<double>(j2) / n_);
+  }
+
+  // Circularly padded chirp (indices -(n-1) … n-1) and its transform.
+  chirpHat_.assign(static_cast<std::size_t>(m_), {0.0, 0.0});
+  chirpHat_[0] = chirp_[0];
+  for (int j = 1; j < n_; ++j)
+    chirpHat_[j] = chirpHat_[m_ - j] = chirp_[j];
+  radix2(chirpHat_.data(), false);
+}
+
+void FFTPlan::radix2(std::complex<double> *a, const bool inverse) const {
+  // Bit-reversal permutation.
+  for (int i = 1, j = 0; i < m_; ++i) {
+    int bit = m_ >> 1;
+    for (; j & bit; bit >>= 1)
+      j ^= bit;
+    j ^= bit;
+    if (i < j)
+      std::swap(a[i], a[j]);
+  }
+
+  // Iterative Cooley-Tukey butterflies.
+  for (int len = 2; len <= m_; len <<= 1) {
+    const int half = len / 2;
+    const int step = m_ / len;
+    for (int i = 0; i < m_; i += len) {
+      for (int k = 0; k < half; ++k) {
+        const std::complex<double> w =
+            inverse ? std::conj(twiddle_[k * step]) : twiddle_[k * step];
+        const std::complex<double> u = a[i + k];
+        const std::complex<double> v = a[i + k + half] * w;
+        a[i + k] = u + v;
+        a[i + k + half] = u - v;
+      }
+    }
+  }
+}
+
+void FFTPlan::execute(std::complex<double> *data, const bool inverse,
+                      std::complex<double> *work) const {
+  if (pow2_) {
+    radix2(data, inverse);
+    return;
+  }
+
+  // The inverse transform is conj(FFT(conj(x))).
+  if (inverse)
+    for (int j = 0; j < n_; ++j)
+      data[j] = std::conj(data[j]);
+
+  // Bluestein: X_k = conj(w_k) · Σ_j (x_j conj(w_j)) w_{k-j}.
+  for (int j = 0; j < n_; ++j)
+    work[j] = data[j] * std::conj(chirp_[j]);
+  for (int j = n_; j < m_; ++j)
+    work[j] = {0.0, 0.0};
+
+  radix2(work, false);
+  for (int j = 0; j < m_; ++j)
+    work[j] *= chirpHat_[j];
+  radix2(work, true);
+
+  const double scale = 1.0 / m_;
+  for (int k = 0; k < n_; ++k)
+    data[k] = work[k] * std::conj(chirp_[k]) * scale;
+
+  if (inverse)
+    for (int j = 0; j < n_; ++j)
+      data[j] = std::conj(data[j]);
+}
+
+// TrigTransform
+
+TrigTransform::TrigTransform(const int n, const Kind kind)
+    : n_(n), kind_(kind), fft_(kind == Kind::DCT2 ? 2 * n : 2 * (n + 1)),
+      eig_(static_cast<std::size_t>(n)) {
+  for (int k = 0; k < n_; ++k)
+    eig_[k] = (kind_ == Kind::DCT2) ? 2.0 - 2.0 * std::cos(PI * k / n_)
+                                    : 2.0 - 2.0 * std::cos(PI * (k + 1) /
+                                                           (n_ + 1));
+
+  if (kind_ == Kind::DCT2) {
+    shift_.resize(static_cast<std::size_t>(n_));
+    for (int k = 0; k < n_; ++k)
+      shift_[k] = std::polar(1.0, -PI * k / (2.0 * n_));
+  }
+}
+
+void TrigTransform::forward(double *x, const std::ptrdiff_t stride,
+                            std::complex<double> *work) const {
+  const int L = fft_.size();
+  std::complex<double> *y = work;
+  std::complex<double> *scratch = work + L;
+
+  if (kind_ == Kind::DCT2) {
+    // Even extension [x, reverse(x)]; then
+    //   c_k = Σ x_m cos(πk(m+½)/n) = ½ Re(e^{-iπk/2n} Y_k).
+    for (int m = 0; m < n_; ++m)
+      y[m] = y[L - 1 - m] = x[m * stride];
+    fft_.execute(y, false, scratch);
+    for (int k = 0; k < n_; ++k)
+      x[k * stride] = 0.5 * (shift_[k] * y[k]).real();
+  } else {
+    // Odd extension [0, x, 0, -reverse(x)]; then
+    //   s_k = Σ x_m sin(π(k+1)(m+1)/(n+1)) = -½ Im(Y_{k+1}).
+    y[0] = y[n_ + 1] = {0.0, 0.0};
+    for (int m = 0; m < n_; ++m) {
+      y[m + 1] = x[m * stride];
+      y[L - 1 - m] = -x[m * stride];
+    }
+    fft_.execute(y, false, scratch);
+    for (int k = 0; k < n_; ++k)
+      x[k * stride] = -0.5 * y[k + 1].imag();
+  }
+}
+
+void TrigTransform::inverse(double *x, const std::ptrdiff_t stride,
+                            std::complex<double> *work) const {
+  if (kind_ == Kind::DST1) {
+    // DST-I is its own inverse up to the factor 2/(n+1).
+    forward(x, stride, work);
+    const double scale = 2.0 / (n_ + 1);
+    for (int m = 0; m < n_; ++m)
+      x[m * stride] *= scale;
+    return;
+  }
+
+  // DCT-III: x_m = c_0/n + (2/n) Σ_{k≥1} c_k cos(πk(m+½)/n), evaluated as an
+  // inverse FFT of a Hermitian-symmetric spectrum of length 2n.
+  const int L = fft_.size();
+  std::complex<double> *z = work;
+  std::complex<double> *scratch = work + L;
+
+  z[0] = x[0] / n_;
+  z[n_] = {0.0, 0.0};
+  for (int k = 1; k < n_; ++k) {
+    z[k] = std::conj(shift_[k]) * (x[k * stride] / n_);
+    z[L - k] = std::conj(z[k]);
+  }
+  fft_.execute(z, true, scratch);
+  for (int m = 0; m < n_; ++m)
+    x[m * stride] = z[m].real();
+}
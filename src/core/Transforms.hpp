@@ -0,0 +1,120 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file Transforms.hpp
+ * @brief In-tree FFT and the real trigonometric transforms used by the
+ *        spectral pressure solver.
+ *
+ * No external FFT library is required. Lengths that are powers of two use an
+ * iterative radix-2 FFT; any other length goes through Bluestein's chirp-z
+ * algorithm on top of it, so every size runs in O(n log n).
+ */
+
+/**
+ * @brief Complex discrete Fourier transform of a fixed length.
+ *
+ * Computes the unnormalised transform
+ * \f$ X_k = \sum_j x_j\, e^{\mp 2\pi i jk/n} \f$
+ * (minus sign forward, plus sign inverse). A plan is immutable after
+ * construction and can be shared by several threads as long as each thread
+ * passes its own @p work buffer.
+ */
+class FFTPlan {
+public:
+  /// @param n Transform length (≥ 1).
+  explicit FFTPlan(int n);
+
+  /// @return Transform length.
+  [[nodiscard]] int size() const { return n_; }
+
+  /// @return Number of complex scratch values @c execute() needs.
+  [[nodiscard]] std::size_t workSize() const {
+    return pow2_ ? 0 : static_cast<std::size_t>(m_);
+  }
+
+  /**
+   * @brief Transform @p data in place.
+   * @param data    @c size() complex values.
+   * @param inverse @c true for the (unnormalised) inverse transform.
+   * @param work    Scratch of at least @c workSize() values.
+   */
+  void execute(std::complex<double> *data, bool inverse,
+               std::complex<double> *work) const;
+
+private:
+  int n_;     ///< Transform length.
+  int m_;     ///< Radix-2 length (n_ itself, or Bluestein padding ≥ 2n-1).
+  bool pow2_; ///< @c true if n_ is a power of two.
+
+  std::vector<std::complex<double>> twiddle_; ///< e^{-2πik/m_}, k < m_/2.
+  std::vector<std::complex<double>> chirp_;   ///< e^{iπj²/n_} (Bluestein).
+  std::vector<std::complex<double>> chirpHat_; ///< FFT of the padded chirp.
+
+  /// In-place radix-2 transform of length m_.
+  void radix2(std::complex<double> *a, bool inverse) const;
+};
+
+/**
+ * @brief Real trigonometric transform diagonalising the 1-D cell-centred
+ *        Laplacian tridiag(-1, 2, -1) with a given boundary condition.
+ *
+ * | Kind   | Boundary (both ends) | Basis vector k                     |
+ * |--------|----------------------|------------------------------------|
+ * | DCT2   | Neumann              | cos(π k (m + ½) / n)               |
+ * | DST1   | Dirichlet            | sin(π (k + 1)(m + 1) / (n + 1))    |
+ *
+ * @c forward() projects onto the basis (unnormalised), @c inverse()
+ * reconstructs, so @c inverse(forward(x)) == x.
+ */
+class TrigTransform {
+public:
+  /// Supported boundary conditions.
+  enum class Kind {
+    DCT2, ///< Neumann at both ends (DCT-II forward, DCT-III inverse).
+    DST1  ///< Dirichlet at both ends (DST-I, self-inverse up to scale).
+  };
+
+  /**
+   * @param n    Number of cells along the axis.
+   * @param kind Boundary condition / basis.
+   */
+  TrigTransform(int n, Kind kind);
+
+  /// @return Number of cells along the axis.
+  [[nodiscard]] int size() const { return n_; }
+
+  /// @return Number of complex scratch values @c forward()/@c inverse() need.
+  [[nodiscard]] std::size_t workSize() const {
+    return static_cast<std::size_t>(fft_.size()) + fft_.workSize();
+  }
+
+  /**
+   * @brief Eigenvalue of the 1-D operator for basis vector @p k.
+   *
+   * 2 - 2cos(πk/n) for DCT2, 2 - 2cos(π(k+1)/(n+1)) for DST1.
+   */
+  [[nodiscard]] double eigenvalue(int k) const { return eig_[k]; }
+
+  /**
+   * @brief Transform @p n_ values with stride @p stride in place.
+   * @param x      First value.
+   * @param stride Distance between consecutive values.
+   * @param work   Scratch of at least @c workSize() values.
+   */
+  void forward(double *x, std::ptrdiff_t stride,
+               std::complex<double> *work) const;
+
+  /// @brief Exact inverse of @c forward(), same arguments.
+  void inverse(double *x, std::ptrdiff_t stride,
+               std::complex<double> *work) const;
+
+private:
+  int n_;
+  Kind kind_;
+  FFTPlan fft_; ///< Length 2n (DCT2) or 2(n+1) (DST1).
+  std::vector<double> eig_;
+  std::vector<std::complex<double>> shift_; ///< e^{-iπk/2n} (DCT2 only).
+};
@@ -1,27 +1,56 @@
-#include "core/Parameters.hpp"
-#include "solvers/SemiLagrangian/SemiLagrangian.hpp"
+#include "Simulation.hpp"
+#include <fstream>
 #include <iostream>
+#include <nlohmann/json.hpp>
+#include <string>
+#include <string_view>
 
-int main(int argc, char *argv[]) {
-#ifndef NDEBUG
-  std::cout << "Compiled with debug mode" << std::endl;
-#endif
+// The working precision is the config's top-level "precision" key,
+// "float" or "double"; without it the one CMake was configured with
+// (USE_FLOAT_PRECISION). Parameters reads the rest of the file again inside
+// the chosen build, and reports a missing or malformed config itself.
 
-  // Parse parameters from command line
-  Parameters params;
-  if (!params.parseCommandLine(argc, argv)) {
-    return 1;
+namespace {
+
+/// @return @c true if the config named by @c -c / @c --config asks for
+///         float, @p fallback if it names no precision or cannot be read.
+bool configUsesFloat(const int argc, char *argv[], const bool fallback) {
+  std::string config;
+  for (int a = 1; a + 1 < argc; a += 2) {
+    const std::string_view flag = argv[a];
+    if (flag == "-c" || flag == "--config")
+      config = argv[a + 1];
   }
+  std::ifstream file(config);
+  if (config.empty() || !file.is_open())
+    return fallback;
 
-#ifndef NDEBUG
-  // Display parameters
-  std::cout << params << std::endl;
-#endif
+  const nlohmann::json j = nlohmann::json::parse(file, nullptr, false);
+  if (!j.is_object() || !j.contains("precision"))
+    return fallback;
+  if (!j["precision"].is_string()) {
+    std::cerr << "[main] Warning: \"precision\" is not a string, ignored\n";
+    return fallback;
+  }
+  const std::string precision = j["precision"].get<std::string>();
+  if (precision == "float")
+    return true;
+  if (precision == "double")
+    return false;
+  std::cerr << "[main] Warning: unknown precision '" << precision
+            << "' – defaulting to " << (fallback ? "float" : "double")
+            << ".\n";
+  return fallback;
+}
 
-  // Create and run solver
-  SemiLagrangian solver(params);
-  solver.Run();
+} // namespace
 
-  std::cout << "Simulation completed successfully!" << std::endl;
-  return 0;
+int main(int argc, char *argv[]) {
+#ifdef PIC_DEFAULT_FLOAT
+  const bool useFloat = configUsesFloat(argc, argv, true);
+#else
+  const bool useFloat = configUsesFloat(argc, argv, false);
+#endif
+  return useFloat ? real32::RunSimulation(argc, argv)
+                  : real64::RunSimulation(argc, argv);
 }
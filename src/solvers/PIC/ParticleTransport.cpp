@@ -0,0 +1,536 @@
+#include "ParticleTransport.hpp"
+#include <algorithm>
+#include <cmath>
+#include <climits>
+#include <cstdint>
+#include <iostream>
+#include <utility>
+
+// Particle transport
+//
+// Staggered node positions, in index space (x/dx, y/dy):
+//
+//   u(i,j): (i,       j + 0.5)  →  offset (0,   0.5)
+//   v(i,j): (i + 0.5, j      )  →  offset (0.5, 0  )
+//
+// A particle at index-space position (xs, ys) touches the 2×2 nodes around
+// (xs - offX, ys - offY) with bilinear weights. P2G scatters along that
+// stencil (nodes outside the grid are skipped), G2P gathers along it with
+// the base index clamped, exactly as Grid2D::Interpolate().
+
+namespace PIC_REAL {
+
+namespace {
+
+/// Particles processed per batch in the gather kernels.
+constexpr int BATCH = 256;
+
+/// Base node and fractional offsets of a bilinear stencil.
+struct Stencil {
+  int i0, j0;
+  varType fx, fy;
+};
+
+Stencil stencilAt(const varType xs, const varType ys, const varType offX,
+                  const varType offY) {
+  const varType i_real = xs - offX;
+  const varType j_real = ys - offY;
+  const int i0 = static_cast<int>(std::floor(i_real));
+  const int j0 = static_cast<int>(std::floor(j_real));
+  return {i0, j0, i_real - static_cast<varType>(i0),
+          j_real - static_cast<varType>(j0)};
+}
+
+/**
+ * Splat one particle value onto a staggered grid of @p gnx × @p gny nodes.
+ * @c affX / @c affY are the APIC gradient times the cell size, so the value
+ * at a node displaced by (ri, rj) cells is val + affX·ri + affY·rj.
+ */
+void scatter(const Stencil &s, const int gnx, const int gny, const varType val,
+             const varType affX, const varType affY, varType *w, varType *m) {
+  for (int b = 0; b < 2; ++b) {
+    const int j = s.j0 + b;
+    if (j < 0 || j >= gny)
+      continue;
+    const varType wy = b ? s.fy : REAL_LITERAL(1.0) - s.fy;
+    const varType rj = static_cast<varType>(b) - s.fy;
+    for (int a = 0; a < 2; ++a) {
+      const int i = s.i0 + a;
+      if (i < 0 || i >= gnx)
+        continue;
+      const varType wx = a ? s.fx : REAL_LITERAL(1.0) - s.fx;
+      const varType ri = static_cast<varType>(a) - s.fx;
+      const varType wk = wx * wy;
+      const int k = gnx * j + i;
+      w[k] += wk;
+      m[k] += wk * (val + affX * ri + affY * rj);
+    }
+  }
+}
+
+/// Bilinear value and gradient (in index space) of @p g at a stencil.
+void gatherAffine(const Grid2D &g, Stencil s, varType &val, varType &gx,
+                  varType &gy) {
+  s.i0 = std::clamp(s.i0, 0, g.nx - 2);
+  s.j0 = std::clamp(s.j0, 0, g.ny - 2);
+  const varType g00 = g.Get(s.i0, s.j0);
+  const varType g10 = g.Get(s.i0 + 1, s.j0);
+  const varType g01 = g.Get(s.i0, s.j0 + 1);
+  const varType g11 = g.Get(s.i0 + 1, s.j0 + 1);
+  const varType ox = REAL_LITERAL(1.0) - s.fx;
+  const varType oy = REAL_LITERAL(1.0) - s.fy;
+  val = oy * (ox * g00 + s.fx * g10) + s.fy * (ox * g01 + s.fx * g11);
+  gx = oy * (g10 - g00) + s.fy * (g11 - g01);
+  gy = ox * (g01 - g00) + s.fx * (g11 - g10);
+}
+
+/// Deterministic hash of an integer to [0, 1) (SplitMix64 finaliser).
+varType unitHash(uint64_t k) {
+  k += 0x9E3779B97F4A7C15ULL;
+  k = (k ^ (k >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  k = (k ^ (k >> 27)) * 0x94D049BB133111EBULL;
+  k ^= k >> 31;
+  return static_cast<varType>(static_cast<double>(k >> 11) * 0x1.0p-53);
+}
+
+} // namespace
+
+ParticleTransport::ParticleTransport(const TransportConfig &cfg,
+                                     Fields2D &fields)
+    : cfg(cfg), fields(fields), invDx(REAL_LITERAL(1.0) / fields.dx),
+      invDy(REAL_LITERAL(1.0) / fields.dy) {
+  const std::size_t uSize = fields.u.A.size();
+  const std::size_t vSize = fields.v.A.size();
+  const std::size_t nCells = static_cast<std::size_t>(fields.nx) * fields.ny;
+  accumStride = 2 * (uSize + vSize);
+  accum.resize(accumStride * MAX_THREADS());
+  histogram.resize(nCells * MAX_THREADS());
+  rowLo.assign(MAX_THREADS(), INT_MAX);
+  rowHi.assign(MAX_THREADS(), -1);
+  cellStart.assign(nCells + 1, 0);
+  cellKept.assign(nCells, 0);
+
+  // Each thread zeroes (and thereby first-touches) its own buffers.
+  OMP_PRAGMA(omp parallel)
+  {
+    varType *buf = accum.data() + accumStride * THREAD_NUM();
+    std::fill(buf, buf + accumStride, REAL_LITERAL(0.0));
+    int *hist = histogram.data() + nCells * THREAD_NUM();
+    std::fill(hist, hist + nCells, 0);
+  }
+
+  seed();
+
+#ifndef NDEBUG
+  std::cout << "  Particles: " << particles.size() << " ("
+            << cfg.particlesPerCell << " per FLUID cell), scheme "
+            << cfg.schemeName() << '\n';
+#endif
+}
+
+void ParticleTransport::RestoreState(Particles restored, const int steps) {
+  particles = std::move(restored);
+  stepCount = steps;
+}
+
+void ParticleTransport::seed() {
+  const int nx = fields.nx;
+  const int ny = fields.ny;
+  const int ppc = cfg.particlesPerCell;
+  const int sub = static_cast<int>(std::ceil(std::sqrt(ppc)));
+
+  // Seeding in row-major cell order leaves the store already sorted.
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      const int c = nx * j + i;
+      cellKept[c] = (fields.Label(i, j) == Fields2D::FLUID) ? ppc : 0;
+      cellStart[c + 1] = cellStart[c] + cellKept[c];
+    }
+  }
+  particles.resize(cellStart.back(),
+                   cfg.scheme == TransportConfig::Scheme::APIC);
+
+  // One particle per sub-cell of a sub × sub lattice, jittered inside it.
+  std::size_t p = 0;
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      if (fields.Label(i, j) != Fields2D::FLUID)
+        continue;
+      const uint64_t cell = static_cast<uint64_t>(nx) * j + i;
+      for (int k = 0; k < ppc; ++k, ++p) {
+        const uint64_t key = 2 * (cell * ppc + k);
+        const varType sx = (k % sub + unitHash(key)) / sub;
+        const varType sy = (k / sub + unitHash(key + 1)) / sub;
+        particles.x[p] = (static_cast<varType>(i) + sx) * fields.dx;
+        particles.y[p] = (static_cast<varType>(j) + sy) * fields.dy;
+      }
+    }
+  }
+
+  // Initial velocity from the grid; the affine terms start at zero.
+  OMP_PRAGMA(omp parallel)
+  {
+    varType xs[BATCH], ys[BATCH];
+    const int n = static_cast<int>(particles.size());
+    OMP_PRAGMA(omp for schedule(static))
+    for (int b = 0; b < n; b += BATCH) {
+      const int m = std::min(BATCH, n - b);
+      sampleVelocity(m, particles.x.data() + b, particles.y.data() + b, xs,
+                     ys, particles.u.data() + b, particles.v.data() + b);
+    }
+  }
+  std::fill(particles.cux.begin(), particles.cux.end(), REAL_LITERAL(0.0));
+  std::fill(particles.cuy.begin(), particles.cuy.end(), REAL_LITERAL(0.0));
+  std::fill(particles.cvx.begin(), particles.cvx.end(), REAL_LITERAL(0.0));
+  std::fill(particles.cvy.begin(), particles.cvy.end(), REAL_LITERAL(0.0));
+}
+
+// Sorting, deletion and reseeding
+//
+// Parallel counting sort over the static particle partition:
+//   1. every thread counts the cells of its share in a private histogram;
+//   2. per cell, the totals give the number of particles kept (0 in SOLID
+//      cells, at most maxPerCell) and the new bucket size (topped up to
+//      minPerCell in FLUID cells), whose prefix sum is cellStart;
+//   3. each histogram entry becomes the write cursor of that thread inside
+//      that cell, after the entries of all lower threads;
+//   4. the threads walk their share again in the same order and copy each
+//      particle to its cursor, dropping it once the cell is full;
+//   5. the free tail of each bucket is filled with new particles.
+// The result is stable and independent of timing, and the new store has no
+// holes. Everything is O(N + cells).
+
+void ParticleTransport::sortParticles() {
+  const int nx = fields.nx;
+  const int nCells = nx * fields.ny;
+  const int nThreads = MAX_THREADS();
+  const int n = static_cast<int>(particles.size());
+  const bool affine = (cfg.scheme == TransportConfig::Scheme::APIC);
+  const int minPC = cfg.minPerCell;
+  const int maxPC = cfg.maxPerCell;
+  const Particles &src = particles;
+  cellOf.resize(n);
+
+  auto hist = [this, nCells](const int t) {
+    return histogram.data() + static_cast<std::size_t>(nCells) * t;
+  };
+
+  OMP_PRAGMA(omp parallel)
+  {
+    int *mine = hist(THREAD_NUM());
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int p = 0; p < n; ++p) {
+      const int c = cellIndex(src.x[p], src.y[p]);
+      cellOf[p] = c;
+      ++mine[c];
+    }
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int c = 0; c < nCells; ++c) {
+      int count = 0;
+      for (int t = 0; t < nThreads; ++t)
+        count += hist(t)[c];
+      const bool fluid = fields.Label(c % nx, c / nx) == Fields2D::FLUID;
+      int kept = fluid ? count : 0;
+      if (maxPC > 0)
+        kept = std::min(kept, maxPC);
+      cellKept[c] = kept;
+      cellStart[c + 1] = (fluid && kept < minPC) ? minPC : kept;
+    }
+
+    OMP_PRAGMA(omp single)
+    {
+      cellStart[0] = 0;
+      for (int c = 0; c < nCells; ++c)
+        cellStart[c + 1] += cellStart[c];
+      sorted.resize(cellStart[nCells], affine);
+    }
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int c = 0; c < nCells; ++c) {
+      int cursor = cellStart[c];
+      for (int t = 0; t < nThreads; ++t) {
+        const int count = hist(t)[c];
+        hist(t)[c] = cursor;
+        cursor += count;
+      }
+    }
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int p = 0; p < n; ++p) {
+      const int c = cellOf[p];
+      const int slot = mine[c]++;
+      if (slot >= cellStart[c] + cellKept[c])
+        continue; // SOLID or overfull cell
+      sorted.x[slot] = src.x[p];
+      sorted.y[slot] = src.y[p];
+      sorted.u[slot] = src.u[p];
+      sorted.v[slot] = src.v[p];
+      if (affine) {
+        sorted.cux[slot] = src.cux[p];
+        sorted.cuy[slot] = src.cuy[p];
+        sorted.cvx[slot] = src.cvx[p];
+        sorted.cvy[slot] = src.cvy[p];
+      }
+    }
+
+    // Reset the histograms and top up sparse cells with jittered particles
+    // that take the current grid velocity.
+    OMP_PRAGMA(omp for schedule(static))
+    for (int c = 0; c < nCells; ++c) {
+      for (int t = 0; t < nThreads; ++t)
+        hist(t)[c] = 0;
+      const int i = c % nx;
+      const int j = c / nx;
+      for (int slot = cellStart[c] + cellKept[c]; slot < cellStart[c + 1];
+           ++slot) {
+        const uint64_t key =
+            2 * ((static_cast<uint64_t>(stepCount) * nCells + c) * 64 +
+                 static_cast<uint64_t>(slot - cellStart[c]));
+        const varType x = (static_cast<varType>(i) + unitHash(key)) * fields.dx;
+        const varType y =
+            (static_cast<varType>(j) + unitHash(key + 1)) * fields.dy;
+        sorted.x[slot] = x;
+        sorted.y[slot] = y;
+        sorted.u[slot] = fields.u.Interpolate(x, y, fields.dx, fields.dy, 0);
+        sorted.v[slot] = fields.v.Interpolate(x, y, fields.dx, fields.dy, 1);
+        if (affine)
+          sorted.cux[slot] = sorted.cuy[slot] = sorted.cvx[slot] =
+              sorted.cvy[slot] = REAL_LITERAL(0.0);
+      }
+    }
+  }
+
+  std::swap(particles, sorted);
+}
+
+// Helpers
+
+int ParticleTransport::cellIndex(const varType x, const varType y) const {
+  const int i = std::clamp(static_cast<int>(x * invDx), 0, fields.nx - 1);
+  const int j = std::clamp(static_cast<int>(y * invDy), 0, fields.ny - 1);
+  return fields.nx * j + i;
+}
+
+bool ParticleTransport::inSolid(const varType x, const varType y) const {
+  const int c = cellIndex(x, y);
+  return fields.Label(c % fields.nx, c / fields.nx) == Fields2D::SOLID;
+}
+
+void ParticleTransport::sampleVelocity(const int n, const varType *x,
+                                       const varType *y, varType *xs,
+                                       varType *ys, varType *u,
+                                       varType *v) const {
+  OMP_PRAGMA(omp simd)
+  for (int k = 0; k < n; ++k) {
+    xs[k] = x[k] * invDx;
+    ys[k] = y[k] * invDy;
+  }
+  fields.u.InterpolateBatch(n, xs, ys, REAL_LITERAL(0.0), REAL_LITERAL(0.5), u);
+  fields.v.InterpolateBatch(n, xs, ys, REAL_LITERAL(0.5), REAL_LITERAL(0.0), v);
+}
+
+// Particle → grid
+
+void ParticleTransport::ParticlesToGrid() {
+  if (cfg.sortInterval > 0 && ++stepCount % cfg.sortInterval == 0)
+    sortParticles();
+
+  Grid2D &u = fields.u;
+  Grid2D &v = fields.v;
+  const std::size_t uSize = u.A.size();
+  const std::size_t vSize = v.A.size();
+  const int n = static_cast<int>(particles.size());
+  const bool affine = (cfg.scheme == TransportConfig::Scheme::APIC);
+  const Particles &P = particles;
+
+  // Splat into the calling thread's private buffer; no two threads ever
+  // write the same address, so no atomics are needed.
+  OMP_PRAGMA(omp parallel)
+  {
+    varType *wU = accum.data() + accumStride * THREAD_NUM();
+    varType *mU = wU + uSize;
+    varType *wV = mU + uSize;
+    varType *mV = wV + vSize;
+    int lo = INT_MAX, hi = -1;
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int p = 0; p < n; ++p) {
+      const varType xs = P.x[p] * invDx;
+      const varType ys = P.y[p] * invDy;
+      const int row = static_cast<int>(ys);
+      lo = std::min(lo, row);
+      hi = std::max(hi, row);
+      varType aUx = 0, aUy = 0, aVx = 0, aVy = 0;
+      if (affine) {
+        aUx = P.cux[p] * fields.dx;
+        aUy = P.cuy[p] * fields.dy;
+        aVx = P.cvx[p] * fields.dx;
+        aVy = P.cvy[p] * fields.dy;
+      }
+      scatter(stencilAt(xs, ys, REAL_LITERAL(0.0), REAL_LITERAL(0.5)), u.nx,
+              u.ny, P.u[p], aUx, aUy, wU, mU);
+      scatter(stencilAt(xs, ys, REAL_LITERAL(0.5), REAL_LITERAL(0.0)), v.nx,
+              v.ny, P.v[p], aVx, aVy, wV, mV);
+    }
+    rowLo[THREAD_NUM()] = lo;
+    rowHi[THREAD_NUM()] = hi;
+  }
+
+  // Reduce the per-thread buffers row by row and clear them for the next
+  // step. A particle in cell row r only reaches grid rows r-1 … r+1, so a
+  // thread is skipped on rows outside its band; after a sort the bands are
+  // narrow and the reduction costs about one pass over the grid. Faces
+  // without particle support keep their current value.
+  const int nThreads = MAX_THREADS();
+  auto reduce = [&](Grid2D &g, Grid2D &copy, const std::size_t wOff,
+                    const std::size_t mOff) {
+    const int gnx = g.nx;
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int j = 0; j < g.ny; ++j) {
+      const std::size_t row = static_cast<std::size_t>(gnx) * j;
+      varType *W = nullptr;
+      varType *M = nullptr;
+      for (int t = 0; t < nThreads; ++t) {
+        if (j < rowLo[t] - 1 || j > rowHi[t] + 1)
+          continue;
+        varType *w = accum.data() + accumStride * t + wOff + row;
+        varType *m = accum.data() + accumStride * t + mOff + row;
+        if (!W) { // first contributing thread accumulates the others
+          W = w;
+          M = m;
+          continue;
+        }
+        for (int i = 0; i < gnx; ++i) {
+          W[i] += w[i];
+          M[i] += m[i];
+          w[i] = m[i] = REAL_LITERAL(0.0);
+        }
+      }
+
+      varType *dst = g.A.data() + row;
+      if (W) {
+        for (int i = 0; i < gnx; ++i) {
+          if (W[i] > REAL_LITERAL(0.0))
+            dst[i] = M[i] / W[i];
+          W[i] = M[i] = REAL_LITERAL(0.0);
+        }
+      }
+      std::copy(dst, dst + gnx, copy.A.data() + row);
+    }
+  };
+  reduce(u, fields.uNext, 0, uSize);
+  reduce(v, fields.vNext, 2 * uSize, 2 * uSize + vSize);
+}
+
+// Grid → particle
+
+void ParticleTransport::GridToParticles() {
+  Particles &P = particles;
+  const int n = static_cast<int>(P.size());
+
+  if (cfg.scheme == TransportConfig::Scheme::APIC) {
+    OMP_PRAGMA(omp parallel for schedule(static))
+    for (int p = 0; p < n; ++p) {
+      const varType xs = P.x[p] * invDx;
+      const varType ys = P.y[p] * invDy;
+      varType gx, gy;
+      gatherAffine(fields.u,
+                   stencilAt(xs, ys, REAL_LITERAL(0.0), REAL_LITERAL(0.5)),
+                   P.u[p], gx, gy);
+      P.cux[p] = gx * invDx;
+      P.cuy[p] = gy * invDy;
+      gatherAffine(fields.v,
+                   stencilAt(xs, ys, REAL_LITERAL(0.5), REAL_LITERAL(0.0)),
+                   P.v[p], gx, gy);
+      P.cvx[p] = gx * invDx;
+      P.cvy[p] = gy * invDy;
+    }
+    return;
+  }
+
+  // PIC is FLIP with a zero ratio: the particle value is then discarded.
+  const varType alpha =
+      (cfg.scheme == TransportConfig::Scheme::FLIP)
+          ? static_cast<varType>(cfg.flipRatio)
+          : REAL_LITERAL(0.0);
+
+  OMP_PRAGMA(omp parallel)
+  {
+    varType xs[BATCH], ys[BATCH];
+    varType uNew[BATCH], vNew[BATCH], uOld[BATCH], vOld[BATCH];
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int b = 0; b < n; b += BATCH) {
+      const int m = std::min(BATCH, n - b);
+      varType *up = P.u.data() + b;
+      varType *vp = P.v.data() + b;
+      sampleVelocity(m, P.x.data() + b, P.y.data() + b, xs, ys, uNew, vNew);
+
+      if (alpha == REAL_LITERAL(0.0)) {
+        std::copy(uNew, uNew + m, up);
+        std::copy(vNew, vNew + m, vp);
+        continue;
+      }
+
+      // Same scaled positions, grid velocity before the projection.
+      fields.uNext.InterpolateBatch(m, xs, ys, REAL_LITERAL(0.0),
+                                    REAL_LITERAL(0.5), uOld);
+      fields.vNext.InterpolateBatch(m, xs, ys, REAL_LITERAL(0.5),
+                                    REAL_LITERAL(0.0), vOld);
+      OMP_PRAGMA(omp simd)
+      for (int k = 0; k < m; ++k) {
+        up[k] = uNew[k] + alpha * (up[k] - uOld[k]);
+        vp[k] = vNew[k] + alpha * (vp[k] - vOld[k]);
+      }
+    }
+  }
+}
+
+// Particle advection
+
+void ParticleTransport::AdvectParticles() {
+  Particles &P = particles;
+  const int n = static_cast<int>(P.size());
+  const varType dt = fields.dt;
+  const varType halfDt = REAL_LITERAL(0.5) * dt;
+  // Keep particles strictly inside the domain so their cell index is valid.
+  const varType xMax = static_cast<varType>(fields.nx) * fields.dx *
+                       (REAL_LITERAL(1.0) - REAL_EPSILON * 16);
+  const varType yMax = static_cast<varType>(fields.ny) * fields.dy *
+                       (REAL_LITERAL(1.0) - REAL_EPSILON * 16);
+
+  OMP_PRAGMA(omp parallel)
+  {
+    varType xs[BATCH], ys[BATCH], uu[BATCH], vv[BATCH];
+    varType xm[BATCH], ym[BATCH];
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int b = 0; b < n; b += BATCH) {
+      const int m = std::min(BATCH, n - b);
+      varType *x = P.x.data() + b;
+      varType *y = P.y.data() + b;
+
+      sampleVelocity(m, x, y, xs, ys, uu, vv);
+      for (int k = 0; k < m; ++k) {
+        xm[k] = std::clamp(x[k] + halfDt * uu[k], REAL_LITERAL(0.0), xMax);
+        ym[k] = std::clamp(y[k] + halfDt * vv[k], REAL_LITERAL(0.0), yMax);
+      }
+
+      sampleVelocity(m, xm, ym, xs, ys, uu, vv);
+      for (int k = 0; k < m; ++k) {
+        const varType xn = std::clamp(x[k] + dt * uu[k], REAL_LITERAL(0.0),
+                                      xMax);
+        const varType yn = std::clamp(y[k] + dt * vv[k], REAL_LITERAL(0.0),
+                                      yMax);
+        if (!inSolid(xn, yn)) {
+          x[k] = xn;
+          y[k] = yn;
+        }
+      }
+    }
+  }
+}
+
+} // namespace PIC_REAL
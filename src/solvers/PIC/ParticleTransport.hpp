@@ -0,0 +1,164 @@
+#pragma once
+#include "../../core/Fields.hpp"
+#include "../../core/Parameters.hpp"
+#include "Particles.hpp"
+#include <vector>
+
+/**
+ * @file ParticleTransport.hpp
+ * @brief PIC / FLIP / APIC velocity transport on the MAC grid.
+ */
+
+namespace PIC_REAL {
+
+/**
+ * @brief Carries velocity on particles and exchanges it with a MAC grid.
+ *
+ * The grid solver keeps doing what it does for every scheme (sources,
+ * pressure projection, velocity correction); this class only replaces the
+ * semi-Lagrangian velocity advection. One time step reads:
+ *
+ * 1. @c ParticlesToGrid(): splat particle velocities onto the u/v faces
+ *    (P2G) and keep a copy of the result for the FLIP update.
+ * 2. The caller applies sources and projects the grid velocity.
+ * 3. @c GridToParticles(): update particle velocities from the projected
+ *    grid (G2P), as PIC, PIC/FLIP blend or APIC.
+ * 4. @c AdvectParticles(): move the particles through the projected grid
+ *    velocity (RK2).
+ *
+ * All transfers use the bilinear (linear B-spline) kernel of each staggered
+ * component, i.e. the same stencil as the grid interpolation.
+ *
+ * P2G is parallel without atomics: each thread splats its share of the
+ * particles into a private accumulation buffer, and a second pass reduces
+ * the buffers face by face.
+ *
+ * ### Particle ordering
+ * Every @c cfg.sortInterval steps the particles are counting-sorted by cell
+ * (row-major, like the grids). Neighbouring particles then splat into
+ * neighbouring faces, and each thread's contiguous share of the particles
+ * covers a narrow band of grid rows; the P2G reduction only visits the
+ * threads whose band contains a row. The same O(N) pass drops particles in
+ * SOLID cells and beyond @c cfg.maxPerCell, and tops up FLUID cells holding
+ * fewer than @c cfg.minPerCell, writing a compact array with no holes.
+ */
+class ParticleTransport {
+public:
+  /**
+   * @brief Seed @c cfg.particlesPerCell particles in every FLUID cell.
+   *
+   * Particles are placed on a jittered sub-cell lattice (deterministic, so
+   * runs are reproducible) and take the current grid velocity.
+   *
+   * @param cfg    Transport settings (copied).
+   * @param fields Grid the particles live on (non-owning, must outlive this
+   *               object).
+   */
+  ParticleTransport(const TransportConfig &cfg, Fields2D &fields);
+
+  /**
+   * @brief Transfer particle velocities to the grid (P2G).
+   *
+   * Faces with particle support receive the kernel-weighted average of the
+   * nearby particle velocities (plus the affine term for APIC); faces
+   * without any particle keep their previous value. The result is also
+   * copied into @c Fields2D::uNext / @c vNext, which are otherwise unused
+   * when particles transport the velocity, as the reference for FLIP.
+   */
+  void ParticlesToGrid();
+
+  /**
+   * @brief Update particle velocities from the grid (G2P).
+   *
+   * - PIC:  \f$ u_p = u(x_p) \f$
+   * - FLIP: \f$ u_p = u(x_p) + \alpha\,(u_p - u^{old}(x_p)) \f$, the blend
+   *   of the PIC value and the FLIP increment with @c flipRatio = α.
+   * - APIC: \f$ u_p = u(x_p) \f$ and \f$ c_p = \nabla u(x_p) \f$.
+   */
+  void GridToParticles();
+
+  /**
+   * @brief Move the particles through the grid velocity (RK2 midpoint).
+   *
+   * Positions are clamped to the domain; a particle whose new position
+   * falls into a SOLID cell stays where it was.
+   */
+  void AdvectParticles();
+
+  /// @return The particle store (read-only).
+  [[nodiscard]] const Particles &GetParticles() const { return particles; }
+
+  /// @return P2G calls so far (sets the re-sort schedule).
+  [[nodiscard]] int StepCount() const { return stepCount; }
+
+  /**
+   * @brief Replace the particles and the step counter with those of an
+   *        earlier run (restart from a checkpoint).
+   *
+   * The cell offsets stay those of the seeding until the next sort.
+   *
+   * @param restored Particle store to adopt.
+   * @param steps    @c StepCount() of the earlier run.
+   */
+  void RestoreState(Particles restored, int steps);
+
+  /**
+   * @brief Per-cell offsets of the last sort.
+   *
+   * Particles of cell c = nx·j + i occupy [offsets[c], offsets[c+1]). The
+   * buckets describe the particles as of the last sort; they go stale as
+   * particles move until the next one.
+   */
+  [[nodiscard]] const std::vector<int> &CellOffsets() const {
+    return cellStart;
+  }
+
+private:
+  TransportConfig cfg;
+  Fields2D &fields;
+  varType invDx, invDy; ///< 1/dx, 1/dy.
+
+  Particles particles;
+
+  /// Per-thread P2G buffers: [wU | mU | wV | mV] per thread.
+  std::vector<varType> accum;
+  std::size_t accumStride = 0; ///< Values per thread in @c accum.
+  std::vector<int> rowLo;      ///< Lowest cell row splatted, per thread.
+  std::vector<int> rowHi;      ///< Highest cell row splatted, per thread.
+
+  // Sorting / bucketing
+  int stepCount = 0;          ///< P2G calls so far (drives the re-sort).
+  Particles sorted;           ///< Target of the sort, swapped with particles.
+  std::vector<int> cellStart; ///< nx·ny + 1 bucket offsets.
+  std::vector<int> cellKept;  ///< Particles kept per cell in the last sort.
+  std::vector<int> cellOf;    ///< Cell of each particle during the sort.
+  std::vector<int> histogram; ///< Per-thread cell counts / write cursors.
+
+  /// @brief Fill the particle store (see constructor).
+  void seed();
+
+  /**
+   * @brief Counting-sort the particles by cell, applying the per-cell
+   *        bounds (deletion in SOLID / overfull cells, reseeding of sparse
+   *        FLUID cells), and rebuild @c cellStart.
+   */
+  void sortParticles();
+
+  /// @return Flat index of the cell containing physical position (x, y).
+  [[nodiscard]] int cellIndex(varType x, varType y) const;
+
+  /// @return @c true if physical position (x, y) lies in a SOLID cell.
+  [[nodiscard]] bool inSolid(varType x, varType y) const;
+
+  /**
+   * @brief Interpolate u and v at a batch of positions.
+   * @param n      Number of positions (at most the batch size).
+   * @param x,y    Physical positions.
+   * @param xs,ys  Scratch for the scaled positions.
+   * @param u,v    Interpolated velocity.
+   */
+  void sampleVelocity(int n, const varType *x, const varType *y, varType *xs,
+                      varType *ys, varType *u, varType *v) const;
+};
+
+} // namespace PIC_REAL
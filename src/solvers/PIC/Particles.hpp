@@ -0,0 +1,54 @@
+#pragma once
+#include "../../core/Precision.hpp"
+#include <cstddef>
+#include <vector>
+
+/**
+ * @file Particles.hpp
+ * @brief Structure-of-arrays particle store for the particle transport.
+ */
+
+namespace PIC_REAL {
+
+/**
+ * @brief Marker particles carrying velocity, stored as structure-of-arrays.
+ *
+ * Every attribute lives in its own contiguous array, so the transfer kernels
+ * stream only the attributes they touch and can process particles in
+ * SIMD-sized batches (e.g. through @c Grid2D::InterpolateBatch()).
+ *
+ * The affine arrays @c cux … @c cvy are only allocated for APIC; for the
+ * other schemes they stay empty.
+ */
+struct Particles {
+  std::vector<varType> x;   ///< Physical x-position.
+  std::vector<varType> y;   ///< Physical y-position.
+  std::vector<varType> u;   ///< x-velocity.
+  std::vector<varType> v;   ///< y-velocity.
+  std::vector<varType> cux; ///< APIC: \f$ \partial u / \partial x \f$.
+  std::vector<varType> cuy; ///< APIC: \f$ \partial u / \partial y \f$.
+  std::vector<varType> cvx; ///< APIC: \f$ \partial v / \partial x \f$.
+  std::vector<varType> cvy; ///< APIC: \f$ \partial v / \partial y \f$.
+
+  /// @return Number of particles.
+  [[nodiscard]] std::size_t size() const { return x.size(); }
+
+  /**
+   * @brief Resize every attribute array to @p n particles.
+   * @param n      New particle count.
+   * @param affine Also size the APIC arrays.
+   */
+  void resize(const std::size_t n, const bool affine) {
+    x.resize(n);
+    y.resize(n);
+    u.resize(n);
+    v.resize(n);
+    const std::size_t na = affine ? n : 0;
+    cux.resize(na);
+    cuy.resize(na);
+    cvx.resize(na);
+    cvy.resize(na);
+  }
+};
+
+} // namespace PIC_REAL
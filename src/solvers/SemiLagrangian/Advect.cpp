@@ -1,192 +1,516 @@
 #include "SemiLagrangian.hpp"
 #include <algorithm>
 #include <cmath>
+#include <utility>
 
 // Semi-Lagrangian advection
 //  Each velocity component is advected independently:
 //    1. For every face (i,j), trace a particle backward in time using RK2
 //       to find the "departure point" (x_dep, y_dep).
 //    2. Interpolate the current velocity field at that point.
-//    3. Store the result in new grids, then move them into the fields.
+//    3. Store the result in the persistent back-buffers, then swap them with
+//       the current fields.
 //
-//  Using separate new grids ensures all reads come from the current-step
-//  values — equivalent to a Jacobi-style update.
+//  Writing into separate buffers ensures all reads come from the
+//  current-step values — equivalent to a Jacobi-style update — which also
+//  makes every row independent, so rows are distributed over threads.
 //
-//  Loop order: j (outer) → i (inner) so that consecutive Set() calls write
-//  to consecutive memory locations (row-major: A[nx*j + i]).
-
-void SemiLagrangian::Advect() const {
-  Grid2D uNew(fields->u.nx, fields->u.ny);
-  Grid2D vNew(fields->v.nx, fields->v.ny);
-
-  for (int j = 0; j < fields->u.ny; ++j)
-    for (int i = 0; i < fields->u.nx; ++i) {
-      varType x, y;
-      traceParticleU(i, j, x, y);
-      uNew.Set(i, j, interpolateU(x, y));
-    }
+//  Each row is processed as a batch: the RK2 trace runs over contiguous
+//  arrays of positions and the interpolation goes through
+//  Grid2D::InterpolateBatch(), so the inner loops vectorise and the result
+//  is written straight into the destination row. A tiled smoke grid
+//  (SmokeLayout) has no such row: its rows are computed in a row buffer and
+//  stored into the tiles with SetRow().
+//
+//  The final interpolation is bilinear or monotone cubic, per field
+//  (TransportConfig::velocityInterpolation / smokeInterpolation); the
+//  velocity samples of the trace itself are always bilinear.
+//
+//  Loop order: j (outer) → i (inner) so that consecutive writes go to
+//  consecutive memory locations (row-major: A[nx*j + i]). The static
+//  schedule over j matches the first-touch initialisation in Grid2D, so each
+//  thread keeps writing the rows whose pages it owns.
+
+namespace PIC_REAL {
+
+namespace {
+
+/// Cells the cubic stencil reaches past a departure point (bilinear: 1).
+constexpr int SMOKE_STENCIL = 2;
+
+/// @brief Interpolate @p n points of @p g, bilinearly or with the cubic.
+template <typename Layout>
+void interpolate(const BasicGrid2D<Layout> &g, const bool cubic, const int n,
+                 const varType *xs, const varType *ys, const varType offX,
+                 const varType offY, varType *out) {
+  if (cubic)
+    g.InterpolateCubicBatch(n, xs, ys, offX, offY, out);
+  else
+    g.InterpolateBatch(n, xs, ys, offX, offY, out);
+}
 
-  for (int j = 0; j < fields->v.ny; ++j)
-    for (int i = 0; i < fields->v.nx; ++i) {
-      varType x, y;
-      traceParticleV(i, j, x, y);
-      vNew.Set(i, j, interpolateV(x, y));
-    }
+/// @brief Cells i0 … i0+n-1 of row @p j of @p g, contiguous: the row itself
+///        for layouts with contiguous rows, else a copy in @p buf.
+template <typename Layout>
+const varType *readRow(const BasicGrid2D<Layout> &g, const int j, const int i0,
+                       const int n, varType *buf) {
+  if constexpr (Layout::strided) {
+    return g.A.data() + g.layout(i0, j);
+  } else {
+    g.GetRow(j, i0, n, buf);
+    return buf;
+  }
+}
 
-  fields->u = std::move(uNew);
-  fields->v = std::move(vNew);
+/// @brief Where to compute row @p j of @p g from column @p i0 on: the row
+///        itself for layouts with contiguous rows, else @p buf, which
+///        storeRow() then copies into the grid.
+template <typename Layout>
+varType *rowTarget(BasicGrid2D<Layout> &g, const int j, const int i0,
+                   varType *buf) {
+  if constexpr (Layout::strided)
+    return g.A.data() + g.layout(i0, j);
+  else
+    return buf;
 }
 
-void SemiLagrangian::AdvectSmoke() const {
-  Grid2D smokeNew(fields->smokeMap.nx, fields->smokeMap.ny);
+/// @brief Store @p n values computed at rowTarget() (nothing to do for
+///        contiguous rows).
+template <typename Layout>
+void storeRow(BasicGrid2D<Layout> &g, const int j, const int i0, const int n,
+              const varType *src) {
+  if constexpr (!Layout::strided)
+    g.SetRow(j, i0, n, src);
+}
 
-  for (int j = 0; j < fields->smokeMap.ny; ++j) {
-    for (int i = 0; i < fields->smokeMap.nx; ++i) {
+} // namespace
 
-      // Physical position of cell centre (i, j)
-      const varType x0 = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
-      const varType y0 = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
+SemiLagrangian::AdvectRow SemiLagrangian::advectRow(const int thread) {
+  varType *base = advectScratch.data() +
+                  static_cast<std::size_t>(8) * advectRowLen * thread;
+  const std::size_t n = advectRowLen;
+  return {base,         base + n,     base + 2 * n, base + 3 * n,
+          base + 4 * n, base + 5 * n, base + 6 * n, base + 7 * n};
+}
 
-      // RK2 backward trace
-      varType u0, v0;
-      getVelocity(x0, y0, u0, v0);
-      const varType xMid = x0 - REAL_LITERAL(0.5) * dt * u0;
-      const varType yMid = y0 - REAL_LITERAL(0.5) * dt * v0;
+void SemiLagrangian::Advect() {
+  const bool cubic = params.transport.velocityInterpolation ==
+                     TransportConfig::Interpolation::CUBIC;
+  if (uCorrection) {
+    advectCorrected(fields->u, fields->uNext, *uCorrection, REAL_LITERAL(0.0),
+                    REAL_LITERAL(0.5), cubic);
+    advectCorrected(fields->v, fields->vNext, *vCorrection, REAL_LITERAL(0.5),
+                    REAL_LITERAL(0.0), cubic);
+    fields->SwapVelocityBuffers();
+    return;
+  }
 
-      varType uMid, vMid;
-      getVelocity(xMid, yMid, uMid, vMid);
-      varType xDep = x0 - dt * uMid;
-      varType yDep = y0 - dt * vMid;
+  Grid2D &uNew = fields->uNext;
+  Grid2D &vNew = fields->vNext;
+  const int unx = fields->u.nx, uny = fields->u.ny;
+  const int vnx = fields->v.nx, vny = fields->v.ny;
 
-      xDep = std::clamp(xDep, REAL_LITERAL(0.0),
-                        static_cast<varType>(nx - 1) * dx);
-      yDep = std::clamp(yDep, REAL_LITERAL(0.0),
-                        static_cast<varType>(ny - 1) * dy);
+  OMP_PRAGMA(omp parallel)
+  {
+    AdvectRow row = advectRow(THREAD_NUM());
+
+    // u-faces sit at (i·dx, (j+0.5)·dy).
+    OMP_PRAGMA(omp for schedule(static) nowait)
+    for (int j = 0; j < uny; ++j) {
+      const varType y0 = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
+      for (int i = 0; i < unx; ++i) {
+        row.x0[i] = static_cast<varType>(i) * dx;
+        row.y0[i] = y0;
+      }
+      traceDepartureRow(unx, row, dt);
+      varType *dst = uNew.A.data() + static_cast<std::size_t>(unx) * j;
+      interpolate(fields->u, cubic, unx, row.xs, row.ys, REAL_LITERAL(0.0),
+                  REAL_LITERAL(0.5), dst);
+    }
 
-      smokeNew.Set(i, j, interpolateSmoke(xDep, yDep));
+    // v-faces sit at ((i+0.5)·dx, j·dy).
+    OMP_PRAGMA(omp for schedule(static))
+    for (int j = 0; j < vny; ++j) {
+      const varType y0 = static_cast<varType>(j) * dy;
+      for (int i = 0; i < vnx; ++i) {
+        row.x0[i] = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
+        row.y0[i] = y0;
+      }
+      traceDepartureRow(vnx, row, dt);
+      varType *dst = vNew.A.data() + static_cast<std::size_t>(vnx) * j;
+      interpolate(fields->v, cubic, vnx, row.xs, row.ys, REAL_LITERAL(0.5),
+                  REAL_LITERAL(0.0), dst);
     }
   }
 
-  fields->smokeMap = std::move(smokeNew);
+  fields->SwapVelocityBuffers();
 }
 
-// RK2 backward particle traces
-
-void SemiLagrangian::traceParticleU(const int i, const int j, varType &x,
-                                    varType &y) const {
-  // u-face physical position: (i·dx, (j+0.5)·dy).
-  const varType x0 = static_cast<varType>(i) * dx;
-  const varType y0 = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
-
-  varType u0, v0;
-  getVelocity(x0, y0, u0, v0);
-  const varType xMid = x0 - REAL_LITERAL(0.5) * dt * u0;
-  const varType yMid = y0 - REAL_LITERAL(0.5) * dt * v0;
+// Sparse smoke
+//
+//  With sparse smoke (Fields2D::smokeTiles) the smoke is traced on the
+//  tiles that hold some, dilated by the reach of one step, instead of on
+//  every cell. A row is cut into runs of active tiles, each traced as one
+//  batch by the row kernels below; the occupancy of the new values is
+//  recorded as they are written, so the smoke itself is scanned only on
+//  the first step. The cost of the smoke trace then follows the size of
+//  the plume rather than that of the domain.
+
+void SemiLagrangian::updateSmokeTiles(const double rate) {
+  // A departure point lies within dt·rate cells of its node.
+  const SparseSmokeConfig &cfg = params.sparseSmoke;
+  const int reach = static_cast<int>(std::ceil(dt * rate)) + SMOKE_STENCIL +
+                    cfg.band;
+  ActiveTiles &tiles = fields->smokeTiles;
+  tiles.Update(fields->smokeMap, static_cast<varType>(cfg.threshold), reach);
+  profiler.count(SMOKE_TILES, static_cast<double>(tiles.ActiveCount()));
+}
 
-  varType uMid, vMid;
-  getVelocity(xMid, yMid, uMid, vMid);
-  x = x0 - dt * uMid;
-  y = y0 - dt * vMid;
+template <typename TraceSpan>
+void SemiLagrangian::smokeRow(const int j, varType *buf,
+                              TraceSpan &&traceSpan) {
+  ActiveTiles &tiles = fields->smokeTiles;
+  SmokeGrid2D &next = fields->smokeNext;
+  const int snx = next.nx;
+  // Cells [i0, i1) of the row, traced into out[0, i1 - i0).
+  auto span = [&](const int i0, const int i1) {
+    varType *out = rowTarget(next, j, i0, buf);
+    traceSpan(i0, i1, out);
+    storeRow(next, j, i0, i1 - i0, out);
+    return out;
+  };
+  if (!tiles.enabled()) {
+    span(0, snx);
+    return;
+  }
 
-  x = std::clamp(x, REAL_LITERAL(0.0), static_cast<varType>(nx - 1) * dx);
-  y = std::clamp(y, REAL_LITERAL(0.0), static_cast<varType>(ny - 1) * dy);
+  const varType threshold = static_cast<varType>(params.sparseSmoke.threshold);
+  const int tile = tiles.tile(), tj = j / tile, tx = tiles.tilesX();
+  for (int ti = 0; ti < tx;) {
+    const int i0 = ti * tile;
+    if (!tiles.Active(ti, tj)) {
+      if (tiles.Cleared(ti, tj)) {
+        const int n = std::min(i0 + tile, snx) - i0;
+        varType *out = rowTarget(next, j, i0, buf);
+        std::fill_n(out, n, varType{0});
+        storeRow(next, j, i0, n, out);
+      }
+      tiles.SetNextOccupied(j, ti, false);
+      ++ti;
+      continue;
+    }
+    int end = ti + 1;
+    while (end < tx && tiles.Active(end, tj))
+      ++end;
+    const varType *out = span(i0, std::min(end * tile, snx));
+    for (; ti < end; ++ti) {
+      bool occupied = false;
+      for (int i = ti * tile; i < std::min((ti + 1) * tile, snx); ++i)
+        occupied |= std::abs(out[i - i0]) > threshold;
+      tiles.SetNextOccupied(j, ti, occupied);
+    }
+  }
 }
 
-void SemiLagrangian::traceParticleV(const int i, const int j, varType &x,
-                                    varType &y) const {
-  // v-face physical position: ((i+0.5)·dx, j·dy).
-  const varType x0 = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
-  const varType y0 = static_cast<varType>(j) * dy;
-
-  varType u0, v0;
-  getVelocity(x0, y0, u0, v0);
-  const varType xMid = x0 - REAL_LITERAL(0.5) * dt * u0;
-  const varType yMid = y0 - REAL_LITERAL(0.5) * dt * v0;
+void SemiLagrangian::AdvectSmoke() {
+  const bool cubic = params.transport.smokeInterpolation ==
+                     TransportConfig::Interpolation::CUBIC;
+  if (smokeCorrection) {
+    advectCorrected(fields->smokeMap, fields->smokeNext, *smokeCorrection,
+                    REAL_LITERAL(0.5), REAL_LITERAL(0.5), cubic);
+    fields->SwapSmokeBuffer();
+    return;
+  }
 
-  varType uMid, vMid;
-  getVelocity(xMid, yMid, uMid, vMid);
-  x = x0 - dt * uMid;
-  y = y0 - dt * vMid;
+  const int sny = fields->smokeMap.ny;
 
-  x = std::clamp(x, REAL_LITERAL(0.0), static_cast<varType>(nx - 1) * dx);
-  y = std::clamp(y, REAL_LITERAL(0.0), static_cast<varType>(ny - 1) * dy);
-}
+  OMP_PRAGMA(omp parallel)
+  {
+    AdvectRow row = advectRow(THREAD_NUM());
 
-// Bilinear interpolation
+    // smokeMap is cell-centred: ((i+0.5)·dx, (j+0.5)·dy).
+    OMP_PRAGMA(omp for schedule(static))
+    for (int j = 0; j < sny; ++j) {
+      const varType y0 = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
+      // row.u is free once a span is traced: the row buffer of tiled smoke.
+      smokeRow(j, row.u, [&](const int i0, const int i1, varType *out) {
+        const int n = i1 - i0;
+        for (int k = 0; k < n; ++k) {
+          row.x0[k] = (static_cast<varType>(i0 + k) + REAL_LITERAL(0.5)) * dx;
+          row.y0[k] = y0;
+        }
+        traceDepartureRow(n, row, dt);
+        interpolate(fields->smokeMap, cubic, n, row.xs, row.ys,
+                    REAL_LITERAL(0.5), REAL_LITERAL(0.5), out);
+      });
+    }
+  }
 
-varType SemiLagrangian::interpolateU(const varType x, const varType y) const {
-  const varType i_real = x / dx;
-  const varType j_real = y / dy - REAL_LITERAL(0.5);
+  fields->SwapSmokeBuffer();
+}
 
-  int i = static_cast<int>(std::floor(i_real));
-  int j = static_cast<int>(std::floor(j_real));
+// Fused semi-Lagrangian advection of u, v and the smoke
+//
+//  One row-parallel pass handles u-face row j, v-face row j and smoke row j
+//  together, so each thread streams the velocity rows around j once for all
+//  three traces instead of once per field (Advect() + AdvectSmoke()), and
+//  the rows are still in cache when the next field reads them.
+//
+//  The first RK2 stage samples the velocity at the grid nodes themselves,
+//  where bilinear interpolation reduces to fixed stencils:
+//    u-face (i, j+½):   u exact,              v = mean of its 4 neighbours
+//    v-face (i+½, j):   u = mean of 4,        v exact
+//    cell   (i+½, j+½): u = mean of 2,        v = mean of 2
+//  (neighbour indices clamped like InterpolateBatch() does at the border).
+//  These are contiguous, gather-free loads; only the midpoint samples of
+//  the second stage need the bilinear kernel. Per cell and step this takes
+//  3 × 2 + 3 interpolations instead of 3 × 4 + 3.
+//
+//  Both fields are traced through the same (projected) velocity; the
+//  results go to the back-buffers, swapped in at the end.
 
-  const varType fx = i_real - static_cast<varType>(i);
-  const varType fy = j_real - static_cast<varType>(j);
+void SemiLagrangian::AdvectFused() {
+  const int vny = fields->v.ny;
 
-  i = std::clamp(i, 0, fields->u.nx - 2);
-  j = std::clamp(j, 0, fields->u.ny - 2);
+  OMP_PRAGMA(omp parallel)
+  {
+    AdvectRow row = advectRow(THREAD_NUM());
 
-  const varType u00 = fields->u.Get(i, j);
-  const varType u10 = fields->u.Get(i + 1, j);
-  const varType u01 = fields->u.Get(i, j + 1);
-  const varType u11 = fields->u.Get(i + 1, j + 1);
+    // v has the most rows (ny + 1); u and the smoke stop earlier.
+    OMP_PRAGMA(omp for schedule(static))
+    for (int j = 0; j < vny; ++j)
+      advectFusedRow(j, row);
+  }
 
-  return (REAL_LITERAL(1.0) - fy) *
-             ((REAL_LITERAL(1.0) - fx) * u00 + fx * u10) +
-         fy * ((REAL_LITERAL(1.0) - fx) * u01 + fx * u11);
+  fields->SwapVelocityBuffers();
+  fields->SwapSmokeBuffer();
 }
 
-varType SemiLagrangian::interpolateV(const varType x, const varType y) const {
-  const varType i_real = x / dx - REAL_LITERAL(0.5);
-  const varType j_real = y / dy;
+void SemiLagrangian::advectFusedRow(const int j, AdvectRow &row) {
+  const Grid2D &u = fields->u, &v = fields->v;
+  const SmokeGrid2D &smoke = fields->smokeMap;
+  const bool cubicVelocity = params.transport.velocityInterpolation ==
+                             TransportConfig::Interpolation::CUBIC;
+  const bool cubicSmoke = params.transport.smokeInterpolation ==
+                          TransportConfig::Interpolation::CUBIC;
+  const int unx = u.nx, uny = u.ny;
+  const int vnx = v.nx;
+  const int sny = smoke.ny;
+  const varType halfDt = REAL_LITERAL(0.5) * dt;
+  auto rowOf = [](auto &g, const int r) {
+    return g.A.data() + static_cast<std::size_t>(g.nx) * r;
+  };
+
+  if (j < uny) {
+    // u-faces at (i·dx, (j+0.5)·dy).
+    const varType *uj = rowOf(u, j);
+    const varType *v0 = rowOf(v, j);
+    const varType *v1 = rowOf(v, j + 1);
+    const varType y0 = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
+    OMP_PRAGMA(omp simd)
+    for (int i = 0; i < unx; ++i) {
+      const int a = std::min(std::max(i - 1, 0), vnx - 2);
+      const varType vi =
+          REAL_LITERAL(0.25) * (v0[a] + v0[a + 1] + v1[a] + v1[a + 1]);
+      row.x0[i] = static_cast<varType>(i) * dx;
+      row.y0[i] = y0;
+      row.x[i] = row.x0[i] - halfDt * uj[i];
+      row.y[i] = y0 - halfDt * vi;
+    }
+    traceFromMidpoint(unx, row, dt);
+    interpolate(u, cubicVelocity, unx, row.xs, row.ys, REAL_LITERAL(0.0),
+                REAL_LITERAL(0.5), rowOf(fields->uNext, j));
+  }
 
-  int i = static_cast<int>(std::floor(i_real));
-  int j = static_cast<int>(std::floor(j_real));
+  {
+    // v-faces at ((i+0.5)·dx, j·dy).
+    const int b = std::min(std::max(j - 1, 0), uny - 2);
+    const varType *u0 = rowOf(u, b);
+    const varType *u1 = rowOf(u, b + 1);
+    const varType *vj = rowOf(v, j);
+    const varType y0 = static_cast<varType>(j) * dy;
+    OMP_PRAGMA(omp simd)
+    for (int i = 0; i < vnx; ++i) {
+      const varType ui =
+          REAL_LITERAL(0.25) * (u0[i] + u0[i + 1] + u1[i] + u1[i + 1]);
+      row.x0[i] = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
+      row.y0[i] = y0;
+      row.x[i] = row.x0[i] - halfDt * ui;
+      row.y[i] = y0 - halfDt * vj[i];
+    }
+    traceFromMidpoint(vnx, row, dt);
+    interpolate(v, cubicVelocity, vnx, row.xs, row.ys, REAL_LITERAL(0.5),
+                REAL_LITERAL(0.0), rowOf(fields->vNext, j));
+  }
 
-  const varType fx = i_real - static_cast<varType>(i);
-  const varType fy = j_real - static_cast<varType>(j);
+  if (j < sny) {
+    // Smoke cells at ((i+0.5)·dx, (j+0.5)·dy), in spans of active tiles.
+    const varType *uj = rowOf(u, j);
+    const varType *v0 = rowOf(v, j);
+    const varType *v1 = rowOf(v, j + 1);
+    const varType y0 = (static_cast<varType>(j) + REAL_LITERAL(0.5)) * dy;
+    smokeRow(j, row.u, [&](const int i0, const int i1, varType *out) {
+      const int n = i1 - i0;
+      OMP_PRAGMA(omp simd)
+      for (int k = 0; k < n; ++k) {
+        const int i = i0 + k;
+        const varType ui = REAL_LITERAL(0.5) * (uj[i] + uj[i + 1]);
+        const varType vi = REAL_LITERAL(0.5) * (v0[i] + v1[i]);
+        row.x0[k] = (static_cast<varType>(i) + REAL_LITERAL(0.5)) * dx;
+        row.y0[k] = y0;
+        row.x[k] = row.x0[k] - halfDt * ui;
+        row.y[k] = y0 - halfDt * vi;
+      }
+      traceFromMidpoint(n, row, dt);
+      interpolate(smoke, cubicSmoke, n, row.xs, row.ys, REAL_LITERAL(0.5),
+                  REAL_LITERAL(0.5), out);
+    });
+  }
+}
 
-  i = std::clamp(i, 0, fields->v.nx - 2);
-  j = std::clamp(j, 0, fields->v.ny - 2);
+// Error-corrected advection (MacCormack / BFECC)
+//
+//  Built from the same row kernels as Advect(): every pass traces a row of
+//  nodes, at (i+offX)·dx, (j+offY)·dy, through the current velocity and
+//  interpolates with InterpolateBatch(). Passes are separated by the
+//  implicit barrier of their omp for, since each one reads neighbouring
+//  rows of the previous one's output.
+//
+//    1. Backward trace: q̂ = A(q) into qNext. The departure points are kept
+//       in scratch.xs / scratch.ys for the limiter (and BFECC's last pass).
+//    2. Forward trace (-dt) from q̂: q̄ = A^R(q̂), the estimate of q that
+//       the error is measured against, ½(q - q̄).
+//         MacCormack: work = q̂ + ½(q - q̄), limited, swapped into qNext
+//         BFECC:      work = q  + ½(q - q̄)
+//    3. BFECC only: qNext = A(work) at the stored departure points, limited.
+//
+//  The limiter clamps to the range of the q values around the departure
+//  point, which bounds the result like the first-order scheme's and keeps
+//  the correction from creating over- and undershoots at sharp fronts.
+
+template <typename Layout>
+void SemiLagrangian::advectCorrected(const BasicGrid2D<Layout> &q,
+                                     BasicGrid2D<Layout> &qNext,
+                                     CorrectionScratch<Layout> &scratch,
+                                     const varType offX, const varType offY,
+                                     const bool cubic) {
+  const bool bfecc =
+      params.transport.advection == TransportConfig::Advection::BFECC;
+  const int n = q.nx, rows = q.ny;
+
+  OMP_PRAGMA(omp parallel)
+  {
+    AdvectRow row = advectRow(THREAD_NUM());
+    auto startRow = [&](const int j) {
+      const varType y0 = (static_cast<varType>(j) + offY) * dy;
+      for (int i = 0; i < n; ++i) {
+        row.x0[i] = (static_cast<varType>(i) + offX) * dx;
+        row.y0[i] = y0;
+      }
+    };
+    auto rowOf = [n](auto &g, const int j) {
+      return g.A.data() + static_cast<std::size_t>(n) * j;
+    };
+
+    // 1. q̂ = A(q).
+    OMP_PRAGMA(omp for schedule(static))
+    for (int j = 0; j < rows; ++j) {
+      startRow(j);
+      traceDepartureRow(n, row, dt);
+      varType *dst = rowTarget(qNext, j, 0, row.u);
+      interpolate(q, cubic, n, row.xs, row.ys, offX, offY, dst);
+      storeRow(qNext, j, 0, n, dst);
+      std::copy_n(row.xs, n, rowOf(scratch.xs, j));
+      std::copy_n(row.ys, n, rowOf(scratch.ys, j));
+    }
 
-  const varType v00 = fields->v.Get(i, j);
-  const varType v10 = fields->v.Get(i + 1, j);
-  const varType v01 = fields->v.Get(i, j + 1);
-  const varType v11 = fields->v.Get(i + 1, j + 1);
+    // 2. q̄ = A^R(q̂) (into row.u, free once the trace is done).
+    OMP_PRAGMA(omp for schedule(static))
+    for (int j = 0; j < rows; ++j) {
+      startRow(j);
+      traceDepartureRow(n, row, -dt);
+      interpolate(qNext, cubic, n, row.xs, row.ys, offX, offY, row.u);
+
+      // The other trace buffers are free now: tiled rows are staged there.
+      const varType *qRow = readRow(q, j, 0, n, row.v);
+      const varType *base = bfecc ? qRow : readRow(qNext, j, 0, n, row.x);
+      varType *dst = rowTarget(scratch.work, j, 0, row.y);
+      OMP_PRAGMA(omp simd)
+      for (int i = 0; i < n; ++i)
+        dst[i] = base[i] + REAL_LITERAL(0.5) * (qRow[i] - row.u[i]);
+      if (!bfecc)
+        q.LimitBatch(n, rowOf(scratch.xs, j), rowOf(scratch.ys, j), offX,
+                     offY, dst);
+      storeRow(scratch.work, j, 0, n, dst);
+    }
 
-  return (REAL_LITERAL(1.0) - fy) *
-             ((REAL_LITERAL(1.0) - fx) * v00 + fx * v10) +
-         fy * ((REAL_LITERAL(1.0) - fx) * v01 + fx * v11);
-}
+    // 3. BFECC: q^{n+1} = A(q̃) from the stored departure points.
+    if (bfecc) {
+      OMP_PRAGMA(omp for schedule(static))
+      for (int j = 0; j < rows; ++j) {
+        const varType *xs = rowOf(scratch.xs, j);
+        const varType *ys = rowOf(scratch.ys, j);
+        varType *dst = rowTarget(qNext, j, 0, row.u);
+        interpolate(scratch.work, cubic, n, xs, ys, offX, offY, dst);
+        q.LimitBatch(n, xs, ys, offX, offY, dst);
+        storeRow(qNext, j, 0, n, dst);
+      }
+    }
+  }
 
-void SemiLagrangian::getVelocity(const varType x, const varType y, varType &u,
-                                 varType &v) const {
-  u = interpolateU(x, y);
-  v = interpolateV(x, y);
+  if (!bfecc)
+    std::swap(qNext, scratch.work);
 }
 
-varType SemiLagrangian::interpolateSmoke(const varType x,
-                                         const varType y) const {
-  // smokeMap is cell-centred: (i+0.5)*dx, (j+0.5)*dy
-  const varType i_real = x / dx - REAL_LITERAL(0.5);
-  const varType j_real = y / dy - REAL_LITERAL(0.5);
-
-  int i = static_cast<int>(std::floor(i_real));
-  int j = static_cast<int>(std::floor(j_real));
+// Batched velocity sampling and RK2 backward traces
 
-  const varType fx = i_real - static_cast<varType>(i);
-  const varType fy = j_real - static_cast<varType>(j);
+void SemiLagrangian::sampleVelocity(const int n, const varType *x,
+                                    const varType *y, AdvectRow &row) const {
+  // One scaling for both components; u and v differ only by their offsets.
+  OMP_PRAGMA(omp simd)
+  for (int k = 0; k < n; ++k) {
+    row.xs[k] = x[k] * invDx;
+    row.ys[k] = y[k] * invDy;
+  }
+  fields->u.InterpolateBatch(n, row.xs, row.ys, REAL_LITERAL(0.0),
+                             REAL_LITERAL(0.5), row.u);
+  fields->v.InterpolateBatch(n, row.xs, row.ys, REAL_LITERAL(0.5),
+                             REAL_LITERAL(0.0), row.v);
+}
 
-  i = std::clamp(i, 0, fields->smokeMap.nx - 2);
-  j = std::clamp(j, 0, fields->smokeMap.ny - 2);
+void SemiLagrangian::traceDepartureRow(const int n, AdvectRow &row,
+                                       const varType traceDt) const {
+  const varType halfDt = REAL_LITERAL(0.5) * traceDt;
 
-  const varType s00 = fields->smokeMap.Get(i, j);
-  const varType s10 = fields->smokeMap.Get(i + 1, j);
-  const varType s01 = fields->smokeMap.Get(i, j + 1);
-  const varType s11 = fields->smokeMap.Get(i + 1, j + 1);
+  // Midpoint.
+  sampleVelocity(n, row.x0, row.y0, row);
+  OMP_PRAGMA(omp simd)
+  for (int k = 0; k < n; ++k) {
+    row.x[k] = row.x0[k] - halfDt * row.u[k];
+    row.y[k] = row.y0[k] - halfDt * row.v[k];
+  }
+  traceFromMidpoint(n, row, traceDt);
+}
 
-  return (REAL_LITERAL(1.0) - fy) *
-             ((REAL_LITERAL(1.0) - fx) * s00 + fx * s10) +
-         fy * ((REAL_LITERAL(1.0) - fx) * s01 + fx * s11);
+void SemiLagrangian::traceFromMidpoint(const int n, AdvectRow &row,
+                                       const varType traceDt) const {
+  const varType xMax = static_cast<varType>(nx - 1) * dx;
+  const varType yMax = static_cast<varType>(ny - 1) * dy;
+
+  // Departure point from the midpoint velocity, clamped to the domain and
+  // scaled to index space for the final interpolation.
+  sampleVelocity(n, row.x, row.y, row);
+  OMP_PRAGMA(omp simd)
+  for (int k = 0; k < n; ++k) {
+    const varType x = std::min(
+        std::max(row.x0[k] - traceDt * row.u[k], REAL_LITERAL(0.0)), xMax);
+    const varType y = std::min(
+        std::max(row.y0[k] - traceDt * row.v[k], REAL_LITERAL(0.0)), yMax);
+    row.x[k] = x;
+    row.y[k] = y;
+    row.xs[k] = x * invDx;
+    row.ys[k] = y * invDy;
+  }
 }
+
+} // namespace PIC_REAL
@@ -0,0 +1,298 @@
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Preconditioned Conjugate Gradient
+//
+// The pressure Poisson system solved by the relaxation methods is, for every
+// FLUID cell (i,j) with N in-domain neighbours:
+//
+//   N·p_ij - Σ_{nb} p_nb = -coef·div_ij
+//
+// SOLID neighbours keep their pressure fixed: they enter A·p as known
+// values, which amounts to moving them to the right-hand side. The
+// remaining matrix A couples FLUID cells only and is symmetric positive
+// (semi-)definite, which is what CG requires:
+//
+//   A_ii = N,  A_ij = -1 for FLUID neighbours,
+//   b_ij = -coef·div_ij + Σ_{SOLID nb} p_nb
+//
+// All work vectors are flat nx × ny arrays (row-major, like Grid2D) whose
+// non-FLUID entries stay zero; this lets dot products and the triangular
+// solves of MIC(0) run over whole arrays without label checks on neighbours.
+//
+// The iteration itself, solvePCG(), works on any symmetric 5-point
+// StencilOperator: it also solves the viscous Helmholtz systems (with the
+// Jacobi preconditioner), u and v in the same passes.
+
+namespace PIC_REAL {
+
+namespace {
+
+double dot(const std::vector<double> &a, const std::vector<double> &b) {
+  double sum = 0.0;
+  const int n = static_cast<int>(a.size());
+  OMP_PRAGMA(omp parallel for reduction(+ : sum) schedule(static))
+  for (int k = 0; k < n; ++k)
+    sum += a[k] * b[k];
+  return sum;
+}
+
+} // namespace
+
+// MIC(0) preconditioner
+
+void SemiLagrangian::buildMICPreconditioner() {
+  // Modified Incomplete Cholesky, level 0 (Bridson, "Fluid Simulation for
+  // Computer Graphics", §5.3). The factor L = F·E⁻¹ + E keeps the sparsity of
+  // A; only the diagonal E is stored, as precon = 1/E. Because every
+  // off-diagonal of A is -1, the usual products Aplusi·precon collapse to
+  // plain precon values of the FLUID lower/left neighbours.
+  const double tau = params.solver.micTau;
+  const double sigma = params.solver.micSigma;
+  std::vector<double> &precon = pcg.precon;
+  precon.assign(static_cast<std::size_t>(nx) * ny, 0.0);
+
+  auto fluid = [this](int i, int j) {
+    return i >= 0 && i < nx && j >= 0 && j < ny &&
+           fields->Label(i, j) == Fields2D::FLUID;
+  };
+
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      if (!fluid(i, j))
+        continue;
+
+      const double diag = (i + 1 < nx) + (i - 1 >= 0) + (j + 1 < ny) +
+                          (j - 1 >= 0); // same N as getUpdate()
+      double e = diag;
+
+      if (fluid(i - 1, j)) {
+        const double pl = precon[nx * j + i - 1];
+        e -= pl * pl;
+        if (fluid(i - 1, j + 1))
+          e -= tau * pl * pl;
+      }
+      if (fluid(i, j - 1)) {
+        const double pb = precon[nx * (j - 1) + i];
+        e -= pb * pb;
+        if (fluid(i + 1, j - 1))
+          e -= tau * pb * pb;
+      }
+
+      if (e < sigma * diag)
+        e = diag;
+      precon[nx * j + i] = 1.0 / std::sqrt(e);
+    }
+  }
+
+  pcg.labelsVersion = fields->LabelsVersion();
+}
+
+void SemiLagrangian::applyPreconditioner(const std::vector<double> &r,
+                                         std::vector<double> &z) {
+  switch (pcg.active) {
+  case SolverConfig::Preconditioner::NONE:
+    z = r;
+    return;
+  case SolverConfig::Preconditioner::MULTIGRID:
+    applyMultigrid(r, z);
+    return;
+  case SolverConfig::Preconditioner::SPECTRAL:
+    applySpectral(r, z, true);
+    return;
+  case SolverConfig::Preconditioner::MIC0:
+    break;
+  }
+
+  const std::vector<double> &precon = pcg.precon;
+
+  // Forward substitution L·q = r (q stored in z). Non-FLUID entries have
+  // precon = 0, so they stay zero and contribute nothing to their neighbours.
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      const int k = nx * j + i;
+      if (precon[k] == 0.0)
+        continue;
+      double t = r[k];
+      if (i > 0)
+        t += precon[k - 1] * z[k - 1];
+      if (j > 0)
+        t += precon[k - nx] * z[k - nx];
+      z[k] = t * precon[k];
+    }
+  }
+
+  // Backward substitution Lᵀ·z = q, in place.
+  for (int j = ny - 1; j >= 0; --j) {
+    for (int i = nx - 1; i >= 0; --i) {
+      const int k = nx * j + i;
+      if (precon[k] == 0.0)
+        continue;
+      double t = z[k];
+      if (i + 1 < nx)
+        t += precon[k] * z[k + 1];
+      if (j + 1 < ny)
+        t += precon[k] * z[k + nx];
+      z[k] = t * precon[k];
+    }
+  }
+}
+
+// Solver
+
+void SemiLagrangian::SolvePCG(int maxIters, double tol) {
+  computeDivergence();
+  preparePressureSystem(density * dx * dx / dt);
+
+  // Geometry-dependent preconditioner data is rebuilt only when the solid
+  // mask changed since it was last built.
+  pcg.active = params.solver.preconditioner;
+  if (pcg.active == SolverConfig::Preconditioner::SPECTRAL) {
+    if (spectral.labelsVersion != fields->LabelsVersion())
+      setupSpectral();
+    if (!spectral.valid)
+      pcg.active = SolverConfig::Preconditioner::MIC0;
+  }
+  if (pcg.active == SolverConfig::Preconditioner::MIC0 &&
+      pcg.labelsVersion != fields->LabelsVersion())
+    buildMICPreconditioner();
+  if (pcg.active == SolverConfig::Preconditioner::MULTIGRID)
+    prepareMultigrid();
+
+  LinearSystem &sys = pressure.sys;
+  solvePCG(&sys, 1, maxIters, tol,
+           [this](const std::vector<double> &r, std::vector<double> &z) {
+             applyPreconditioner(r, z);
+           });
+  finishSolve("PCG", sys.iterations, sys.res, sys.res0, sys.converged);
+}
+
+void SemiLagrangian::solvePCG(LinearSystem *sys, const int count,
+                              const int maxIters, const double tol,
+                              const Precondition &precondition) {
+  const bool jacobi = !precondition;
+  for (int c = 0; c < count; ++c)
+    sys[c].begin();
+  auto allDone = [&] {
+    for (int c = 0; c < count; ++c)
+      if (!sys[c].done)
+        return false;
+    return true;
+  };
+
+  // r = b - A·x from the current x (warm start); with Jacobi also
+  // z = s = D⁻¹·r. The fixed entries of z, s and q are cleared, so that
+  // the vectors stay clean when the mask changed since the last solve.
+  std::array<double, 4> sums =
+      forEachRow(sys, count, [&](const int c, const int j, double *acc) {
+        LinearSystem &h = sys[c];
+        const StencilOperator &op = h.op;
+        op.applyRow(h.x, h.stride, h.free.data(), j, h.r.data());
+        const std::size_t row = static_cast<std::size_t>(op.nx) * j;
+        double rz = 0.0, rr = 0.0;
+        for (int i = 0; i < op.nx; ++i) {
+          const std::size_t k = row + i;
+          const double r = h.free[k] ? h.b[k] - h.r[k] : 0.0;
+          h.r[k] = r;
+          h.z[k] = h.s[k] = (jacobi && h.free[k]) ? r / op.diagonal(i, j)
+                                                  : 0.0;
+          h.q[k] = 0.0;
+          rz += r * h.z[k];
+          rr += r * r;
+        }
+        acc[0] += rz;
+        acc[1] += rr;
+      });
+  for (int c = 0; c < count; ++c) {
+    LinearSystem &h = sys[c];
+    if (h.done)
+      continue;
+    h.res = std::sqrt(sums[2 * c + 1] / h.unknowns);
+    h.converged = h.done = checkConvergence(h.res, h.res0, 0, tol);
+    h.rho = sums[2 * c];
+    if (!h.done && !jacobi) {
+      precondition(h.r, h.z);
+      h.s = h.z;
+      h.rho = dot(h.z, h.r);
+    }
+  }
+
+  std::array<double, 2> step = {0.0, 0.0};
+  for (int it = 1; it <= maxIters && !allDone(); ++it) {
+    // q = A·s (s is zero on the fixed cells).
+    sums = forEachRow(sys, count, [&](const int c, const int j, double *acc) {
+      LinearSystem &h = sys[c];
+      h.op.applyRow(h.s.data(), h.op.nx, h.free.data(), j, h.q.data());
+      const std::size_t row = static_cast<std::size_t>(h.op.nx) * j;
+      double sq = 0.0;
+      OMP_PRAGMA(omp simd reduction(+ : sq))
+      for (int i = 0; i < h.op.nx; ++i)
+        sq += h.s[row + i] * h.q[row + i];
+      acc[0] += sq;
+    });
+    for (int c = 0; c < count; ++c) {
+      LinearSystem &h = sys[c];
+      if (h.done)
+        continue;
+      if (sums[2 * c] <= 0.0) {
+        // Breakdown: A is only semi-definite on a closed domain.
+        h.iterations = it;
+        h.done = true;
+      } else {
+        step[c] = h.rho / sums[2 * c];
+      }
+    }
+
+    // x += α·s, r -= α·q; with Jacobi also z = D⁻¹·r.
+    sums = forEachRow(sys, count, [&](const int c, const int j, double *acc) {
+      LinearSystem &h = sys[c];
+      const double alpha = step[c];
+      const std::size_t row = static_cast<std::size_t>(h.op.nx) * j;
+      varType *x = h.row(j);
+      double rz = 0.0, rr = 0.0;
+      for (int i = 0; i < h.op.nx; ++i) {
+        const std::size_t k = row + i;
+        x[i] += static_cast<varType>(alpha * h.s[k]);
+        const double r = h.r[k] - alpha * h.q[k];
+        h.r[k] = r;
+        if (jacobi) {
+          h.z[k] = h.free[k] ? r / h.op.diagonal(i, j) : 0.0;
+          rz += r * h.z[k];
+        }
+        rr += r * r;
+      }
+      acc[0] += rz;
+      acc[1] += rr;
+    });
+    for (int c = 0; c < count; ++c) {
+      LinearSystem &h = sys[c];
+      if (h.done)
+        continue;
+      h.iterations = it;
+      h.res = std::sqrt(sums[2 * c + 1] / h.unknowns);
+      h.converged = h.done = checkConvergence(h.res, h.res0, it, tol);
+      if (h.done)
+        continue;
+      if (!jacobi) {
+        precondition(h.r, h.z);
+        sums[2 * c] = dot(h.z, h.r);
+      }
+      step[c] = sums[2 * c] / h.rho; // β
+      h.rho = sums[2 * c];
+    }
+
+    // s = z + β·s.
+    forEachRow(sys, count, [&](const int c, const int j, double *) {
+      LinearSystem &h = sys[c];
+      const double beta = step[c];
+      const std::size_t row = static_cast<std::size_t>(h.op.nx) * j;
+      OMP_PRAGMA(omp simd)
+      for (int i = 0; i < h.op.nx; ++i)
+        h.s[row + i] = h.z[row + i] + beta * h.s[row + i];
+    });
+  }
+}
+
+} // namespace PIC_REAL
@@ -0,0 +1,352 @@
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <thread>
+
+// Domain-decomposed time step
+//
+//  The pressure grid is cut into slabs of whole rows, one per thread, split
+//  like a static schedule over the rows: each thread also advects the rows
+//  of u, v and the smoke it first-touched. A slab keeps its own padded copy
+//  of p, the right-hand side and the diagonal, allocated by its thread.
+//
+//  One parallel region runs the step:
+//    1. p of the owned rows (and the halo rows) copied in, rhs = -coef·div;
+//    2. red-black Gauss-Seidel sweeps. After each colour a slab publishes
+//       its first and last row and waits for its two neighbours' rows only
+//       (epoch flags, no team barrier);
+//    3. every check_interval iterations the residual is summed over the
+//       slabs, the only team barrier of the solve;
+//    4. p copied back, velocity update of the owned faces;
+//    5. barrier, fused advection of the owned rows, barrier and swap (with
+//       sparse smoke, one thread picks the smoke tiles after the first
+//       barrier);
+//    6. divergence and |u| of the owned rows.
+//  Steps 5-6 trace departure points anywhere in the domain, so they read
+//  the shared u, v and smoke; only their writes stay inside the slab.
+//
+//  Residual for free: the Gauss-Seidel update of a cell is
+//  p' = (rhs + Σ p_nb) / N, so its residual before the update is
+//  N·(p' - p). During the red sweep of iteration k the black neighbours
+//  still hold iterate k-1, and the black cells themselves were solved
+//  exactly by the previous black sweep; the red sweep therefore measures
+//  the full residual of iterate k-1 at no extra cost, and the test lags one
+//  iteration behind the shared-memory solver.
+
+namespace PIC_REAL {
+
+namespace {
+
+/// Doubles per slab in DecompositionWorkspace::partial (one cache line).
+constexpr int PARTIAL_STRIDE = 8;
+
+/// @brief Spin until @p flag has reached @p epoch.
+void waitFor(const std::atomic<uint64_t> &flag, const uint64_t epoch) {
+  while (flag.load(std::memory_order_acquire) < epoch)
+    std::this_thread::yield();
+}
+
+} // namespace
+
+double SemiLagrangian::relaxColour(Subdomain &sd, const int nx,
+                                   const bool red) {
+  PaddedGrid2D<1> &p = sd.p;
+  const int stride = p.layout.stride();
+  const int h = sd.j1 - sd.j0;
+  double sumSq = 0.0;
+  for (int jl = 0; jl < h; ++jl) {
+    varType *pj = p.A.data() + p.layout(0, jl);
+    const varType *bj = sd.rhs.A.data() + sd.rhs.layout(0, jl);
+    const varType *dj = sd.diag.A.data() + sd.diag.layout(0, jl);
+    const varType *ij = sd.invDiag.A.data() + sd.invDiag.layout(0, jl);
+    for (int i = (sd.j0 + jl + (red ? 0 : 1)) & 1; i < nx; i += 2) {
+      if (ij[i] == REAL_LITERAL(0.0))
+        continue; // SOLID or isolated
+      const varType sum = pj[i - 1] + pj[i + 1] + pj[i - stride] +
+                          pj[i + stride];
+      const varType next = (bj[i] + sum) * ij[i];
+      const double r = static_cast<double>(dj[i]) * (next - pj[i]);
+      sumSq += r * r;
+      pj[i] = next;
+    }
+  }
+  return sumSq;
+}
+
+double SemiLagrangian::slabResidual(const Subdomain &sd, const int nx) {
+  const PaddedGrid2D<1> &p = sd.p;
+  const int stride = p.layout.stride();
+  const int h = sd.j1 - sd.j0;
+  double sumSq = 0.0;
+  for (int jl = 0; jl < h; ++jl) {
+    const varType *pj = p.A.data() + p.layout(0, jl);
+    const varType *bj = sd.rhs.A.data() + sd.rhs.layout(0, jl);
+    const varType *dj = sd.diag.A.data() + sd.diag.layout(0, jl);
+    for (int i = 0; i < nx; ++i) {
+      if (dj[i] == REAL_LITERAL(0.0))
+        continue;
+      const double r = static_cast<double>(bj[i]) + pj[i - 1] + pj[i + 1] +
+                       pj[i - stride] + pj[i + stride] - dj[i] * pj[i];
+      sumSq += r * r;
+    }
+  }
+  return sumSq;
+}
+
+void SemiLagrangian::prepareDecomposition(const int parts) {
+  DecompositionWorkspace &ws = decomposition;
+  if (static_cast<int>(ws.sub.size()) == parts)
+    return;
+
+  // The slabs themselves are allocated by their threads (first touch).
+  ws.sub.clear();
+  ws.sub.resize(parts);
+  ws.partial.assign(static_cast<std::size_t>(2) * parts * PARTIAL_STRIDE, 0.0);
+  ws.exchanges = 0;
+  ws.labelsVersion = std::numeric_limits<uint64_t>::max();
+}
+
+bool SemiLagrangian::StepDecomposed(const bool transport) {
+  DecompositionWorkspace &ws = decomposition;
+  const int parts = std::max(1, std::min(MAX_THREADS(), ny));
+  prepareDecomposition(parts);
+
+  const bool rebuild = ws.labelsVersion != fields->LabelsVersion();
+  const bool warm = params.solver.warmStart;
+  const int maxIters = params.solver.maxIters;
+  const double tol = params.solver.tolerance;
+  const int checkEvery = params.decomposition.checkInterval;
+  const varType coef = density * dx * dx / dt;
+  const varType velCoef = dt / (density * dx);
+  const uint64_t epoch0 = ws.exchanges;
+  uint64_t exchanges = 0;
+  solveStats = PressureSolveStats{};
+  solveStats.warmStarted = warm;
+
+  // OMP_DYNAMIC, a thread limit or a nested region may grant fewer threads
+  // than slabs, whose rows would then go unsolved. Every thread sees the
+  // same team size, so either all the slabs run or none does.
+  bool complete = true;
+  OMP_PRAGMA(omp parallel num_threads(parts))
+  {
+    if (TEAM_SIZE() != parts) {
+      OMP_PRAGMA(omp single nowait)
+      complete = false;
+    } else {
+      const int s = THREAD_NUM();
+      const bool master = (s == 0);
+
+      // Rows split like schedule(static): the first ny % parts slabs get one
+      // extra row.
+      const int q = ny / parts, extra = ny % parts;
+      const int j0 = s * q + std::min(s, extra);
+      const int j1 = j0 + q + (s < extra ? 1 : 0);
+      const int h = j1 - j0;
+      if (!ws.sub[s])
+        ws.sub[s] = std::make_unique<Subdomain>(nx, j0, j1);
+      Subdomain &sd = *ws.sub[s];
+
+      // 1. Diagonal (on a geometry change), p with its halo rows, rhs.
+      if (master)
+        profiler.enter(DIVERGENCE);
+      if (rebuild) {
+        sd.fluidCells = 0;
+        for (int j = j0; j < j1; ++j)
+          for (int i = 0; i < nx; ++i) {
+            const int n = (i + 1 < nx) + (i > 0) + (j + 1 < ny) + (j > 0);
+            const bool fluid =
+                fields->Label(i, j) == Fields2D::FLUID && n > 0;
+            sd.diag.Set(i, j - j0, fluid ? static_cast<varType>(n)
+                                         : REAL_LITERAL(0.0));
+            sd.invDiag.Set(i, j - j0,
+                           fluid ? REAL_LITERAL(1.0) / n : REAL_LITERAL(0.0));
+            sd.fluidCells += fluid;
+          }
+      }
+      // A cold start clears the FLUID pressures, halo rows included.
+      for (int j = std::max(j0 - 1, 0); j < std::min(j1 + 1, ny); ++j)
+        for (int i = 0; i < nx; ++i)
+          sd.p.Set(i, j - j0,
+                   (warm || fields->Label(i, j) != Fields2D::FLUID)
+                       ? fields->p.Get(i, j)
+                       : REAL_LITERAL(0.0));
+      for (int j = j0; j < j1; ++j)
+        for (int i = 0; i < nx; ++i) {
+          const varType d = (fields->u.Get(i + 1, j) - fields->u.Get(i, j)) /
+                                dx +
+                            (fields->v.Get(i, j + 1) - fields->v.Get(i, j)) /
+                                dy;
+          sd.rhs.Set(i, j - j0, -coef * d);
+        }
+      if (master) {
+        profiler.leave();
+        profiler.enter(PRESSURE);
+      }
+
+      // 2.-3. Red-black sweeps with halo exchanges. The neighbours' slabs
+      //       are only known to exist after the first reduction's barrier.
+      Subdomain *below = nullptr, *above = nullptr;
+      uint64_t epoch = epoch0;
+      auto exchange = [&] {
+        const int parity = static_cast<int>(++epoch & 1);
+        std::copy_n(sd.p.A.data() + sd.p.layout(0, 0), nx,
+                    sd.edge[0][parity].data());
+        std::copy_n(sd.p.A.data() + sd.p.layout(0, h - 1), nx,
+                    sd.edge[1][parity].data());
+        sd.published.store(epoch, std::memory_order_release);
+        if (below) {
+          waitFor(below->published, epoch);
+          std::copy_n(below->edge[1][parity].data(), nx,
+                      sd.p.A.data() + sd.p.layout(0, -1));
+        }
+        if (above) {
+          waitFor(above->published, epoch);
+          std::copy_n(above->edge[0][parity].data(), nx,
+                      sd.p.A.data() + sd.p.layout(0, h));
+        }
+      };
+      int reductions = 0;
+      auto reduce = [&](const double sumSq) {
+        const std::size_t parity = reductions++ & 1;
+        double *slot = ws.partial.data() +
+                       (parity * parts + s) * PARTIAL_STRIDE;
+        slot[0] = sumSq;
+        slot[1] = sd.fluidCells;
+        OMP_PRAGMA(omp barrier)
+        // Every slab sums the slots in the same order: identical decisions.
+        const double *base =
+            slot - static_cast<std::size_t>(s) * PARTIAL_STRIDE;
+        double total = 0.0, count = 0.0;
+        for (int k = 0; k < parts; ++k) {
+          total += base[k * PARTIAL_STRIDE];
+          count += base[k * PARTIAL_STRIDE + 1];
+        }
+        return count > 0.0 ? std::sqrt(total / count) : 0.0;
+      };
+
+      double res0 = 1.0;
+      double res = reduce(slabResidual(sd, nx));
+      if (s > 0)
+        below = ws.sub[s - 1].get();
+      if (s + 1 < parts)
+        above = ws.sub[s + 1].get();
+      bool converged = checkConvergence(res, res0, 0, tol);
+      int it = 0;
+      while (!converged && it < maxIters) {
+        const double sumSq = relaxColour(sd, nx, true);
+        exchange();
+        relaxColour(sd, nx, false);
+        exchange();
+        ++it;
+        // sumSq is the residual of iterate it - 1 (see above).
+        if (it > 1 && (it % checkEvery == 0 || it == maxIters)) {
+          res = reduce(sumSq);
+          converged = checkConvergence(res, res0, it - 1, tol);
+        }
+      }
+
+      // 4. Pressure back to the shared field, velocity update of the owned
+      //    faces (v row j0 reads the received halo row j0 - 1).
+      for (int j = j0; j < j1; ++j)
+        std::copy_n(sd.p.A.data() + sd.p.layout(0, j - j0), nx,
+                    fields->p.A.data() + fields->p.layout(0, j));
+      if (master) {
+        profiler.leave();
+        exchanges = epoch - epoch0;
+        finishSolve("RedBlackGS (decomposed)", it, res, res0, converged);
+        profiler.count(PRESSURE_ITERATIONS, solveStats.iterations);
+        profiler.count(PRESSURE_RESIDUAL, solveStats.relResidual);
+        profiler.enter(VELOCITY_UPDATE);
+      }
+      for (int j = j0; j < j1; ++j)
+        for (int i = 1; i < nx; ++i) {
+          const bool solid = fields->Label(i - 1, j) == Fields2D::SOLID ||
+                             fields->Label(i, j) == Fields2D::SOLID;
+          fields->u.Set(i, j,
+                        solid ? fields->usolid
+                              : fields->u.Get(i, j) -
+                                    velCoef * (sd.p.Get(i, j - j0) -
+                                               sd.p.Get(i - 1, j - j0)));
+        }
+      for (int j = std::max(j0, 1); j < j1; ++j)
+        for (int i = 0; i < nx; ++i) {
+          const bool solid = fields->Label(i, j - 1) == Fields2D::SOLID ||
+                             fields->Label(i, j) == Fields2D::SOLID;
+          fields->v.Set(i, j,
+                        solid ? fields->usolid
+                              : fields->v.Get(i, j) -
+                                    velCoef * (sd.p.Get(i, j - j0) -
+                                               sd.p.Get(i, j - j0 - 1)));
+        }
+      if (master)
+        profiler.leave();
+
+      if (transport) {
+        // 5. The traces read the whole velocity: wait for every slab's
+        //    update. v has one more row than p; the last slab advects it.
+        if (master)
+          profiler.enter(ADVECT);
+        const int rowEnd = (s + 1 == parts) ? fields->v.ny : j1;
+        const bool sparse = fields->smokeTiles.enabled();
+        if (sparse) {
+          // Sparse smoke: the largest velocity of the slab's faces, reduced
+          // by the thread that then picks the smoke tiles for every slab.
+          varType uMax = REAL_LITERAL(0.0), vMax = REAL_LITERAL(0.0);
+          for (int j = j0; j < j1; ++j)
+            for (int i = 0; i < fields->u.nx; ++i)
+              uMax = std::max(uMax, std::abs(fields->u.Get(i, j)));
+          for (int j = j0; j < rowEnd; ++j)
+            for (int i = 0; i < nx; ++i)
+              vMax = std::max(vMax, std::abs(fields->v.Get(i, j)));
+          ws.partial[static_cast<std::size_t>(s) * PARTIAL_STRIDE + 2] =
+              std::max(static_cast<double>(uMax) / params.dx,
+                       static_cast<double>(vMax) / params.dy);
+        }
+        OMP_PRAGMA(omp barrier)
+        if (sparse) {
+          OMP_PRAGMA(omp single)
+          {
+            double rate = 0.0;
+            for (int k = 0; k < parts; ++k)
+              rate = std::max(rate, ws.partial[k * PARTIAL_STRIDE + 2]);
+            updateSmokeTiles(rate);
+          }
+        }
+        AdvectRow row = advectRow(s);
+        for (int j = j0; j < rowEnd; ++j)
+          advectFusedRow(j, row);
+        OMP_PRAGMA(omp barrier)
+        OMP_PRAGMA(omp single)
+        {
+          fields->SwapVelocityBuffers();
+          fields->SwapSmokeBuffer();
+        }
+        if (master) {
+          profiler.leave();
+          profiler.enter(DIAGNOSTICS);
+        }
+
+        // 6. Diagnostics of the owned rows.
+        fields->Div(j0, j1);
+        fields->VelocityNormCenterGrid(j0, j1);
+        if (master)
+          profiler.leave();
+      }
+    }
+  }
+  if (!complete) {
+    if (!ws.warnedTeam)
+      std::cerr << "[SemiLagrangian] Warning: the decomposed step got fewer "
+                << "threads than its " << parts
+                << " slabs; using the shared step instead.\n";
+    ws.warnedTeam = true;
+    return false;
+  }
+
+  ws.exchanges += exchanges;
+  ws.labelsVersion = fields->LabelsVersion();
+  return true;
+}
+
+} // namespace PIC_REAL
@@ -0,0 +1,253 @@
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+// Distributed time step
+//
+//  Every rank owns a slab of whole pressure rows (split like the threads of
+//  the decomposed step) and holds up to `halo` rows of each neighbour on
+//  top of it, all in an ordinary Fields2D. Halo rows are copies: their
+//  owners alone compute them, and exchangeHalo() sends them over.
+//
+//  One step on a rank:
+//    1. rhs and the owned rows of p into a padded slab, red-black
+//       Gauss-Seidel sweeps trading one p row with each neighbour after
+//       every colour; every check_interval iterations the residual is
+//       summed over the ranks (the only collective of the solve);
+//    2. p halo exchanged, velocity update of the whole local grid. The
+//       halo faces get the values their owners compute, so the traces of
+//       the owned rows read the projected velocity throughout;
+//    3. fused advection of the owned rows, then u, v and the smoke halos
+//       exchanged: the next step's sources, divergence and traces see the
+//       new values;
+//    4. divergence and |u| of the owned rows.
+//  A departure point stays within `halo` rows of its row as long as the
+//  distance travelled plus the interpolation stencil does. The fastest
+//  face over all ranks is checked every step: a faster flow is advected
+//  in sub-steps short enough to stay inside the halo.
+
+namespace PIC_REAL {
+
+namespace {
+
+/// Tags of the rows sent to the next rank up (rank + 1) and down.
+constexpr int TAG_UP = 0;
+constexpr int TAG_DOWN = 1;
+
+} // namespace
+
+template <typename Layout>
+void SemiLagrangian::exchangeHalo(BasicGrid2D<Layout> &g) {
+  const DistributedWorkspace &ws = distributed;
+  Communicator &comm = *ws.comm;
+  const int rank = comm.rank();
+  const int below = (rank > 0) ? rank - 1 : -1;
+  const int above = (rank + 1 < comm.size()) ? rank + 1 : -1;
+
+  // The lower halo has own0 rows (none on the first rank, else `halo`);
+  // the upper one has as many rows more or fewer than p's as g has (v: one
+  // more, the smoke one fewer). Every rank owns more rows than that.
+  const int halo = params.distributed.halo;
+  const int extra = g.ny - ny;
+  // The last rank has no upper halo: g.ny - b is then -1 for the smoke.
+  const int a = ws.own0, b = ws.own1;
+  const int upper = (above >= 0) ? g.ny - b : 0;
+
+  if constexpr (Layout::strided) {
+    auto at = [&g](const int j) { return g.A.data() + g.layout(0, j); };
+    // Bytes from row j to the end of row j + rows - 1 (padded rows include
+    // the padding and ghosts in between, which are zero on both sides).
+    const int pitch = g.layout.stride();
+    auto span = [&g, pitch](const int rows) {
+      return rows > 0 ? static_cast<std::size_t>(pitch * (rows - 1) + g.nx) *
+                            sizeof(varType)
+                      : std::size_t{0};
+    };
+
+    // Top owned rows up, into the lower halo of rank + 1.
+    comm.sendRecv(at(b - halo), span(halo), above, at(0), span(a), below,
+                  TAG_UP);
+    // Bottom owned rows down, into the upper halo of rank - 1.
+    comm.sendRecv(at(a), span(halo + extra), below, at(b), span(upper), above,
+                  TAG_DOWN);
+  } else {
+    // Tiled grids (the smoke, see SmokeLayout) have no contiguous rows: the
+    // same rows travel packed row-major. Nothing is packed for a missing
+    // neighbour, whose rows may lie past the grid (the smoke's last rank).
+    const std::size_t row = g.nx;
+    std::vector<varType> send, recv;
+    auto move = [&](const int from, int rows, const int dest, const int to,
+                    const int count, const int source, const int tag) {
+      if (dest < 0)
+        rows = 0;
+      send.resize(row * rows);
+      recv.resize(row * count);
+      for (int r = 0; r < rows; ++r)
+        g.GetRow(from + r, 0, g.nx, send.data() + row * r);
+      comm.sendRecv(send.data(), send.size() * sizeof(varType), dest,
+                    recv.data(), recv.size() * sizeof(varType), source, tag);
+      for (int r = 0; r < count; ++r)
+        g.SetRow(to + r, 0, g.nx, recv.data() + row * r);
+    };
+    move(b - halo, halo, above, 0, a, below, TAG_UP);
+    move(a, halo + extra, below, b, upper, above, TAG_DOWN);
+  }
+}
+
+void SemiLagrangian::solveDistributed() {
+  DistributedWorkspace &ws = distributed;
+  Communicator &comm = *ws.comm;
+  const int rank = comm.rank();
+  const int below = (rank > 0) ? rank - 1 : -1;
+  const int above = (rank + 1 < comm.size()) ? rank + 1 : -1;
+  const int gny = ws.globalNy;
+  const int a = ws.own0, h = ws.own1 - ws.own0;
+  const int j0 = ws.row0 + a; // domain row of the first owned row
+  if (!ws.slab)
+    ws.slab = std::make_unique<Subdomain>(nx, j0, j0 + h);
+  Subdomain &sd = *ws.slab;
+
+  const bool warm = params.solver.warmStart;
+  const int maxIters = params.solver.maxIters;
+  const double tol = params.solver.tolerance;
+  const int checkEvery = params.distributed.checkInterval;
+  const varType coef = density * dx * dx / dt;
+  solveStats = PressureSolveStats{};
+  solveStats.warmStarted = warm;
+
+  {
+    Profiler::Scope scope(profiler, DIVERGENCE);
+    // Diagonal from the neighbours inside the domain, not the slab.
+    if (ws.labelsVersion != fields->LabelsVersion()) {
+      sd.fluidCells = 0;
+      for (int jl = 0; jl < h; ++jl)
+        for (int i = 0; i < nx; ++i) {
+          const int j = j0 + jl;
+          const int n = (i + 1 < nx) + (i > 0) + (j + 1 < gny) + (j > 0);
+          const bool fluid =
+              fields->Label(i, a + jl) == Fields2D::FLUID && n > 0;
+          sd.diag.Set(i, jl, fluid ? static_cast<varType>(n)
+                                   : REAL_LITERAL(0.0));
+          sd.invDiag.Set(i, jl,
+                         fluid ? REAL_LITERAL(1.0) / n : REAL_LITERAL(0.0));
+          sd.fluidCells += fluid;
+        }
+      ws.labelsVersion = fields->LabelsVersion();
+    }
+    // A cold start clears the FLUID pressures, neighbour rows included.
+    for (int j = std::max(a - 1, 0); j < std::min(a + h + 1, ny); ++j)
+      for (int i = 0; i < nx; ++i)
+        sd.p.Set(i, j - a,
+                 (warm || fields->Label(i, j) != Fields2D::FLUID)
+                     ? fields->p.Get(i, j)
+                     : REAL_LITERAL(0.0));
+    for (int j = a; j < a + h; ++j)
+      for (int i = 0; i < nx; ++i) {
+        const varType d = (fields->u.Get(i + 1, j) - fields->u.Get(i, j)) /
+                              dx +
+                          (fields->v.Get(i, j + 1) - fields->v.Get(i, j)) /
+                              dy;
+        sd.rhs.Set(i, j - a, -coef * d);
+      }
+  }
+
+  {
+    Profiler::Scope scope(profiler, PRESSURE);
+    // Last owned row up, first one down, into the neighbours' halo rows.
+    const std::size_t row = static_cast<std::size_t>(nx) * sizeof(varType);
+    varType *p = sd.p.A.data();
+    auto exchange = [&] {
+      comm.sendRecv(p + sd.p.layout(0, h - 1), row, above,
+                    p + sd.p.layout(0, -1), row, below, TAG_UP);
+      comm.sendRecv(p + sd.p.layout(0, 0), row, below, p + sd.p.layout(0, h),
+                    row, above, TAG_DOWN);
+    };
+    const double cells = comm.allReduceSum(sd.fluidCells);
+    auto reduce = [&](const double sumSq) {
+      const double total = comm.allReduceSum(sumSq);
+      return cells > 0.0 ? std::sqrt(total / cells) : 0.0;
+    };
+
+    double res0 = 1.0;
+    double res = reduce(slabResidual(sd, nx));
+    bool converged = checkConvergence(res, res0, 0, tol);
+    int it = 0;
+    while (!converged && it < maxIters) {
+      const double sumSq = relaxColour(sd, nx, true);
+      exchange();
+      relaxColour(sd, nx, false);
+      exchange();
+      ++it;
+      // sumSq is the residual of iterate it - 1 (see Decomposed.cpp).
+      if (it > 1 && (it % checkEvery == 0 || it == maxIters)) {
+        res = reduce(sumSq);
+        converged = checkConvergence(res, res0, it - 1, tol);
+      }
+    }
+
+    for (int jl = 0; jl < h; ++jl)
+      std::copy_n(p + sd.p.layout(0, jl), nx,
+                  fields->p.A.data() + fields->p.layout(0, a + jl));
+    finishSolve("RedBlackGS (distributed)", it, res, res0, converged);
+  }
+  profiler.count(PRESSURE_ITERATIONS, solveStats.iterations);
+  profiler.count(PRESSURE_RESIDUAL, solveStats.relResidual);
+}
+
+void SemiLagrangian::StepDistributed() {
+  solveDistributed(); // 1.
+
+  {
+    Profiler::Scope scope(profiler, VELOCITY_UPDATE);
+    exchangeHalo(fields->p); // 2.
+    updateVelocities();
+  }
+
+  {
+    Profiler::Scope scope(profiler, ADVECT);
+    // A trace travels up to ceil(rate·dt) rows and its stencil reaches
+    // stencilReach() rows further; past the halo, sub-steps of dt / k keep
+    // it inside. Every rank takes the same k.
+    const double rate = distributed.comm->allReduceMax(velocityRate());
+    const int room =
+        params.distributed.halo - params.transport.stencilReach();
+    const int substeps =
+        std::max(1, static_cast<int>(std::ceil(rate * dt / room)));
+    if (substeps > 1 && !distributed.warnedHalo) {
+      if (distributed.comm->rank() == 0)
+        std::cerr << "[SemiLagrangian] Warning: traces of "
+                  << rate * dt << " rows exceed the halo of "
+                  << params.distributed.halo << "; advecting in "
+                  << substeps << " sub-steps.\n";
+      distributed.warnedHalo = true;
+    }
+
+    const varType stepDt = dt;
+    setTimeStep(stepDt / substeps);
+    // The owned rows of v cover those of u and the smoke.
+    const auto [first, last] = ownedRows(fields->v);
+    for (int k = 0; k < substeps; ++k) {
+      OMP_PRAGMA(omp parallel)
+      {
+        AdvectRow row = advectRow(THREAD_NUM());
+        OMP_PRAGMA(omp for schedule(static))
+        for (int j = first; j < last; ++j)
+          advectFusedRow(j, row);
+      }
+      fields->SwapVelocityBuffers();
+      fields->SwapSmokeBuffer();
+      exchangeHalo(fields->u); // 3.
+      exchangeHalo(fields->v);
+      exchangeHalo(fields->smokeMap);
+    }
+    setTimeStep(stepDt);
+  }
+
+  Profiler::Scope scope(profiler, DIAGNOSTICS);
+  fields->Div(distributed.own0, distributed.own1); // 4.
+  fields->VelocityNormCenterGrid(distributed.own0, distributed.own1);
+}
+
+} // namespace PIC_REAL
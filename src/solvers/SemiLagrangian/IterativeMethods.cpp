@@ -1,85 +1,119 @@
 #include "SemiLagrangian.hpp"
+#include <algorithm>
 #include <cmath>
 #include <iostream>
 
-// Cell update
-double SemiLagrangian::getUpdate(const int i, const int j,
-                                 const varType coef) const {
-  if (fields->Label(i, j) != Fields2D::FLUID)
-    return NAN;
-
-  // Accumulate neighbour pressures and count valid neighbours.
-  double sumP = 0.0;
-  int nb = 0;
-
-  if (i + 1 < nx) {
-    sumP += fields->p.Get(i + 1, j);
-    ++nb;
-  }
-  if (i - 1 >= 0) {
-    sumP += fields->p.Get(i - 1, j);
-    ++nb;
-  }
-  if (j + 1 < ny) {
-    sumP += fields->p.Get(i, j + 1);
-    ++nb;
-  }
-  if (j - 1 >= 0) {
-    sumP += fields->p.Get(i, j - 1);
-    ++nb;
+// Fluid-cell stencil
+//
+// The relaxation solvers only ever touch FLUID cells. Their offsets into
+// the padded p and div (one layout for both) and their neighbour counts are
+// precomputed here once per geometry, so the sweeps below run over a dense
+// list without label checks, bounds checks, or NaN sentinels: the four
+// neighbours are at ±1 and ±stride, and the zero ghost ring stands in for
+// the ones outside the domain.
+
+namespace PIC_REAL {
+
+void SemiLagrangian::updateFluidStencil() {
+  if (stencil.labelsVersion == fields->LabelsVersion())
+    return;
+
+  FluidStencil &st = stencil;
+  st.cell.clear();
+  st.count.clear();
+  st.invCount.clear();
+  st.red.clear();
+  st.black.clear();
+  st.stride = fields->p.layout.stride();
+
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      if (fields->Label(i, j) != Fields2D::FLUID)
+        continue;
+
+      const int n = (i + 1 < nx) + (i - 1 >= 0) + (j + 1 < ny) + (j - 1 >= 0);
+      if (n == 0)
+        continue; // isolated 1 x 1 domain: nothing to solve
+
+      const int t = static_cast<int>(st.cell.size());
+      st.cell.push_back(static_cast<int>(fields->p.layout(i, j)));
+      st.count.push_back(n);
+      st.invCount.push_back(1.0 / n);
+      ((i + j) % 2 == 0 ? st.red : st.black).push_back(t);
+    }
   }
 
-  if (nb == 0)
-    return NAN;
-
-  // Gauss-Seidel update:
-  //   p_new = ( -coef * div_{ij} + Σ p_nb ) / N
-  return (-coef * fields->div.Get(i, j) + sumP) / nb;
+  st.pNew.assign(st.cell.size(), 0.0);
+  st.labelsVersion = fields->LabelsVersion();
 }
 
 // Residual norm
 
 double SemiLagrangian::computeResidualNorm(const varType coef) const {
   // RMS of the discrete Poisson residual over all FLUID cells:
-  //   r_{ij} = rhs_{ij} - (A·p)_{ij}
-  //          = -coef·div_{ij}  -  (nb·p_{ij} - Σ p_nb)
+  //   r_k = rhs_k - (A·p)_k
+  //       = -coef·div_k  -  (N·p_k - Σ p_nb)
+  const varType *p = fields->p.A.data();
+  const varType *div = fields->div.A.data();
+  const int s = stencil.stride;
+  const int count = static_cast<int>(stencil.cell.size());
   double sumSq = 0.0;
-  int count = 0;
 
-OMP_PRAGMA( omp parallel for collapse(2) reduction(+ : sumSq) reduction(+ : count))
-for (int j = 0; j < ny; ++j) {
-  for (int i = 0; i < nx; ++i) {
-    if (fields->Label(i, j) != Fields2D::FLUID)
-      continue;
+  OMP_PRAGMA(omp parallel for reduction(+ : sumSq) schedule(static))
+  for (int t = 0; t < count; ++t) {
+    const int k = stencil.cell[t];
+    const double sumP =
+        static_cast<double>(p[k + 1]) + p[k - 1] + p[k + s] + p[k - s];
+    const double r = (-coef * div[k]) - (stencil.count[t] * p[k] - sumP);
+    sumSq += r * r;
+  }
 
-    double sumP = 0.0;
-    int nb = 0;
+  return (count > 0) ? std::sqrt(sumSq / count) : 0.0;
+}
 
-    if (i + 1 < nx) {
-      sumP += fields->p.Get(i + 1, j);
-      ++nb;
-    }
-    if (i - 1 >= 0) {
-      sumP += fields->p.Get(i - 1, j);
-      ++nb;
-    }
-    if (j + 1 < ny) {
-      sumP += fields->p.Get(i, j + 1);
-      ++nb;
-    }
-    if (j - 1 >= 0) {
-      sumP += fields->p.Get(i, j - 1);
-      ++nb;
-    }
+double SemiLagrangian::computeResidual(const varType coef,
+                                       std::vector<double> &r) const {
+  // Same residual as computeResidualNorm(), kept per cell for the Krylov and
+  // multigrid solvers. Whole rows at a time: the ghost ring supplies the
+  // missing neighbours and a select the zero of the non-FLUID cells.
+  const int s = fields->p.layout.stride();
+  double sumSq = 0.0;
+  int count = 0;
 
-    const double r =
-        (-coef * fields->div.Get(i, j)) - (nb * fields->p.Get(i, j) - sumP);
-    sumSq += r * r;
-    ++count;
+  OMP_PRAGMA(omp parallel for reduction(+ : sumSq, count) schedule(static))
+  for (int j = 0; j < ny; ++j) {
+    const varType *p = fields->p.A.data() + fields->p.layout(0, j);
+    const varType *div = fields->div.A.data() + fields->div.layout(0, j);
+    const std::size_t row = static_cast<std::size_t>(nx) * j;
+    const uint8_t *label = fields->Labels().data() + row;
+    double *rj = r.data() + row;
+    const int nbY = (j + 1 < ny) + (j > 0);
+
+    OMP_PRAGMA(omp simd reduction(+ : sumSq, count))
+    for (int i = 0; i < nx; ++i) {
+      const int nb = (i + 1 < nx) + (i > 0) + nbY;
+      const double sumP =
+          static_cast<double>(p[i + 1]) + p[i - 1] + p[i + s] + p[i - s];
+      const bool fluid = label[i] == Fields2D::FLUID;
+      const double rk = (-coef * div[i]) - (nb * p[i] - sumP);
+      rj[i] = fluid ? rk : 0.0;
+      sumSq += rj[i] * rj[i];
+      count += fluid;
+    }
   }
+
+  return (count > 0) ? std::sqrt(sumSq / count) : 0.0;
 }
 
-return (count > 0) ? std::sqrt(sumSq / count) : 0.0;
+void SemiLagrangian::addCorrection(const std::vector<double> &e) {
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < ny; ++j) {
+    varType *p = fields->p.A.data() + fields->p.layout(0, j);
+    const double *ej = e.data() + static_cast<std::size_t>(nx) * j;
+    OMP_PRAGMA(omp simd)
+    for (int i = 0; i < nx; ++i)
+      p[i] += static_cast<varType>(ej[i]);
+  }
 }
 
 // Convergence check
@@ -87,8 +121,8 @@ return (count > 0) ? std::sqrt(sumSq / count) : 0.0;
 // Returns true when the solver should stop.
 // On the first call (it == 0), records res0 as the reference residual so that
 // all subsequent checks use a *relative* criterion: ||r_k|| / ||r_0|| < tol.
-static bool checkConvergence(const double res, double &res0, const int it,
-                             const double tol) {
+bool SemiLagrangian::checkConvergence(const double res, double &res0,
+                                      const int it, const double tol) {
   if (it == 0) {
     res0 = res;
     return (res0 < 1e-30); // already converged if initial residual is tiny
@@ -96,113 +130,261 @@ static bool checkConvergence(const double res, double &res0, const int it,
   return (res / res0) < tol;
 }
 
+void SemiLagrangian::finishSolve(const char *name, const int iterations,
+                                 const double res, const double res0,
+                                 const bool converged) {
+  solveStats.iterations = iterations;
+  solveStats.refResidual = res0;
+  solveStats.relResidual = (res0 > 0.0) ? res / res0 : 0.0;
+  solveStats.converged = converged;
+
+#ifndef NDEBUG
+  if (converged)
+    std::cout << "  " << name << " converged in " << iterations
+              << " iters, rel.res = " << solveStats.relResidual << '\n';
+  else
+    std::cout << "  " << name << ": reached maxIters = " << iterations
+              << '\n';
+#else
+  (void)name;
+#endif
+}
+
 // Jacobi
 
 void SemiLagrangian::SolveJacobi(int maxIters, double tol) {
   const varType coef = density * dx * dx / dt;
-  fields->Div();
+  computeDivergence();
+  updateFluidStencil();
 
   // Jacobi requires a separate buffer because all reads must use the
-  // previous-iteration values.
-  Grid2D pNew(nx, ny);
+  // previous-iteration values; it is compact (FLUID cells only).
+  std::vector<double> &pNew = stencil.pNew;
+  varType *p = fields->p.A.data();
+  const int count = static_cast<int>(stencil.cell.size());
   double res0 = 1.0;
+  double res = 0.0;
 
   for (int it = 0; it < maxIters; ++it) {
+    OMP_PRAGMA(omp parallel)
+    {
+      OMP_PRAGMA(omp for schedule(static))
+      for (int t = 0; t < count; ++t)
+        pNew[t] = getUpdate(t, coef);
+
+      OMP_PRAGMA(omp for schedule(static))
+      for (int t = 0; t < count; ++t)
+        p[stencil.cell[t]] = static_cast<varType>(pNew[t]);
+    }
 
-OMP_PRAGMA( omp parallel for collapse(2))
-for (int j = 0; j < ny; ++j)
-  for (int i = 0; i < nx; ++i)
-    pNew.Set(i, j, getUpdate(i, j, coef));
-
-OMP_PRAGMA( omp parallel for collapse(2))
-for (int j = 0; j < ny; ++j)
-  for (int i = 0; i < nx; ++i)
-    if (fields->Label(i, j) == Fields2D::FLUID)
-      fields->p.Set(i, j, pNew.Get(i, j));
-
-const double res = computeResidualNorm(coef);
-if (checkConvergence(res, res0, it, tol)) {
-#ifndef NDEBUG
-  std::cout << "  Jacobi converged in " << it + 1
-            << " iters, rel.res = " << res / res0 << '\n';
-#endif
-  return;
-}
+    res = computeResidualNorm(coef);
+    if (checkConvergence(res, res0, it, tol)) {
+      finishSolve("Jacobi", it + 1, res, res0, true);
+      return;
+    }
   }
 
-#ifndef NDEBUG
-  std::cout << "  Jacobi: reached maxIters = " << maxIters << '\n';
-#endif
+  finishSolve("Jacobi", maxIters, res, res0, false);
 }
 
 // Gauss-Seidel
 
 void SemiLagrangian::SolveGaussSeidel(int maxIters, double tol) {
   const varType coef = density * dx * dx / dt;
-  fields->Div();
+  computeDivergence();
+  updateFluidStencil();
 
+  varType *p = fields->p.A.data();
+  const int count = static_cast<int>(stencil.cell.size());
   double res0 = 1.0;
+  double res = 0.0;
 
   for (int it = 0; it < maxIters; ++it) {
-    // Sequential sweep — each cell sees the latest neighbour values.
-    for (int j = 0; j < ny; ++j)
-      for (int i = 0; i < nx; ++i) {
-        const double newVal = getUpdate(i, j, coef);
-        if (!std::isnan(newVal))
-          fields->p.Set(i, j, newVal);
-      }
+    // Sequential sweep in row-major order — each cell sees the latest
+    // neighbour values.
+    for (int t = 0; t < count; ++t)
+      p[stencil.cell[t]] = static_cast<varType>(getUpdate(t, coef));
 
-    const double res = computeResidualNorm(coef);
+    res = computeResidualNorm(coef);
     if (checkConvergence(res, res0, it, tol)) {
-#ifndef NDEBUG
-      std::cout << "  GaussSeidel converged in " << it + 1
-                << " iters, rel.res = " << res / res0 << '\n';
-#endif
+      finishSolve("GaussSeidel", it + 1, res, res0, true);
       return;
     }
   }
 
-#ifndef NDEBUG
-  std::cout << "  GaussSeidel: reached maxIters = " << maxIters << '\n';
-#endif
+  finishSolve("GaussSeidel", maxIters, res, res0, false);
 }
 
 // Red-Black Gauss-Seidel
 
 void SemiLagrangian::SolveRedBlackGaussSeidel(int maxIters, double tol) {
   const varType coef = density * dx * dx / dt;
-  fields->Div();
+  computeDivergence();
+  updateFluidStencil();
 
+  varType *p = fields->p.A.data();
   double res0 = 1.0;
+  double res = computeResidualNorm(coef);
+  if (checkConvergence(res, res0, 0, tol)) {
+    finishSolve("RedBlackGS", 0, res, res0, true);
+    return;
+  }
 
-  for (int it = 0; it < maxIters; ++it) {
+  for (int it = 1; it <= maxIters; ++it) {
     // Two-colour decomposition: "red" cells (i+j even) and "black" cells
-    // (i+j odd). Each colour's cells are independent of one another, so
-    // the inner loop can be parallelised without data races.
-    for (int color = 0; color < 2; ++color) {
-OMP_PRAGMA( omp parallel for collapse(2))
-for (int j = 0; j < ny; ++j) {
-  for (int i = 0; i < nx; ++i) {
-    if ((i + j) % 2 != color)
-      continue;
-    const double newVal = getUpdate(i, j, coef);
-    if (!std::isnan(newVal))
-      fields->p.Set(i, j, newVal);
-  }
-}
+    // (i+j odd). The cells of one colour only read the other one, so each
+    // colour list is swept in parallel.
+    OMP_PRAGMA(omp parallel)
+    for (const std::vector<int> *colour : {&stencil.red, &stencil.black}) {
+      const int n = static_cast<int>(colour->size());
+      OMP_PRAGMA(omp for schedule(static))
+      for (int c = 0; c < n; ++c) {
+        const int t = (*colour)[c];
+        p[stencil.cell[t]] = static_cast<varType>(getUpdate(t, coef));
+      }
     }
 
-    const double res = computeResidualNorm(coef);
+    res = computeResidualNorm(coef);
     if (checkConvergence(res, res0, it, tol)) {
-#ifndef NDEBUG
-      std::cout << "  RedBlackGS converged in " << it + 1
-                << " iters, rel.res = " << res / res0 << '\n';
-#endif
+      finishSolve("RedBlackGS", it, res, res0, true);
       return;
     }
   }
 
-#ifndef NDEBUG
-  std::cout << "  RedBlackGS: reached maxIters = " << maxIters << '\n';
-#endif
+  finishSolve("RedBlackGS", maxIters, res, res0, false);
+}
+
+// Stencil systems
+
+void SemiLagrangian::LinearSystem::resize(const int nx, const int ny,
+                                          const bool pcg) {
+  op.nx = nx;
+  op.ny = ny;
+  const std::size_t n = static_cast<std::size_t>(nx) * ny;
+  free.assign(n, 0);
+  unknowns = 0;
+  b.assign(n, 0.0);
+  r.assign(n, 0.0);
+  if (pcg) {
+    z.assign(n, 0.0);
+    s.assign(n, 0.0);
+    q.assign(n, 0.0);
+  }
 }
+
+void SemiLagrangian::preparePressureSystem(const varType coef) {
+  LinearSystem &sys = pressure.sys;
+  if (pressure.labelsVersion != fields->LabelsVersion() ||
+      sys.x != fields->p.A.data() + fields->p.layout(0, 0)) {
+    sys.resize(fields->p, true);
+    sys.op = StencilOperator{nx, ny, 0.0, 1.0, 1.0};
+    // A FLUID cell without in-domain neighbours (1 × 1 domain) has
+    // nothing to solve.
+    for (int j = 0; j < ny; ++j)
+      for (int i = 0; i < nx; ++i) {
+        const bool unknown = fields->Label(i, j) == Fields2D::FLUID &&
+                             sys.op.diagonal(i, j) > 0.0;
+        sys.free[static_cast<std::size_t>(nx) * j + i] = unknown;
+        sys.unknowns += unknown;
+      }
+    pressure.labelsVersion = fields->LabelsVersion();
+  }
+
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < ny; ++j) {
+    const varType *div = fields->div.A.data() + fields->div.layout(0, j);
+    const std::size_t row = static_cast<std::size_t>(nx) * j;
+    for (int i = 0; i < nx; ++i)
+      sys.b[row + i] =
+          sys.free[row + i] ? -coef * static_cast<double>(div[i]) : 0.0;
+  }
+}
+
+void SemiLagrangian::solveRedBlack(LinearSystem *sys, const int count,
+                                   const int maxIters, const double tol) {
+  for (int c = 0; c < count; ++c)
+    sys[c].begin();
+
+  // RMS of r = b - A·x per system.
+  auto residual = [&] {
+    const std::array<double, 4> sums =
+        forEachRow(sys, count, [&](const int c, const int j, double *acc) {
+          LinearSystem &h = sys[c];
+          h.op.applyRow(h.x, h.stride, h.free.data(), j, h.r.data());
+          const std::size_t row = static_cast<std::size_t>(h.op.nx) * j;
+          double rr = 0.0;
+          OMP_PRAGMA(omp simd reduction(+ : rr))
+          for (int i = 0; i < h.op.nx; ++i) {
+            const double r = h.free[row + i] ? h.b[row + i] - h.r[row + i]
+                                             : 0.0;
+            rr += r * r;
+          }
+          acc[0] += rr;
+        });
+    for (int c = 0; c < count; ++c)
+      if (!sys[c].done)
+        sys[c].res = std::sqrt(sums[2 * c] / sys[c].unknowns);
+  };
+  auto allDone = [&] {
+    for (int c = 0; c < count; ++c)
+      if (!sys[c].done)
+        return false;
+    return true;
+  };
+
+  residual();
+  for (int c = 0; c < count; ++c) {
+    LinearSystem &h = sys[c];
+    if (!h.done)
+      h.converged = h.done = checkConvergence(h.res, h.res0, 0, tol);
+  }
+
+  for (int it = 1; it <= maxIters && !allDone(); ++it) {
+    // Two-colour decomposition: "red" cells (i+j even) and "black" cells
+    // (i+j odd). The cells of one colour only read the other one, so the
+    // rows of a colour can be swept in parallel.
+    for (int color = 0; color < 2; ++color) {
+      forEachRow(sys, count, [&](const int c, const int j, double *) {
+        LinearSystem &h = sys[c];
+        const StencilOperator &o = h.op;
+        const int n = o.nx;
+        const std::size_t row = static_cast<std::size_t>(n) * j;
+        // Out-of-domain neighbours read the cell itself with weight 0 (rows)
+        // or are dropped (columns); the diagonal only changes on the edge.
+        const int south = (j > 0) ? h.stride : 0;
+        const int north = (j + 1 < o.ny) ? h.stride : 0;
+        const double ws = south ? o.cy : 0.0, wn = north ? o.cy : 0.0;
+        const double invInner = 1.0 / o.diagonal(std::min(1, n - 1), j);
+        const double invEdge = 1.0 / o.diagonal(0, j);
+        const uint8_t *free = h.free.data() + row;
+        const double *b = h.b.data() + row;
+        varType *x = h.row(j);
+        auto relax = [&](const int i, const double we, const double inv) {
+          x[i] = static_cast<varType>(
+              (b[i] + o.cx * we + ws * x[i - south] + wn * x[i + north]) *
+              inv);
+        };
+        const int first = (j + color) % 2;
+        if (first == 0 && free[0])
+          relax(0, n > 1 ? x[1] : 0.0, invEdge);
+        for (int i = first == 0 ? 2 : 1; i < n - 1; i += 2)
+          if (free[i])
+            relax(i, x[i - 1] + x[i + 1], invInner);
+        const int last = n - 1;
+        if (last > 0 && (last - first) % 2 == 0 && free[last])
+          relax(last, x[last - 1], invEdge);
+      });
+    }
+
+    residual();
+    for (int c = 0; c < count; ++c) {
+      LinearSystem &h = sys[c];
+      if (h.done)
+        continue;
+      h.iterations = it;
+      h.converged = h.done = checkConvergence(h.res, h.res0, it, tol);
+    }
+  }
+}
+
+} // namespace PIC_REAL
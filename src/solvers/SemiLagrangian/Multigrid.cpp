@@ -0,0 +1,336 @@
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Geometric multigrid
+//
+// Every level stores the residual equation A_l·x_l = b_l of the pressure
+// Poisson problem with the same unscaled 5-point operator as the relaxation
+// solvers: for a FLUID cell with N in-domain neighbours,
+//
+//   (A·x)_ij = N·x_ij - Σ_{FLUID nb} x_nb
+//
+// SOLID cells hold x = 0 (homogeneous version of the fixed solid pressure)
+// and domain edges are Neumann, exactly as on the fine grid.
+//
+// The level grids have a zero ghost ring, so Σ over all four neighbours
+// equals Σ over the FLUID ones (missing and SOLID neighbours both read 0)
+// and N is precomputed per cell. The smoother and the residual are then the
+// same branch-free expression at every cell, edges included.
+//
+// Transfers are cell-centred: prolongation is bilinear (weights 3/4, 1/4 per
+// axis), restriction is its exact transpose. The transpose carries a factor
+// 4 relative to averaging, which is the h² → (2h)² rescaling the unscaled
+// operator needs, so coarse levels re-discretise A without extra scaling.
+//
+// Mixed precision stores the whole hierarchy in float, which halves the
+// bytes every sweep streams. The stand-alone solver is then an iterative
+// refinement: the fine residual and the update of p stay in double (the
+// working precision), so the cycles only have to reduce the error of each
+// correction, not represent p itself. The kernels sum neighbours in double
+// whatever the storage.
+
+namespace PIC_REAL {
+
+namespace {
+
+/// Two coarse indices and their weights along one axis.
+struct Weights1D {
+  int c0, c1;
+  double w0, w1;
+};
+
+// Fine cell i lies in coarse cell i/2 (weight 3/4) and next to coarse cell
+// i/2 ± 1 (weight 1/4). At the domain edge the outer neighbour is clamped,
+// which merges both weights onto one coarse cell (Neumann).
+Weights1D prolongWeights(const int i, const int nc) {
+  const int c0 = std::min(i / 2, nc - 1);
+  const int c1 = std::clamp((i % 2 == 0) ? c0 - 1 : c0 + 1, 0, nc - 1);
+  if (c1 == c0)
+    return {c0, c0, 1.0, 0.0};
+  return {c0, c1, 0.75, 0.25};
+}
+
+// Weight with which fine index i contributes to coarse index c.
+double restrictWeight(const int i, const int c, const int nc) {
+  const Weights1D w = prolongWeights(i, nc);
+  return (w.c0 == c ? w.w0 : 0.0) + (w.c1 == c ? w.w1 : 0.0);
+}
+
+} // namespace
+
+// Hierarchy
+
+void SemiLagrangian::prepareMultigrid() {
+  const SolverConfig::Precision precision = params.solver.precision;
+  if (mg.labelsVersion == fields->LabelsVersion() && mg.precision == precision)
+    return;
+
+  if (precision == SolverConfig::Precision::MIXED) {
+    mg.levels.clear();
+    buildMultigridHierarchy(mg.mixedLevels);
+  } else {
+    mg.mixedLevels.clear();
+    buildMultigridHierarchy(mg.levels);
+  }
+  mg.precision = precision;
+  mg.labelsVersion = fields->LabelsVersion();
+}
+
+template <typename Real>
+void SemiLagrangian::buildMultigridHierarchy(
+    std::vector<MultigridLevel<Real>> &levels) {
+  levels.clear();
+
+  levels.emplace_back(nx, ny);
+  for (int j = 0; j < ny; ++j)
+    for (int i = 0; i < nx; ++i)
+      levels[0].labels[nx * j + i] = fields->Label(i, j);
+
+  while (std::min(levels.back().nx, levels.back().ny) >
+         params.solver.mgMinSize) {
+    const MultigridLevel<Real> &fine = levels.back();
+    MultigridLevel<Real> coarse((fine.nx + 1) / 2, (fine.ny + 1) / 2);
+
+    // A coarse cell is SOLID if any of its (up to four) children is SOLID.
+    bool anyFluid = false;
+    for (int J = 0; J < coarse.ny; ++J) {
+      for (int I = 0; I < coarse.nx; ++I) {
+        bool solid = false;
+        for (int j = 2 * J; j < std::min(2 * J + 2, fine.ny); ++j)
+          for (int i = 2 * I; i < std::min(2 * I + 2, fine.nx); ++i)
+            solid |= !fine.Fluid(i, j);
+        coarse.labels[coarse.nx * J + I] =
+            solid ? Fields2D::SOLID : Fields2D::FLUID;
+        anyFluid |= !solid;
+      }
+    }
+    if (!anyFluid)
+      break;
+    levels.push_back(std::move(coarse));
+  }
+
+  for (MultigridLevel<Real> &lvl : levels) {
+    for (int j = 0; j < lvl.ny; ++j) {
+      for (int i = 0; i < lvl.nx; ++i) {
+        const int n = (i + 1 < lvl.nx) + (i - 1 >= 0) + (j + 1 < lvl.ny) +
+                      (j - 1 >= 0);
+        const bool active = lvl.Fluid(i, j) && n > 0;
+        lvl.diag.Set(i, j, active ? static_cast<Real>(n) : Real{0});
+        lvl.invDiag.Set(i, j, active ? Real{1} / static_cast<Real>(n)
+                                     : Real{0});
+      }
+    }
+    lvl.x.FillGhosts(GhostBoundary::ZERO);
+  }
+
+#ifndef NDEBUG
+  std::cout << "  Multigrid: " << levels.size() << " levels, coarsest "
+            << levels.back().nx << " x " << levels.back().ny << ", "
+            << 8 * sizeof(Real) << "-bit\n";
+#endif
+}
+
+// Level kernels
+
+template <typename Real>
+void SemiLagrangian::smoothRedBlack(MultigridLevel<Real> &lvl,
+                                    const int sweeps, const bool reverse) {
+  const int lnx = lvl.nx;
+  const int lny = lvl.ny;
+  const int s = lvl.x.layout.stride();
+
+  for (int sweep = 0; sweep < sweeps; ++sweep) {
+    for (int c = 0; c < 2; ++c) {
+      const int color = reverse ? 1 - c : c;
+      OMP_PRAGMA(omp parallel for schedule(static))
+      for (int j = 0; j < lny; ++j) {
+        const std::size_t row = lvl.x.layout(0, j);
+        Real *x = lvl.x.A.data() + row;
+        const Real *b = lvl.b.A.data() + row;
+        const Real *invDiag = lvl.invDiag.A.data() + row;
+        // SOLID cells have invDiag = 0 and therefore keep x = 0.
+        for (int i = (j + color) % 2; i < lnx; i += 2) {
+          const double sumX = static_cast<double>(x[i + 1]) + x[i - 1] +
+                              x[i + s] + x[i - s];
+          x[i] = static_cast<Real>((b[i] + sumX) * invDiag[i]);
+        }
+      }
+    }
+  }
+}
+
+template <typename Real>
+void SemiLagrangian::levelResidual(MultigridLevel<Real> &lvl) {
+  const int lnx = lvl.nx;
+  const int lny = lvl.ny;
+  const int s = lvl.x.layout.stride();
+
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < lny; ++j) {
+    const std::size_t row = lvl.x.layout(0, j);
+    const Real *x = lvl.x.A.data() + row;
+    const Real *b = lvl.b.A.data() + row;
+    const Real *diag = lvl.diag.A.data() + row;
+    Real *r = lvl.r.A.data() + row;
+    OMP_PRAGMA(omp simd)
+    for (int i = 0; i < lnx; ++i) {
+      const double sumX =
+          static_cast<double>(x[i + 1]) + x[i - 1] + x[i + s] + x[i - s];
+      const double ri = b[i] - (diag[i] * x[i] - sumX);
+      r[i] = (diag[i] > 0) ? static_cast<Real>(ri) : Real{0};
+    }
+  }
+}
+
+template <typename Real>
+void SemiLagrangian::restrictResidual(const MultigridLevel<Real> &fine,
+                                      MultigridLevel<Real> &coarse) {
+  // Gather form of Pᵀ: coarse cell I receives from fine cells 2I-1 … 2I+2,
+  // each weighted by the same factor prolongation would use for it.
+  OMP_PRAGMA(omp parallel for collapse(2) schedule(static))
+  for (int J = 0; J < coarse.ny; ++J) {
+    for (int I = 0; I < coarse.nx; ++I) {
+      coarse.x.Set(I, J, Real{0});
+      if (!coarse.Fluid(I, J)) {
+        coarse.b.Set(I, J, Real{0});
+        continue;
+      }
+      double sum = 0.0;
+      const int jEnd = std::min(2 * J + 2, fine.ny - 1);
+      const int iEnd = std::min(2 * I + 2, fine.nx - 1);
+      for (int j = std::max(2 * J - 1, 0); j <= jEnd; ++j) {
+        const double wy = restrictWeight(j, J, coarse.ny);
+        if (wy == 0.0)
+          continue;
+        for (int i = std::max(2 * I - 1, 0); i <= iEnd; ++i) {
+          const double wx = restrictWeight(i, I, coarse.nx);
+          if (wx != 0.0 && fine.Fluid(i, j))
+            sum += wx * wy * fine.r.Get(i, j);
+        }
+      }
+      coarse.b.Set(I, J, static_cast<Real>(sum));
+    }
+  }
+}
+
+template <typename Real>
+void SemiLagrangian::prolongateCorrection(const MultigridLevel<Real> &coarse,
+                                          MultigridLevel<Real> &fine) {
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < fine.ny; ++j) {
+    const Weights1D wy = prolongWeights(j, coarse.ny);
+    for (int i = 0; i < fine.nx; ++i) {
+      if (!fine.Fluid(i, j))
+        continue;
+      const Weights1D wx = prolongWeights(i, coarse.nx);
+      const double e0 = wx.w0 * coarse.x.Get(wx.c0, wy.c0) +
+                        wx.w1 * coarse.x.Get(wx.c1, wy.c0);
+      const double e1 = wx.w0 * coarse.x.Get(wx.c0, wy.c1) +
+                        wx.w1 * coarse.x.Get(wx.c1, wy.c1);
+      fine.x.Set(i, j, fine.x.Get(i, j) +
+                           static_cast<Real>(wy.w0 * e0 + wy.w1 * e1));
+    }
+  }
+}
+
+// Cycle
+
+template <typename Real>
+void SemiLagrangian::multigridCycle(std::vector<MultigridLevel<Real>> &levels,
+                                    const std::size_t level) {
+  MultigridLevel<Real> &lvl = levels[level];
+
+  if (level + 1 == levels.size()) {
+    // Coarsest level: plain symmetric relaxation is cheap enough here.
+    const int half = std::max(1, params.solver.mgCoarseSweeps / 2);
+    smoothRedBlack(lvl, half, false);
+    smoothRedBlack(lvl, half, true);
+    return;
+  }
+
+  smoothRedBlack(lvl, params.solver.mgPreSmooth, false);
+  levelResidual(lvl);
+  restrictResidual(lvl, levels[level + 1]);
+
+  const int visits = (params.solver.mgCycle == SolverConfig::Cycle::W) ? 2 : 1;
+  for (int v = 0; v < visits; ++v)
+    multigridCycle(levels, level + 1);
+
+  prolongateCorrection(levels[level + 1], lvl);
+  smoothRedBlack(lvl, params.solver.mgPostSmooth, true);
+}
+
+template <typename Real>
+void SemiLagrangian::applyMultigrid(std::vector<MultigridLevel<Real>> &levels,
+                                    const std::vector<double> &r,
+                                    std::vector<double> &z) {
+  MultigridLevel<Real> &fine = levels[0];
+
+  // Only interior rows are copied; the halo of x stays zero.
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < ny; ++j) {
+    const std::size_t row = fine.x.layout(0, j);
+    const double *src = r.data() + static_cast<std::size_t>(nx) * j;
+    std::transform(src, src + nx, fine.b.A.data() + row,
+                   [](double v) { return static_cast<Real>(v); });
+    std::fill_n(fine.x.A.data() + row, nx, Real{0});
+  }
+
+  multigridCycle(levels, 0);
+
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < ny; ++j) {
+    const Real *x = fine.x.A.data() + fine.x.layout(0, j);
+    std::copy(x, x + nx, z.data() + static_cast<std::size_t>(nx) * j);
+  }
+}
+
+void SemiLagrangian::applyMultigrid(const std::vector<double> &r,
+                                    std::vector<double> &z) {
+  if (mg.precision == SolverConfig::Precision::MIXED)
+    applyMultigrid(mg.mixedLevels, r, z);
+  else
+    applyMultigrid(mg.levels, r, z);
+}
+
+// Stand-alone solver
+
+void SemiLagrangian::SolveMultigrid(int maxIters, double tol) {
+  const varType coef = density * dx * dx / dt;
+  computeDivergence();
+
+  prepareMultigrid();
+
+  const std::size_t n = static_cast<std::size_t>(nx) * ny;
+  if (mg.r.size() != n) {
+    mg.r.assign(n, 0.0);
+    mg.z.assign(n, 0.0);
+  }
+
+  double res0 = 1.0;
+  double res = computeResidual(coef, mg.r);
+  if (checkConvergence(res, res0, 0, tol)) {
+    finishSolve("Multigrid", 0, res, res0, true);
+    return;
+  }
+
+  for (int it = 1; it <= maxIters; ++it) {
+    // One cycle on A·e = r, then p ← p + e. The correction is zero on SOLID
+    // cells, so their fixed pressure is untouched.
+    applyMultigrid(mg.r, mg.z);
+
+    addCorrection(mg.z);
+
+    res = computeResidual(coef, mg.r);
+    if (checkConvergence(res, res0, it, tol)) {
+      finishSolve("Multigrid", it, res, res0, true);
+      return;
+    }
+  }
+
+  finishSolve("Multigrid", maxIters, res, res0, false);
+}
+
+} // namespace PIC_REAL
@@ -3,8 +3,11 @@
 
 // Pressure solve dispatch
 
-void SemiLagrangian::solvePressure(int maxIters, double tol) {
-  switch (params.solver.type) {
+namespace PIC_REAL {
+
+void SemiLagrangian::solvePressure(const SolverConfig::Type type,
+                                   int maxIters, double tol) {
+  switch (type) {
   case SolverConfig::Type::JACOBI:
     SolveJacobi(maxIters, tol);
     break;
@@ -14,12 +17,26 @@ void SemiLagrangian::solvePressure(int maxIters, double tol) {
   case SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL:
     SolveRedBlackGaussSeidel(maxIters, tol);
     break;
+  case SolverConfig::Type::PCG:
+    SolvePCG(maxIters, tol);
+    break;
+  case SolverConfig::Type::MULTIGRID:
+    SolveMultigrid(maxIters, tol);
+    break;
+  case SolverConfig::Type::SPECTRAL:
+    SolveSpectral(maxIters, tol);
+    break;
   default:
     std::cerr << "[SemiLagrangian] Unknown pressure solver type – aborting.\n";
     std::exit(EXIT_FAILURE);
   }
 }
 
+void SemiLagrangian::computeDivergence() {
+  Profiler::Scope scope(profiler, DIVERGENCE);
+  fields->Div();
+}
+
 // Velocity correction
 
 void SemiLagrangian::updateVelocities() {
@@ -31,37 +48,63 @@ void SemiLagrangian::updateVelocities() {
   // is left unchanged — it represents the domain boundary.
 
   const varType coef = dt / (density * dx);
+  const varType wall = fields->usolid;
+  const uint8_t *labels = fields->Labels().data();
+  auto solid = [](const uint8_t label) { return label == Fields2D::SOLID; };
 
-OMP_PRAGMA( omp parallel for collapse(2) schedule(static))
-for (int j = 0; j < fields->u.ny; ++j) {
-  for (int i = 1; i < fields->u.nx - 1; ++i) {
-    if ((fields->Label(i - 1, j) == Fields2D::SOLID) ||
-        (fields->Label(i, j) == Fields2D::SOLID)) {
-      fields->u.Set(i, j, fields->usolid);
-      continue;
+  // One row at a time with a select instead of a branch, so the face loops
+  // vectorise; p rows come from its padded layout.
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < fields->u.ny; ++j) {
+    varType *u = fields->u.A.data() + fields->u.layout(0, j);
+    const varType *p = fields->p.A.data() + fields->p.layout(0, j);
+    const uint8_t *label = labels + static_cast<std::size_t>(nx) * j;
+    OMP_PRAGMA(omp simd)
+    for (int i = 1; i < fields->u.nx - 1; ++i) {
+      const varType corrected = u[i] - coef * (p[i] - p[i - 1]);
+      u[i] = (solid(label[i - 1]) | solid(label[i])) ? wall : corrected;
     }
-    fields->u.Set(i, j,
-                  fields->u.Get(i, j) -
-                      coef * (fields->p.Get(i, j) - fields->p.Get(i - 1, j)));
   }
-}
 
-OMP_PRAGMA( omp parallel for collapse(2) schedule(static))
-for (int j = 1; j < fields->v.ny - 1; ++j) {
-  for (int i = 0; i < fields->v.nx; ++i) {
-    if ((fields->Label(i, j - 1) == Fields2D::SOLID) ||
-        (fields->Label(i, j) == Fields2D::SOLID)) {
-      fields->v.Set(i, j, fields->usolid);
-      continue;
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 1; j < fields->v.ny - 1; ++j) {
+    varType *v = fields->v.A.data() + fields->v.layout(0, j);
+    const varType *p = fields->p.A.data() + fields->p.layout(0, j);
+    const varType *pS = fields->p.A.data() + fields->p.layout(0, j - 1);
+    const uint8_t *label = labels + static_cast<std::size_t>(nx) * j;
+    const uint8_t *labelS = label - nx;
+    OMP_PRAGMA(omp simd)
+    for (int i = 0; i < fields->v.nx; ++i) {
+      const varType corrected = v[i] - coef * (p[i] - pS[i]);
+      v[i] = (solid(labelS[i]) | solid(label[i])) ? wall : corrected;
     }
-    fields->v.Set(i, j,
-                  fields->v.Get(i, j) -
-                      coef * (fields->p.Get(i, j) - fields->p.Get(i, j - 1)));
   }
 }
-}
 
 void SemiLagrangian::MakeIncompressible() {
-  solvePressure(params.solver.maxIters, params.solver.tolerance);
+  // The previous step's pressure is the natural initial guess: on
+  // quasi-steady flows it is already close to the solution. A cold start
+  // resets the FLUID cells to zero (SOLID pressures are boundary values).
+  solveStats = PressureSolveStats{};
+  solveStats.warmStarted = params.solver.warmStart;
+  {
+    Profiler::Scope scope(profiler, PRESSURE);
+    if (!params.solver.warmStart) {
+      OMP_PRAGMA(omp parallel for collapse(2) schedule(static))
+      for (int j = 0; j < ny; ++j)
+        for (int i = 0; i < nx; ++i)
+          if (fields->Label(i, j) == Fields2D::FLUID)
+            fields->p.Set(i, j, REAL_LITERAL(0.0));
+    }
+
+    solvePressure(params.solver.type, params.solver.maxIters,
+                  params.solver.tolerance);
+  }
+  profiler.count(PRESSURE_ITERATIONS, solveStats.iterations);
+  profiler.count(PRESSURE_RESIDUAL, solveStats.relResidual);
+
+  Profiler::Scope scope(profiler, VELOCITY_UPDATE);
   updateVelocities();
 }
+
+} // namespace PIC_REAL
@@ -0,0 +1,185 @@
+#include "../../core/Checkpoint.hpp"
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <deque>
+#include <iostream>
+#include <utility>
+#include <vector>
+
+// Checkpoint / restart
+//
+// A checkpoint holds the state that carries over from one step to the next:
+// the velocity faces, the pressure (warm start of the next solve), the
+// smoke, the cell labels and, for particle schemes, the particle store and
+// its sort counter. div and normVelocity are recomputed from u and v.
+// The output writers add their frame counter and PVD entries, so a resumed
+// run continues the same .vti series and writes one complete .pvd.
+//
+// Sections are named after the field ("u", "p", "labels", ...); each writer
+// stores "writer.<name>" as an int32 frame count followed by its PVD lines.
+// Every grid is stored row-major without ghosts, whatever its layout in
+// memory, so checkpoints do not depend on the padding of p or the tiling
+// of the smoke.
+
+namespace PIC_REAL {
+
+namespace {
+
+/// Particle arrays stored in a checkpoint, by section name.
+template <typename Store> auto particleArrays(Store &p) {
+  using Array = decltype(&p.x);
+  return std::array<std::pair<const char *, Array>, 8>{
+      {{"particles.x", &p.x},
+       {"particles.y", &p.y},
+       {"particles.u", &p.u},
+       {"particles.v", &p.v},
+       {"particles.cux", &p.cux},
+       {"particles.cuy", &p.cuy},
+       {"particles.cvx", &p.cvx},
+       {"particles.cvy", &p.cvy}}};
+}
+
+} // namespace
+
+bool SemiLagrangian::WriteCheckpoint(const std::string &path,
+                                     const int step) const {
+  CheckpointHeader header;
+  header.realBytes = sizeof(varType);
+  header.nx = nx;
+  header.ny = ny;
+  header.step = step;
+  header.time = time;
+  header.paramHash = params.configHash;
+
+  // Sections only point at their data: these have to outlive write().
+  std::deque<std::string> writerStates;
+  int32_t particleSteps = 0;
+  std::vector<varType> p(static_cast<std::size_t>(nx) * ny);
+  fields->p.CopyToRowMajor(p.data());
+  std::vector<varType> smoke(static_cast<std::size_t>(fields->smokeMap.nx) *
+                             fields->smokeMap.ny);
+  fields->smokeMap.CopyToRowMajor(smoke.data());
+
+  CheckpointWriter out(header);
+  out.add("u", fields->u.A);
+  out.add("v", fields->v.A);
+  out.add("p", p);
+  out.add("smoke", smoke);
+  out.add("labels", fields->Labels());
+
+  if (particles) {
+    for (const auto &[name, array] :
+         particleArrays(particles->GetParticles()))
+      out.add(name, *array);
+    particleSteps = particles->StepCount();
+    out.add("particles.steps", &particleSteps, sizeof(particleSteps));
+  }
+
+  for (const OutputWriter *w : outputWriters()) {
+    const int32_t frames = w->frameCount();
+    std::string &state = writerStates.emplace_back(sizeof(frames), '\0');
+    std::memcpy(state.data(), &frames, sizeof(frames));
+    for (const std::string &entry : w->pvdEntries())
+      state += entry;
+    out.add("writer." + w->name(), state.data(), state.size());
+  }
+
+  return out.write(path);
+}
+
+bool SemiLagrangian::Restore(const std::string &path) {
+  CheckpointReader in;
+  if (!in.open(path))
+    return false;
+
+  const CheckpointHeader &header = in.header();
+  if (header.realBytes != sizeof(varType) || header.nx != nx ||
+      header.ny != ny) {
+    std::cerr << "[SemiLagrangian] Checkpoint '" << path << "' holds a "
+              << header.nx << " x " << header.ny << " grid in "
+              << 8 * header.realBytes << "-bit precision, this run is " << nx
+              << " x " << ny << " in " << PRECISION_STRING
+              << " (see the config's \"precision\")\n";
+    return false;
+  }
+  if (header.paramHash != params.configHash)
+    std::cerr << "[SemiLagrangian] Warning: checkpoint '" << path
+              << "' was written with a different configuration\n";
+
+  const std::size_t cells = static_cast<std::size_t>(nx) * ny;
+  const auto labels = in.section("labels");
+  if (labels.second != cells) {
+    std::cerr << "[SemiLagrangian] Checkpoint '" << path
+              << "' has no valid cell labels\n";
+    return false;
+  }
+  fields->AssignLabels(static_cast<const uint8_t *>(labels.first));
+
+  std::vector<varType> p(cells);
+  std::vector<varType> smoke(static_cast<std::size_t>(fields->smokeMap.nx) *
+                             fields->smokeMap.ny);
+  bool ok = in.read("u", fields->u.A.data(), fields->u.A.size()) &&
+            in.read("v", fields->v.A.data(), fields->v.A.size()) &&
+            in.read("p", p.data(), p.size()) &&
+            in.read("smoke", smoke.data(), smoke.size());
+  if (!ok)
+    return false;
+  fields->p.CopyFromRowMajor(p.data());
+  fields->smokeMap.CopyFromRowMajor(smoke.data());
+  fields->smokeTiles.Invalidate(); // sparse smoke: rescan the new smoke
+
+  if (params.transport.usesParticles()) {
+    // Seeded from the restored grid first; replaced below unless the
+    // checkpoint comes from a run without particles.
+    particles = std::make_unique<ParticleTransport>(params.transport, *fields);
+
+    const std::size_t n =
+        in.section("particles.x").second / sizeof(varType);
+    int32_t steps = 0;
+    if (n > 0 && in.read("particles.steps", &steps, 1)) {
+      const bool affine =
+          params.transport.scheme == TransportConfig::Scheme::APIC;
+      Particles restored;
+      restored.resize(n, affine);
+      for (const auto &[name, array] : particleArrays(restored))
+        if (!array->empty())
+          ok &= in.read(name, array->data(), array->size());
+      if (!ok)
+        return false;
+      particles->RestoreState(std::move(restored), steps);
+    } else {
+      std::cerr << "[SemiLagrangian] Warning: checkpoint '" << path
+                << "' has no particles, reseeding\n";
+    }
+  }
+
+  for (OutputWriter *w : outputWriters()) {
+    const auto [data, bytes] = in.section("writer." + w->name());
+    int32_t frames = 0;
+    if (bytes < sizeof(frames))
+      continue; // not written by the checkpointed run: start a new series
+    std::memcpy(&frames, data, sizeof(frames));
+
+    // One PVD entry per line.
+    const char *text = static_cast<const char *>(data) + sizeof(frames);
+    const char *end = static_cast<const char *>(data) + bytes;
+    std::vector<std::string> entries;
+    while (text < end) {
+      const char *eol = std::find(text, end, '\n');
+      const char *next = (eol == end) ? end : eol + 1;
+      entries.emplace_back(text, next);
+      text = next;
+    }
+    w->restoreState(frames, std::move(entries));
+  }
+
+  startStep = static_cast<int>(header.step);
+  time = header.time;
+  std::cout << "Restarted from '" << path << "' after step " << startStep
+            << " (t = " << header.time << ")\n";
+  return true;
+}
+
+} // namespace PIC_REAL
@@ -1,13 +1,122 @@
 #include "SemiLagrangian.hpp"
 #include <algorithm>
+#include <cmath>
 #include <iostream>
+#include <limits>
+#include <utility>
 
-SemiLagrangian::SemiLagrangian(const Parameters &params)
-    : params(params), nx(params.nx), ny(params.ny),
+namespace PIC_REAL {
+
+namespace {
+
+// Cell-centred copies for the combined snapshot: rows [j0, j1) of the
+// nx × ny cells, row-major from dst.
+
+// u(i, j) and u(i+1, j) are the x-faces of cell (i, j).
+void averageFacesX(const Grid2D &u, const int j0, const int j1,
+                   varType *dst) {
+  const int cnx = u.nx - 1;
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = j0; j < j1; ++j)
+    for (int i = 0; i < cnx; ++i)
+      dst[static_cast<std::size_t>(cnx) * (j - j0) + i] =
+          REAL_LITERAL(0.5) * (u.Get(i, j) + u.Get(i + 1, j));
+}
+
+// v(i, j) and v(i, j+1) are the y-faces of cell (i, j).
+void averageFacesY(const Grid2D &v, const int j0, const int j1,
+                   varType *dst) {
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = j0; j < j1; ++j)
+    for (int i = 0; i < v.nx; ++i)
+      dst[static_cast<std::size_t>(v.nx) * (j - j0) + i] =
+          REAL_LITERAL(0.5) * (v.Get(i, j) + v.Get(i, j + 1));
+}
+
+// |u| at the centre of every cell, from the face averages above. Unlike
+// Fields2D::normVelocity (the same samples, one cell short in x and y), it
+// covers the last column and row too.
+void velocityNormCells(const Grid2D &u, const Grid2D &v, const int j0,
+                       const int j1, varType *dst) {
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = j0; j < j1; ++j)
+    for (int i = 0; i < v.nx; ++i) {
+      const varType uc = REAL_LITERAL(0.5) * (u.Get(i, j) + u.Get(i + 1, j));
+      const varType vc = REAL_LITERAL(0.5) * (v.Get(i, j) + v.Get(i, j + 1));
+      dst[static_cast<std::size_t>(v.nx) * (j - j0) + i] =
+          std::sqrt(uc * uc + vc * vc);
+    }
+}
+
+// The smoke is sampled at the centres of cells [0, nx-1) × [0, ny-1): its
+// (i, j) is cell (i, j) of p, and the last column and row, which it does
+// not cover, repeat their neighbour.
+void padToCells(const SmokeGrid2D &g, const int nx, const int j0,
+                const int j1, varType *dst) {
+  if (g.nx <= 0 || g.ny <= 0) { // single-cell-wide domain
+    std::fill_n(dst, static_cast<std::size_t>(nx) * (j1 - j0), varType{0});
+    return;
+  }
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = j0; j < j1; ++j)
+    for (int i = 0; i < nx; ++i)
+      dst[static_cast<std::size_t>(nx) * (j - j0) + i] =
+          g.Get(std::min(i, g.nx - 1), std::min(j, g.ny - 1));
+}
+
+// Rows [j0, j1) of a grid of any layout, row-major from dst.
+template <typename Layout>
+void copyRows(const BasicGrid2D<Layout> &g, const int j0, const int j1,
+              varType *dst) {
+  for (int j = j0; j < j1; ++j)
+    g.GetRow(j, 0, g.nx, dst + static_cast<std::size_t>(g.nx) * (j - j0));
+}
+
+/// First domain row owned by each of @p ranks ranks: split like a static
+/// schedule, the first ny % ranks get one row more.
+std::vector<int> splitRows(const int ny, const int ranks) {
+  std::vector<int> starts(ranks);
+  const int q = ny / ranks, extra = ny % ranks;
+  for (int r = 0; r < ranks; ++r)
+    starts[r] = r * q + std::min(r, extra);
+  return starts;
+}
+
+/// Pressure rows held by @p comm's rank: its own and up to @c halo rows of
+/// each neighbour.
+int slabRows(const Parameters &params, const Communicator &comm) {
+  const std::vector<int> starts = splitRows(params.ny, comm.size());
+  const int r = comm.rank();
+  const int j1 = (r + 1 < comm.size()) ? starts[r + 1] : params.ny;
+  const int halo = params.distributed.halo;
+  return std::min(params.ny, j1 + halo) - std::max(0, starts[r] - halo);
+}
+
+/// Profiler column names, in SemiLagrangian::Phase order.
+std::vector<std::string> phaseNames() {
+  return {"sources", "p2g", "viscosity", "div", "pressure",
+          "velocity_update", "advect", "advect_smoke", "diagnostics",
+          "write_fields", "write_u", "write_v", "write_p", "write_div",
+          "write_norm_velocity", "write_smoke", "checkpoint"};
+}
+
+} // namespace
+
+SemiLagrangian::SemiLagrangian(const Parameters &params, Communicator *comm)
+    : params(params), nx(params.nx),
+      ny(comm ? slabRows(params, *comm) : params.ny),
       dx(static_cast<varType>(params.dx)), dy(static_cast<varType>(params.dy)),
       dt(static_cast<varType>(params.dt)),
+      invDx(REAL_LITERAL(1.0) / dx), invDy(REAL_LITERAL(1.0) / dy),
       density(static_cast<varType>(params.density)),
-      fields(new Fields2D(nx, ny, density, dt, dx, dy)) {
+      fields(new Fields2D(nx, ny, density, dt, dx, dy)),
+      profiler(phaseNames(),
+               {"pressure_iterations", "pressure_rel_residual", "dt",
+                "viscosity_iterations", "smoke_active_tiles"},
+               static_cast<std::size_t>(params.profile.history)),
+      advectRowLen(nx + 1),
+      advectScratch(static_cast<std::size_t>(8) * advectRowLen *
+                    MAX_THREADS()) {
 
 #ifndef NDEBUG
   std::cout << "Grid dimensions:\n"
@@ -19,9 +128,57 @@ SemiLagrangian::SemiLagrangian(const Parameters &params)
             << '\n';
 #endif
 
+  // A rank of a distributed run holds its owned rows and the halo rows of
+  // its neighbours; the scene objects find their rows through rowOffset.
+  DistributedWorkspace &ws = distributed;
+  if (comm) {
+    const int rank = comm->rank();
+    ws.comm = comm;
+    ws.globalNy = params.ny;
+    ws.rowStarts = splitRows(params.ny, comm->size());
+    const int j0 = ws.rowStarts[rank];
+    const int j1 =
+        (rank + 1 < comm->size()) ? ws.rowStarts[rank + 1] : params.ny;
+    ws.row0 = std::max(0, j0 - params.distributed.halo);
+    ws.own0 = j0 - ws.row0;
+    ws.own1 = j1 - ws.row0;
+    fields->rowOffset = ws.row0;
+  } else {
+    ws.globalNy = ny;
+    ws.own1 = ny;
+  }
+
   // Apply initial conditions from the JSON config (velocity patches, solid
   // geometry). SceneObject instances are created and destroyed inside here.
-  params.applyToFields(*fields);
+  // A restart takes all of it from the checkpoint instead (Restore()).
+  if (params.restartFile.empty()) {
+    params.applyToFields(*fields);
+
+    // Particles are seeded from the initial grid velocity.
+    if (params.transport.usesParticles())
+      particles =
+          std::make_unique<ParticleTransport>(params.transport, *fields);
+  }
+
+  // Sparse smoke: the first step scans the smoke for its occupied tiles.
+  if (params.sparseSmoke.enabled)
+    fields->smokeTiles =
+        ActiveTiles(fields->smokeMap.nx, fields->smokeMap.ny,
+                    params.sparseSmoke.tile);
+
+  // Intermediate fields of the error-corrected advection, kept between
+  // steps (the velocity ones only without particles).
+  if (params.transport.advection !=
+      TransportConfig::Advection::SEMI_LAGRANGIAN) {
+    if (!params.transport.usesParticles()) {
+      uCorrection =
+          std::make_unique<CorrectionScratch<>>(fields->u.nx, fields->u.ny);
+      vCorrection =
+          std::make_unique<CorrectionScratch<>>(fields->v.nx, fields->v.ny);
+    }
+    smokeCorrection = std::make_unique<CorrectionScratch<SmokeLayout>>(
+        fields->smokeMap.nx, fields->smokeMap.ny);
+  }
 
   InitializeOutputWriters();
 
@@ -34,82 +191,381 @@ SemiLagrangian::SemiLagrangian(const Parameters &params)
 SemiLagrangian::~SemiLagrangian() { delete fields; }
 
 void SemiLagrangian::InitializeOutputWriters() {
+  // One snapshot per written field and queued frame (a single one holding
+  // every field when combined).
+  const int fieldsPerFrame = params.write_u + params.write_v + params.write_p +
+                             params.write_div + params.write_norm_velocity +
+                             params.write_smoke;
+  const int snapshotsPerFrame = params.output.combined ? 1 : fieldsPerFrame;
+  if (params.output.async && fieldsPerFrame > 0)
+    outputQueue = std::make_unique<AsyncOutput>(
+        params.output.ioThreads, params.output.queueDepth * snapshotsPerFrame);
+  AsyncOutput *async = outputQueue.get();
+
+  OutputCompression zip;
+  zip.level = params.output.compressionLevel;
+  zip.blockBytes = static_cast<std::size_t>(params.output.blockSizeKiB) << 10;
+
+  // A rank of a distributed run writes its rows as a piece of each frame.
+  auto make = [&](const char *name) {
+    auto writer =
+        std::make_unique<OutputWriter>(params.folder, name, async, zip);
+    if (distributed.comm)
+      writer->setPiece(distributed.comm->rank(), distributed.rowStarts);
+    return writer;
+  };
+  if (params.output.combined) {
+    if (fieldsPerFrame > 0)
+      frameWriter = make("fields");
+    return;
+  }
   if (params.write_u)
-    uWriter = std::make_unique<OutputWriter>(params.folder, "u");
+    uWriter = make("u");
   if (params.write_v)
-    vWriter = std::make_unique<OutputWriter>(params.folder, "v");
+    vWriter = make("v");
   if (params.write_p)
-    pWriter = std::make_unique<OutputWriter>(params.folder, "p");
+    pWriter = make("p");
   if (params.write_div)
-    divWriter = std::make_unique<OutputWriter>(params.folder, "div");
+    divWriter = make("div");
   if (params.write_norm_velocity)
-    normVelocityWriter =
-        std::make_unique<OutputWriter>(params.folder, "normVelocity");
+    normVelocityWriter = make("normVelocity");
   if (params.write_smoke)
-    smokeWriter = std::make_unique<OutputWriter>(params.folder, "smoke");
+    smokeWriter = make("smoke");
 }
 
-void SemiLagrangian::WriteOutput(int step) const {
-  if (step % params.sampling_rate != 0)
-    return;
+std::vector<OutputWriter *> SemiLagrangian::outputWriters() const {
+  std::vector<OutputWriter *> writers;
+  for (const std::unique_ptr<OutputWriter> *w :
+       {&frameWriter, &uWriter, &vWriter, &pWriter, &divWriter,
+        &normVelocityWriter, &smokeWriter})
+    if (*w)
+      writers.push_back(w->get());
+  return writers;
+}
 
+void SemiLagrangian::WriteOutput(int step) const {
+  // Each writer is timed as a phase of its own.
+  auto write = [this](const Phase phase, auto &&writeFn) {
+    Profiler::Scope scope(profiler, phase);
+    return writeFn();
+  };
   bool ok = true;
+  if (frameWriter)
+    ok = write(WRITE_FIELDS, [&] { return writeCombinedFrame(); });
   if (params.write_u && uWriter)
-    ok &= uWriter->writeGrid2D(fields->u, "u");
+    ok &= write(WRITE_U, [&] { return writeField(*uWriter, fields->u, "u"); });
   if (params.write_v && vWriter)
-    ok &= vWriter->writeGrid2D(fields->v, "v");
+    ok &= write(WRITE_V, [&] { return writeField(*vWriter, fields->v, "v"); });
   if (params.write_p && pWriter)
-    ok &= pWriter->writeGrid2D(fields->p, "p");
+    ok &= write(WRITE_P, [&] { return writeField(*pWriter, fields->p, "p"); });
   if (params.write_div && divWriter)
-    ok &= divWriter->writeGrid2D(fields->div, "div");
+    ok &= write(WRITE_DIV,
+                [&] { return writeField(*divWriter, fields->div, "div"); });
   if (params.write_norm_velocity && normVelocityWriter)
-    ok &= normVelocityWriter->writeGrid2D(fields->normVelocity, "normVelocity");
+    ok &= write(WRITE_NORM_VELOCITY, [&] {
+      return writeField(*normVelocityWriter, fields->normVelocity,
+                        "normVelocity");
+    });
   if (params.write_smoke && smokeWriter)
-    ok &= smokeWriter->writeGrid2D(fields->smokeMap, "smoke");
+    ok &= write(WRITE_SMOKE, [&] {
+      return writeField(*smokeWriter, fields->smokeMap, "smoke");
+    });
   if (!ok)
     std::cerr << "[SemiLagrangian] Warning: failed to write output at step "
               << step << '\n';
 }
 
+bool SemiLagrangian::writeCombinedFrame() const {
+  std::vector<std::string> names;
+  if (params.write_u)
+    names.emplace_back("u");
+  if (params.write_v)
+    names.emplace_back("v");
+  if (params.write_p)
+    names.emplace_back("p");
+  if (params.write_div)
+    names.emplace_back("div");
+  if (params.write_norm_velocity)
+    names.emplace_back("normVelocity");
+  if (params.write_smoke)
+    names.emplace_back("smoke");
+
+  // The owned rows only in a distributed run (all of them otherwise).
+  const auto [j0, j1] = ownedRows(fields->p);
+  varType *dst =
+      frameWriter->beginFrame(nx, j1 - j0, std::move(names),
+                              distributed.globalNy);
+  if (!dst)
+    return false;
+
+  // Same order as the names above, one nx × (j1 - j0) array after the
+  // other.
+  const std::size_t cells = static_cast<std::size_t>(nx) * (j1 - j0);
+  auto next = [&dst, cells] { return std::exchange(dst, dst + cells); };
+  if (params.write_u)
+    averageFacesX(fields->u, j0, j1, next());
+  if (params.write_v)
+    averageFacesY(fields->v, j0, j1, next());
+  if (params.write_p)
+    copyRows(fields->p, j0, j1, next());
+  if (params.write_div)
+    copyRows(fields->div, j0, j1, next());
+  if (params.write_norm_velocity)
+    velocityNormCells(fields->u, fields->v, j0, j1, next());
+  if (params.write_smoke)
+    padToCells(fields->smokeMap, nx, j0, j1, next());
+
+  return frameWriter->endFrame(time);
+}
+
+template <typename Layout>
+bool SemiLagrangian::writeField(OutputWriter &writer,
+                                const BasicGrid2D<Layout> &grid,
+                                const std::string &id) const {
+  if (!distributed.comm)
+    return writer.writeGrid2D(grid, id, time);
+
+  // The domain has as many rows more or fewer than p as the local grid.
+  const auto [j0, j1] = ownedRows(grid);
+  varType *dst = writer.beginFrame(grid.nx, j1 - j0, {id},
+                                   distributed.globalNy + grid.ny - ny);
+  if (!dst)
+    return false;
+  copyRows(grid, j0, j1, dst);
+  return writer.endFrame(time);
+}
+
 void SemiLagrangian::Step() {
+  // Particle schemes rebuild the grid velocity first, so that sources act
+  // on it and show up in the FLIP increment.
+  if (particles) {
+    Profiler::Scope scope(profiler, P2G);
+    particles->ParticlesToGrid();
+  }
 
   if (params.source == true) {
+    Profiler::Scope scope(profiler, SOURCES);
     params.applyToFields(*fields); // TODO: améliorer, fait vite fait pour
                                    // avoir une source
   }
 
-  MakeIncompressible(); // 1. Pressure projection: enforce div u = 0.
-  Advect();             // 2. Semi-Lagrangian transport of velocity.
-  AdvectSmoke();
+  if (distributed.comm) {
+    StepDistributed(); // 1.-2. and the diagnostics on this rank's slab.
+    return;
+  }
+
+  if (params.viscosity.nu > 0.0) {
+    Profiler::Scope scope(profiler, VISCOSITY);
+    Diffuse(); // 0. Implicit viscous diffusion of the transported velocity.
+  }
+
+  // 2. Transport of the smoke and the velocity, both through the projected
+  //    velocity: in one fused pass when both are semi-Lagrangian, else the
+  //    smoke first.
+  const bool fused = !particles && !uCorrection;
+
+  // 1. (and 2. with the diagnostics when fused) in one parallel region
+  //    over per-thread slabs, unless the runtime grants too few threads.
+  if (params.decomposition.enabled && StepDecomposed(fused)) {
+    if (fused)
+      return;
+  } else {
+    MakeIncompressible(); // 1. Pressure projection: enforce div u = 0.
+  }
+
+  if (fields->smokeTiles.enabled()) {
+    Profiler::Scope scope(profiler, ADVECT_SMOKE);
+    updateSmokeTiles(velocityRate());
+  }
+
+  if (fused) {
+    Profiler::Scope scope(profiler, ADVECT);
+    AdvectFused();
+  } else {
+    {
+      Profiler::Scope scope(profiler, ADVECT_SMOKE);
+      AdvectSmoke();
+    }
+    Profiler::Scope scope(profiler, ADVECT);
+    if (particles) {
+      particles->GridToParticles();
+      particles->AdvectParticles();
+    } else {
+      Advect();
+    }
+  }
+  Profiler::Scope scope(profiler, DIAGNOSTICS);
   fields->Div();                    // } Update diagnostics used for
   fields->VelocityNormCenterGrid(); // } output and progress reporting.
 }
 
+double SemiLagrangian::velocityRate() const {
+  const varType *u = fields->u.A.data();
+  const varType *v = fields->v.A.data();
+  const int nu = static_cast<int>(fields->u.A.size());
+  const int nv = static_cast<int>(fields->v.A.size());
+
+  varType uMax = REAL_LITERAL(0.0);
+  varType vMax = REAL_LITERAL(0.0);
+  OMP_PRAGMA(omp parallel)
+  {
+    OMP_PRAGMA(omp for schedule(static) reduction(max : uMax) nowait)
+    for (int k = 0; k < nu; ++k)
+      uMax = std::max(uMax, std::abs(u[k]));
+    OMP_PRAGMA(omp for schedule(static) reduction(max : vMax))
+    for (int k = 0; k < nv; ++k)
+      vMax = std::max(vMax, std::abs(v[k]));
+  }
+
+  return std::max(static_cast<double>(uMax) / params.dx,
+                  static_cast<double>(vMax) / params.dy);
+}
+
+double SemiLagrangian::cflTimeStep() const {
+  const TimeStepConfig &ts = params.timeStep;
+  double rate = velocityRate();
+  if (distributed.comm) // every rank takes the same dt
+    rate = distributed.comm->allReduceMax(rate);
+  const double cflDt = (rate > 0.0) ? ts.cfl / rate : ts.dtMax;
+  return std::clamp(cflDt, ts.dtMin, ts.dtMax);
+}
+
+void SemiLagrangian::setTimeStep(const double newDt) {
+  dt = static_cast<varType>(newDt);
+  fields->dt = dt;
+}
+
 void SemiLagrangian::Run() {
-  // Compute initial diagnostics and write the t=0 snapshot.
+  const TimeStepConfig &ts = params.timeStep;
+  const double interval = ts.outputInterval;
+  const bool untilTime = ts.endTime > 0.0;
+
+  // Times are compared with a relative tolerance, so that a sum of steps
+  // landing on an output or end time counts as reaching it.
+  auto reached = [](const double t, const double target) {
+    return t >= target * (1.0 - 1e-9);
+  };
+  // Time-based output: index of the next output time, nextFrame·interval
+  // (a product rather than a running sum, so that a restarted run lands
+  // on bit-identical output times).
+  double nextFrame = 0.0;
+  if (interval > 0.0)
+    nextFrame = std::floor(time / interval + 1e-9) + 1.0;
+
+  // Compute initial diagnostics and write the t=0 snapshot (a restarted run
+  // wrote the snapshot of its first step before the checkpoint).
   fields->Div();
   fields->VelocityNormCenterGrid();
-  WriteOutput(0);
+  if (startStep == 0)
+    WriteOutput(0);
 
   const double start = GET_TIME();
-  const int reportEvery = std::max(1, params.nt / 10);
+  const int checkpointEvery = params.checkpoint.interval;
+  int reported = 0; // progress deciles printed so far
+
+  for (int t = startStep + 1;
+       untilTime ? !reached(time, ts.endTime) : t <= params.nt; ++t) {
+    profiler.beginStep(t);
+
+    // Adaptive dt; the steps up to the next output (or end) time are then
+    // shortened evenly so that the last one lands on it.
+    double stop = std::numeric_limits<double>::infinity();
+    if (interval > 0.0)
+      stop = nextFrame * interval;
+    if (untilTime)
+      stop = std::min(stop, ts.endTime);
+    bool lands = false;
+    if (ts.adaptive) {
+      double stepDt = cflTimeStep();
+      if (stop < std::numeric_limits<double>::infinity()) {
+        const double remaining = stop - time;
+        const double steps =
+            std::max(1.0, std::ceil(remaining / stepDt - 1e-9));
+        stepDt = remaining / steps;
+        lands = (steps == 1.0);
+      }
+      setTimeStep(stepDt);
+    }
+    profiler.count(TIME_STEP, dt);
+
+    Step();
+    time = lands ? stop : time + dt;
 
-  for (int t = 1; t <= params.nt; ++t) {
-    // Overwrite progress line in place (~every 10 %).
-    if (t % reportEvery == 0) {
+    // Overwrite progress line in place (~every 10 %); reports the step
+    // just taken.
+    const double progress = untilTime ? time / ts.endTime
+                                      : static_cast<double>(t) / params.nt;
+    if (static_cast<int>(10.0 * progress) > reported) {
+      Profiler::Scope scope(profiler, DIAGNOSTICS);
+      reported = static_cast<int>(10.0 * progress);
       varType maxDiv = REAL_LITERAL(0.0);
-      for (int j = 0; j < ny; ++j)
+      for (int j = distributed.own0; j < distributed.own1; ++j)
         for (int i = 0; i < nx; ++i)
           maxDiv = std::max(maxDiv, std::abs(fields->div.Get(i, j)));
+      if (distributed.comm) // over the owned rows of every rank
+        maxDiv = static_cast<varType>(distributed.comm->allReduceMax(maxDiv));
 
-      std::cout << "\rStep " << t << " / " << params.nt << " ("
-                << (100 * t / params.nt) << "%) "
-                << "max |div| = " << maxDiv << std::flush;
+      if (isRoot()) {
+        std::cout << "\rStep " << t;
+        if (untilTime)
+          std::cout << ", t = " << time << " / " << ts.endTime;
+        else
+          std::cout << " / " << params.nt;
+        std::cout << " (" << static_cast<int>(100.0 * progress) << "%) "
+                  << "max |div| = " << maxDiv << "  p-solve: "
+                  << solveStats.iterations << " it"
+                  << (solveStats.warmStarted ? " (warm)" : " (cold)")
+                  << ", rel.res = " << solveStats.relResidual;
+        if (ts.adaptive)
+          std::cout << "  dt = " << dt;
+        std::cout << std::flush;
+      }
     }
 
-    Step();
-    WriteOutput(t);
+    bool outputDue = (t % params.sampling_rate == 0);
+    if (interval > 0.0) {
+      outputDue = reached(time, nextFrame * interval);
+      while (reached(time, nextFrame * interval))
+        nextFrame += 1.0;
+    }
+    if (outputDue)
+      WriteOutput(t);
+
+    if (checkpointEvery > 0 && t % checkpointEvery == 0) {
+      Profiler::Scope scope(profiler, CHECKPOINT);
+      // The checkpoint lists every frame so far; make sure they are on disk.
+      if (outputQueue)
+        outputQueue->flush();
+      if (!WriteCheckpoint(params.checkpoint.file, t))
+        std::cerr << "\n[SemiLagrangian] Warning: no checkpoint at step " << t
+                  << '\n';
+    }
+    profiler.endStep();
+  }
+
+  // Asynchronous output: the run is complete once the last frame is on disk.
+  if (outputQueue) {
+    const double computed = GET_TIME() - start;
+    if (!outputQueue->flush())
+      std::cerr << "\n[SemiLagrangian] Warning: some output frames could "
+                   "not be written\n";
+    if (isRoot())
+      std::cout << "\nSimulation: " << computed << " s, waited "
+                << outputQueue->stallTime() << " s on the output queue";
   }
 
+  // A distributed run reports the timings of rank 0.
+  if (!isRoot())
+    return;
   std::cout << "\nDone: " << (GET_TIME() - start) << " s\n";
+
+  if (params.profile.summary)
+    profiler.printSummary(std::cout);
+  if (!params.profile.timeline.empty() &&
+      !profiler.writeTimeline(params.profile.timeline))
+    std::cerr << "[SemiLagrangian] Warning: could not write the profile "
+                 "timeline to '"
+              << params.profile.timeline << "'\n";
 }
+
+} // namespace PIC_REAL
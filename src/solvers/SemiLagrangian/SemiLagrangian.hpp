@@ -1,23 +1,53 @@
 #pragma once
+#include "../../core/Communicator.hpp"
 #include "../../core/Fields.hpp"
 #include "../../core/OutputWriter.hpp"
 #include "../../core/Parameters.hpp"
+#include "../../core/Profiler.hpp"
+#include "../../core/Transforms.hpp"
+#include "../PIC/ParticleTransport.hpp"
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 
 /**
  * @file SemiLagrangian.hpp
  * @brief Semi-Lagrangian incompressible Navier-Stokes solver on a MAC grid.
  */
 
+namespace PIC_REAL {
+
 /**
  * @brief 2-D incompressible Navier-Stokes solver using a semi-Lagrangian
  *        advection scheme and a pressure-projection method.
  *
  * ### Algorithm — one time step
+ * 0. **Diffuse** (with @c ViscosityConfig::nu > 0): implicit viscous
+ *    diffusion of u and v.
  * 1. **Project** (+MakeIncompressible): solve the pressure Poisson equation
  *    and correct velocities so that \f$\nabla \cdot \mathbf{u} \approx 0 \f$.
  * 2. **Advect**: trace departure points backward in time (RK2) and
- *    interpolate the velocity field at those points.
+ *    interpolate the velocity field at those points; optionally corrected
+ *    to second order by MacCormack or BFECC (@c TransportConfig::advection).
+ *
+ * With a particle transport scheme (PIC / FLIP / APIC, see
+ * @c TransportConfig) step 2 is replaced by a @c ParticleTransport: the
+ * particles are splatted to the grid before the projection and pick up the
+ * projected velocity afterwards, then move through it. Projection, sources
+ * and smoke advection are shared by all schemes.
+ *
+ * With @c DecompositionConfig::enabled steps 1-2 run in one parallel region
+ * over per-thread row slabs (@c StepDecomposed()).
+ *
+ * In a distributed run (@c DistributedConfig) each rank constructs its own
+ * solver on a slab of rows plus halo rows, and the ranks exchange the halos
+ * through a @c Communicator (@c StepDistributed()).
  */
 class SemiLagrangian {
 public:
@@ -25,17 +55,52 @@ public:
    * @brief Construct the solver, initialise fields, and open output writers.
    * @param params Simulation parameters (non-owning reference, must outlive
    *               this object).
+   * @param comm   This rank of a distributed run, whose fields then cover
+   *               only the rank's slab; @c nullptr for the whole domain
+   *               (non-owning, must outlive this object).
    */
-  explicit SemiLagrangian(const Parameters &params);
+  explicit SemiLagrangian(const Parameters &params,
+                          Communicator *comm = nullptr);
 
   ~SemiLagrangian();
 
   SemiLagrangian(const SemiLagrangian &) = delete;
   SemiLagrangian &operator=(const SemiLagrangian &) = delete;
 
-  /// @brief Run the full simulation loop (nt steps) and write output.
+  /**
+   * @brief Run the simulation loop up to step nt and write output.
+   *
+   * Starts at step 0, or after the step restored by @c Restore(). With
+   * @c params.checkpoint.interval set, a checkpoint is written every that
+   * many steps.
+   */
   void Run();
 
+  /**
+   * @brief Write a restart checkpoint of the state after @p step.
+   *
+   * Holds u, v, p, the smoke, the cell labels, the particles (particle
+   * schemes) and the frame counters and PVD entries of the output writers.
+   *
+   * @param path Destination, replaced atomically.
+   * @param step Last completed time step.
+   * @return @c true on success.
+   */
+  bool WriteCheckpoint(const std::string &path, int step) const;
+
+  /**
+   * @brief Resume from a checkpoint written by @c WriteCheckpoint().
+   *
+   * Replaces the scene setup: with @c params.restartFile set, the
+   * constructor leaves fields and labels empty for this call to fill. Grid
+   * size and precision must match the checkpoint; a different
+   * @c Parameters::configHash only prints a warning.
+   *
+   * @param path Checkpoint file.
+   * @return @c false (with a message) if the checkpoint cannot be used.
+   */
+  bool Restore(const std::string &path);
+
   /// @brief Advance the simulation by one time step.
   void Step();
 
@@ -44,16 +109,406 @@ public:
     return *fields;
   } ///< Access fields (const).
 
+  /// @brief Outcome of the most recent pressure solve.
+  struct PressureSolveStats {
+    int iterations = 0;         ///< Iterations / cycles performed.
+    double refResidual = 0;     ///< RMS residual of the relative criterion.
+    double relResidual = 0;     ///< Final residual relative to the reference.
+    bool converged = false;     ///< Tolerance reached before maxIters.
+    bool warmStarted = false;   ///< Initial guess was the previous step's p.
+  };
+
+  /// @return Statistics of the last pressure solve.
+  [[nodiscard]] const PressureSolveStats &LastPressureSolve() const {
+    return solveStats;
+  }
+
 private:
+  /// The kernel micro-benchmarks (PIC_bench) time the private kernels.
+  friend struct SemiLagrangianBench;
+
   const Parameters &params;
 
   // Cached scalars from params to avoid pointer chasing in hot loops.
   int nx, ny;
   varType dx, dy, dt;
+  varType invDx, invDy; ///< 1/dx, 1/dy (multiplied instead of dividing).
   varType density;
 
   Fields2D *fields; ///< @todo Replace with std::unique_ptr<Fields2D>.
 
+  PressureSolveStats solveStats; ///< Filled by every pressure solver.
+
+  /// Phases of a time step timed by @c profiler (timeline columns).
+  enum Phase : int {
+    SOURCES,             ///< Re-applied scene sources.
+    P2G,                 ///< Particle-to-grid transfer.
+    VISCOSITY,           ///< Implicit viscous diffusion.
+    DIVERGENCE,          ///< div u on the right-hand side of the solve.
+    PRESSURE,            ///< Pressure solve, without the divergence.
+    VELOCITY_UPDATE,     ///< Pressure-gradient correction.
+    ADVECT,              ///< Velocity (+ fused smoke) advection / G2P.
+    ADVECT_SMOKE,        ///< Smoke advection.
+    DIAGNOSTICS,         ///< div and |u| for output and progress.
+    WRITE_FIELDS,        ///< Combined output frame.
+    WRITE_U,             ///< u output.
+    WRITE_V,             ///< v output.
+    WRITE_P,             ///< p output.
+    WRITE_DIV,           ///< div output.
+    WRITE_NORM_VELOCITY, ///< |u| output.
+    WRITE_SMOKE,         ///< Smoke output.
+    CHECKPOINT,          ///< Checkpoint write.
+    NUM_PHASES
+  };
+
+  /// Per-step counters recorded by @c profiler.
+  enum Counter : int {
+    PRESSURE_ITERATIONS,  ///< Iterations / cycles of the pressure solve.
+    PRESSURE_RESIDUAL,    ///< Final relative residual of the solve.
+    TIME_STEP,            ///< dt of the step.
+    VISCOSITY_ITERATIONS, ///< Iterations of the slower viscous solve.
+    SMOKE_TILES,          ///< Smoke tiles advected (sparse smoke).
+    NUM_COUNTERS
+  };
+
+  /// Always-on step timeline; mutable so that the const output path can
+  /// time itself.
+  mutable Profiler profiler;
+
+  /// Particle velocity transport; null for semi-Lagrangian advection.
+  std::unique_ptr<ParticleTransport> particles;
+
+  /**
+   * @brief Compacted 5-point stencil of the FLUID cells.
+   *
+   * Entry @c t describes the @c t-th FLUID cell in row-major order by its
+   * offset into the padded storage of @c Fields2D::p and @c div. The four
+   * neighbours sit at ±1 and ±stride; one outside the domain is a zero
+   * ghost cell, so the relaxation kernels sum all four without bounds or
+   * label checks.
+   *
+   * Rebuilt only when @c Fields2D::LabelsVersion() changes.
+   */
+  struct FluidStencil {
+    std::vector<int> cell;        ///< Padded offset of each FLUID cell.
+    int stride = 0;               ///< Row pitch of @c Fields2D::p.
+    std::vector<double> count;    ///< In-domain neighbours N.
+    std::vector<double> invCount; ///< 1 / N.
+    std::vector<double> pNew;     ///< Jacobi buffer, one per entry.
+    std::vector<int> red;   ///< Entries with (i + j) even, for red-black GS.
+    std::vector<int> black; ///< Entries with (i + j) odd.
+    /// Fields2D::LabelsVersion() the stencil was built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+  };
+  FluidStencil stencil;
+
+  /**
+   * @brief Preconditioner state of the PCG pressure solver (its work
+   *        vectors are those of @c pressure).
+   *
+   * @c precon is a flat row-major nx × ny array like the work vectors of
+   * @c pressure, zero on the non-FLUID cells.
+   */
+  struct PCGWorkspace {
+    std::vector<double> precon; ///< MIC(0) inverse pivots, 1/sqrt(e_ij).
+    /// Fields2D::LabelsVersion() the preconditioner was built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+    /// Preconditioner in use for the current solve (the configured one, or
+    /// MIC(0) when the spectral preconditioner does not fit the geometry).
+    SolverConfig::Preconditioner active = SolverConfig::Preconditioner::MIC0;
+  };
+  PCGWorkspace pcg;
+
+  /**
+   * @brief One level of the geometric multigrid hierarchy.
+   *
+   * Level 0 has the dimensions of the pressure grid; every further level
+   * halves them (rounding up). A coarse cell is SOLID as soon as one of its
+   * children is SOLID, matching the fixed-pressure treatment of solids in
+   * the fine operator.
+   *
+   * The grids carry a one-cell zero halo and share one padded layout, so
+   * the level kernels index all of them with the same row offset and run
+   * without bounds checks: out-of-domain neighbours read 0, and the
+   * Neumann domain edge is carried by the neighbour count in @c diag.
+   *
+   * @tparam Real Storage of the level grids: @c varType, or float for
+   *              @c SolverConfig::Precision::MIXED.
+   */
+  template <typename Real> struct MultigridLevel {
+    int nx;                        ///< Cells in x on this level.
+    int ny;                        ///< Cells in y on this level.
+    PaddedGrid2D<1, Real> x;       ///< Correction (unknown) on this level.
+    PaddedGrid2D<1, Real> b;       ///< Right-hand side (restricted residual).
+    PaddedGrid2D<1, Real> r;       ///< Scratch residual before restriction.
+    PaddedGrid2D<1, Real> diag;    ///< In-domain neighbours N, 0 on SOLID.
+    PaddedGrid2D<1, Real> invDiag; ///< 1/N, 0 on SOLID.
+    std::vector<uint8_t> labels;   ///< Coarsened cell types, row-major.
+
+    MultigridLevel(int nx, int ny)
+        : nx(nx), ny(ny), x(nx, ny), b(nx, ny), r(nx, ny), diag(nx, ny),
+          invDiag(nx, ny),
+          labels(static_cast<std::size_t>(nx) * ny, Fields2D::FLUID) {}
+
+    /// @return @c true if cell (i, j) of this level is FLUID.
+    [[nodiscard]] bool Fluid(int i, int j) const {
+      return labels[nx * j + i] == Fields2D::FLUID;
+    }
+  };
+
+  /**
+   * @brief Persistent state of the multigrid solver / preconditioner.
+   *
+   * Only one of the two hierarchies is built, in the precision selected by
+   * @c SolverConfig::precision; the other stays empty.
+   */
+  struct MultigridWorkspace {
+    std::vector<MultigridLevel<varType>> levels;    ///< Finest first.
+    std::vector<MultigridLevel<float>> mixedLevels; ///< Same, in float.
+    std::vector<double> r; ///< Fine residual (stand-alone solver).
+    std::vector<double> z; ///< Fine correction (stand-alone solver).
+    /// Fields2D::LabelsVersion() the hierarchy was built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+    /// Precision of the hierarchy in use.
+    SolverConfig::Precision precision = SolverConfig::Precision::WORKING;
+  };
+  MultigridWorkspace mg;
+
+  /**
+   * @brief Persistent state of the spectral (DCT/DST) pressure solver.
+   *
+   * The solver works on the bounding box of the FLUID cells. Each box edge
+   * is Neumann if it lies on the domain edge and Dirichlet (fixed SOLID
+   * pressure) otherwise; an axis is transformable only if both of its edges
+   * agree.
+   */
+  struct SpectralWorkspace {
+    bool valid = false; ///< Both axes have a matching boundary pair.
+    bool exact = false; ///< Box has no interior SOLID cells.
+    int i0 = 0, j0 = 0; ///< Lower-left cell of the box.
+    int w = 0, h = 0;   ///< Box size in cells.
+    std::unique_ptr<TrigTransform> tx; ///< Transform along x (length w).
+    std::unique_ptr<TrigTransform> ty; ///< Transform along y (length h).
+    std::vector<double> box;           ///< w × h coefficients, row-major.
+    std::vector<std::complex<double>> work; ///< Per-thread FFT scratch.
+    std::size_t workPerThread = 0;          ///< Stride inside @c work.
+    std::vector<double> r; ///< Fine residual (stand-alone solver).
+    std::vector<double> z; ///< Fine correction (stand-alone solver).
+    /// Fields2D::LabelsVersion() the box was detected for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+  };
+  SpectralWorkspace spectral;
+
+  /**
+   * @brief Weights of a symmetric 5-point operator on an nx × ny grid:
+   *
+   * \f$ (A\,x)_k = \text{shift}\cdot x_k
+   *     + c_x\,(2x_k - x_W - x_E) + c_y\,(2x_k - x_S - x_N) \f$
+   *
+   * where a neighbour outside the grid is replaced by @f$x_k@f$, which drops
+   * it from the stencil (zero normal gradient). The pressure Poisson
+   * operator has @c shift = 0 and unit weights, the viscous Helmholtz
+   * operators @c shift = 1 and \f$c = \theta\,\nu\,\Delta t/\Delta x^2\f$.
+   */
+  struct StencilOperator {
+    int nx = 0, ny = 0;  ///< Grid size.
+    double shift = 0.0;  ///< Weight of the identity.
+    double cx = 1.0;     ///< Weight of the x-neighbour differences.
+    double cy = 1.0;     ///< Weight of the y-neighbour differences.
+
+    /// @return Diagonal of A at (@p i, @p j).
+    [[nodiscard]] double diagonal(const int i, const int j) const {
+      return shift + cx * ((i > 0) + (i + 1 < nx)) +
+             cy * ((j > 0) + (j + 1 < ny));
+    }
+
+    /**
+     * @brief @p out = A·@p x on row @p j where @p free is set, 0 elsewhere.
+     *
+     * @p x points at cell (0, 0) and has rows @p stride apart; @p free and
+     * @p out are row-major nx × ny.
+     */
+    template <typename T>
+    void applyRow(const T *x, const int stride, const uint8_t *free,
+                  const int j, double *out) const {
+      const std::size_t row = static_cast<std::size_t>(nx) * j;
+      const int south = (j > 0) ? stride : 0;
+      const int north = (j + 1 < ny) ? stride : 0;
+      const int n = nx;
+      const T *xr = x + static_cast<std::ptrdiff_t>(stride) * j;
+      const uint8_t *fr = free + row;
+      double *outr = out + row;
+
+      OMP_PRAGMA(omp simd)
+      for (int i = 0; i < n; ++i) {
+        const double xk = xr[i];
+        const double lap =
+            cx * (2.0 * xk - xr[i - (i > 0)] - xr[i + (i + 1 < n)]) +
+            cy * (2.0 * xk - xr[i - south] - xr[i + north]);
+        outr[i] = fr[i] ? shift * xk + lap : 0.0;
+      }
+    }
+  };
+
+  /**
+   * @brief Linear system A·x = b of a @c StencilOperator, solved in place
+   *        by @c solvePCG() (pressure and viscosity) or @c solveRedBlack()
+   *        (viscosity).
+   *
+   * Only the cells marked in @c free are unknowns. The others keep their
+   * value in @c x and enter A·x as Dirichlet data: SOLID pressures, the
+   * velocity faces on the domain boundary or next to a SOLID cell. @c x
+   * is the storage of the solved grid (padded for the pressure); all other
+   * vectors are flat and row-major nx × ny, and their entries of fixed
+   * cells are zero.
+   */
+  struct LinearSystem {
+    StencilOperator op;        ///< A.
+    varType *x = nullptr;      ///< Cell (0, 0) of the solution, in place.
+    int stride = 0;            ///< Row pitch of @c x.
+    std::vector<uint8_t> free; ///< 1 for the unknowns.
+    int unknowns = 0;          ///< Number of unknowns.
+    std::vector<double> b;     ///< Right-hand side.
+    std::vector<double> r;     ///< Residual.
+    std::vector<double> z;     ///< Preconditioned residual (PCG).
+    std::vector<double> s;     ///< Search direction (PCG).
+    std::vector<double> q;     ///< A·s (PCG).
+    double rho = 0.0;          ///< r·z of the current iteration.
+    double res = 0.0;          ///< RMS residual.
+    double res0 = 1.0;         ///< Reference of the relative criterion.
+    int iterations = 0;        ///< Iterations of the last solve.
+    bool done = false;         ///< Converged, broke down or nothing to do.
+    bool converged = false;    ///< The relative criterion was met.
+
+    /// @brief Solve on @p grid: @c bind() it, size the vectors (the PCG
+    ///        ones too with @p pcg) and mark every cell fixed.
+    template <typename Layout>
+    void resize(BasicGrid2D<Layout> &grid, const bool pcg) {
+      bind(grid);
+      resize(grid.nx, grid.ny, pcg);
+    }
+    void resize(int nx, int ny, bool pcg);
+
+    /// @brief Point @c x at the storage of @p grid. Needed before every
+    ///        solve of a grid that swaps with a back-buffer.
+    template <typename Layout> void bind(BasicGrid2D<Layout> &grid) {
+      static_assert(Layout::strided, "the solvers sweep contiguous rows");
+      x = grid.A.data() + grid.layout(0, 0);
+      stride = grid.layout.stride();
+    }
+
+    /// @return Row @p j of @c x.
+    [[nodiscard]] varType *row(const int j) const {
+      return x + static_cast<std::ptrdiff_t>(stride) * j;
+    }
+
+    /// @brief Reset the statistics before a solve; @c done at once if there
+    ///        is nothing to solve.
+    void begin() {
+      iterations = 0;
+      res = res0 = 0.0;
+      converged = done = (unknowns == 0);
+    }
+  };
+
+  /// Pressure Poisson system of @c SolvePCG(): the FLUID cells are the
+  /// unknowns.
+  struct PressureSystem {
+    LinearSystem sys; ///< b = -coef·div on the FLUID cells.
+    /// Fields2D::LabelsVersion() the mask was built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+  };
+  PressureSystem pressure;
+
+  /// Persistent state of the viscous diffusion stage.
+  struct ViscosityWorkspace {
+    std::array<LinearSystem, 2> sys; ///< u, then v.
+    /// Fields2D::LabelsVersion() the masks were built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+  };
+  ViscosityWorkspace viscosity;
+
+  /**
+   * @brief One slab of the domain-decomposed step: pressure rows
+   *        [@c j0, @c j1), owned by thread @c s of the step's parallel
+   *        region.
+   *
+   * The grids cover the slab plus a one-cell halo. Halo columns and halo
+   * rows on the domain edge stay 0 (out-of-domain neighbours drop out, as
+   * in @c FluidStencil); the other halo rows receive the neighbouring
+   * slabs' edge rows. The owning thread allocates the slab inside the
+   * parallel region, so its pages are first-touched on that thread's NUMA
+   * node.
+   */
+  struct Subdomain {
+    int j0; ///< First owned row.
+    int j1; ///< One past the last owned row.
+    PaddedGrid2D<1> p;       ///< Pressure, halo rows included.
+    PaddedGrid2D<1> rhs;     ///< -coef · div of the owned cells.
+    PaddedGrid2D<1> diag;    ///< In-domain neighbours N, 0 on SOLID.
+    PaddedGrid2D<1> invDiag; ///< 1/N, 0 on SOLID.
+    int fluidCells = 0;      ///< Owned cells with N > 0.
+    /// First (@c [0]) and last (@c [1]) owned row of p as published to the
+    /// neighbours, double-buffered by exchange parity.
+    std::array<std::array<std::vector<varType>, 2>, 2> edge;
+    /// Number of the last exchange whose edge rows are published.
+    alignas(GRID_ALIGNMENT) std::atomic<uint64_t> published{0};
+
+    Subdomain(int nx, int j0, int j1)
+        : j0(j0), j1(j1), p(nx, j1 - j0), rhs(nx, j1 - j0),
+          diag(nx, j1 - j0), invDiag(nx, j1 - j0),
+          edge{{{std::vector<varType>(nx), std::vector<varType>(nx)},
+                {std::vector<varType>(nx), std::vector<varType>(nx)}}} {}
+  };
+
+  /// Persistent state of the domain-decomposed step.
+  struct DecompositionWorkspace {
+    std::vector<std::unique_ptr<Subdomain>> sub; ///< One slab per thread.
+    /// Residual partial sums, one cache line per slab, double-buffered by
+    /// reduction parity: [parity][slab][sum of squares, cell count, pad].
+    /// Slot 2 of parity 0: max |u|/dx, |v|/dy of the slab (sparse smoke).
+    std::vector<double> partial;
+    /// Halo exchanges of all earlier steps; the epoch the flags count from.
+    uint64_t exchanges = 0;
+    /// Fields2D::LabelsVersion() the slab diagonals were built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+    bool warnedTeam = false; ///< A short team was reported once.
+  };
+  DecompositionWorkspace decomposition;
+
+  /**
+   * @brief Rank layout of a distributed run.
+   *
+   * The rank's Fields2D holds rows [@c row0, @c row0 + ny) of the domain:
+   * its owned pressure rows [@c own0, @c own1) (local indices) and up to
+   * @c DistributedConfig::halo rows of each neighbour. The kernels run on
+   * the local grids as on a whole domain; only the owned rows are kept,
+   * and @c exchangeHalo() refreshes the others from their owners.
+   */
+  struct DistributedWorkspace {
+    Communicator *comm = nullptr; ///< Null for a single-process run.
+    int globalNy = 0;             ///< Pressure rows of the whole domain.
+    std::vector<int> rowStarts;   ///< First owned domain row of each rank.
+    int row0 = 0;                 ///< Domain row of local row 0.
+    int own0 = 0;                 ///< First owned local row.
+    int own1 = 0;                 ///< One past the last owned local row.
+    /// Owned pressure rows and their two neighbour rows during the solve
+    /// (the edge buffers and the flag of the threaded step are unused).
+    std::unique_ptr<Subdomain> slab;
+    /// Fields2D::LabelsVersion() the slab diagonal was built for.
+    uint64_t labelsVersion = std::numeric_limits<uint64_t>::max();
+    bool warnedHalo = false; ///< Sub-stepped advection was reported once.
+  };
+  DistributedWorkspace distributed;
+
+  /// Background I/O shared by the writers; null for synchronous output.
+  /// Declared first so it outlives them (their destructors flush it).
+  std::unique_ptr<AsyncOutput> outputQueue;
+
+  /// Combined writer (all fields in one file per step), non-null only with
+  /// @c output.combined; the per-field writers are unused then.
+  std::unique_ptr<OutputWriter> frameWriter;
+
   // Output writers — null if the corresponding write_* flag is false.
   std::unique_ptr<OutputWriter> uWriter;
   std::unique_ptr<OutputWriter> vWriter;
@@ -62,90 +517,338 @@ private:
   std::unique_ptr<OutputWriter> normVelocityWriter;
   std::unique_ptr<OutputWriter> smokeWriter;
 
+  int startStep = 0; ///< Step the run resumes after (set by Restore()).
+  double time = 0.0; ///< Simulated time of the current state.
+
   /// @brief Construct the OutputWriters requested in @c params.
   void InitializeOutputWriters();
 
+  /// @return The output writers in use (non-null ones only).
+  [[nodiscard]] std::vector<OutputWriter *> outputWriters() const;
+
   /**
-   * @brief Write all enabled fields at the current step if it falls on a
-   *        sampling interval.
-   * @param step Current time-step index (0-based).
+   * @brief Write all enabled fields as the frame of the current @c time.
+   * @param step Current time-step index (0-based), for messages.
    */
   void WriteOutput(int step) const;
 
+  // Time stepping
+
+  /**
+   * @brief Largest dt allowed by the CFL target for the current velocity.
+   *
+   * \f$ \Delta t = \text{CFL} / \max(|u|_{\max}/\Delta x,
+   * |v|_{\max}/\Delta y) \f$ from a parallel max-reduction over the
+   * faces, clamped to [@c dtMin, @c dtMax] (@c dtMax for a fluid at rest).
+   */
+  [[nodiscard]] double cflTimeStep() const;
+
+  /// @return \f$ \max(|u|_{\max}/\Delta x, |v|_{\max}/\Delta y) \f$ over
+  ///         this rank's faces: cells travelled per unit time, at most.
+  [[nodiscard]] double velocityRate() const;
+
+  /**
+   * @brief Use @p newDt from the next step on: updates @c dt and
+   *        @c Fields2D::dt, from which the advection, the velocity update and
+   *        the pressure coefficient \f$ \rho\,\Delta x^2/\Delta t \f$ are
+   *        derived.
+   */
+  void setTimeStep(double newDt);
+
+  /**
+   * @brief Write every enabled field as one frame of @c frameWriter.
+   *
+   * All arrays live on the nx × ny pressure cells: u and v are averaged
+   * from their two faces, and the (nx-1) × (ny-1) diagnostics repeat their
+   * last column and row.
+   *
+   * @return @c true on success (or once queued).
+   */
+  bool writeCombinedFrame() const;
+
+  /**
+   * @brief Write @p grid as one frame of @p writer: the whole grid, or in a
+   *        distributed run this rank's rows of it as a piece.
+   * @return @c true on success (or once queued).
+   */
+  template <typename Layout>
+  bool writeField(OutputWriter &writer, const BasicGrid2D<Layout> &grid,
+                  const std::string &id) const;
+
   // Advection
 
+  /**
+   * @brief Per-thread row buffers of the batched advection kernels.
+   *
+   * Each pointer addresses one row-length slice of @c advectScratch, so a
+   * whole row of departure points is traced with SIMD-friendly loops over
+   * contiguous arrays.
+   */
+  struct AdvectRow {
+    varType *x0, *y0; ///< Start positions (physical).
+    varType *x, *y;   ///< Midpoints, then departure points (physical).
+    varType *xs, *ys; ///< Scaled positions x/dx, y/dy.
+    varType *u, *v;   ///< Velocity sampled at (xs, ys).
+  };
+
+  int advectRowLen = 0;               ///< Longest advected row (u: nx+1).
+  std::vector<varType> advectScratch; ///< 8 row buffers per thread.
+
+  /// @return Row buffers of thread @p thread.
+  [[nodiscard]] AdvectRow advectRow(int thread);
+
+  /**
+   * @brief Persistent buffers of the error-corrected advection of one
+   *        field (allocated only for MacCormack / BFECC). @c work swaps
+   *        with the field's back-buffer, so it shares its @p Layout.
+   */
+  template <typename Layout = RowMajorLayout> struct CorrectionScratch {
+    Grid2D xs, ys; ///< Backward departure points (index space).
+    BasicGrid2D<Layout> work; ///< Corrected (MacCormack) / compensated
+                              ///< (BFECC) field.
+
+    CorrectionScratch(int nx, int ny) : xs(nx, ny), ys(nx, ny), work(nx, ny) {}
+  };
+
+  std::unique_ptr<CorrectionScratch<>> uCorrection; ///< For u.
+  std::unique_ptr<CorrectionScratch<>> vCorrection; ///< For v.
+  std::unique_ptr<CorrectionScratch<SmokeLayout>>
+      smokeCorrection; ///< For smokeMap.
+
   /**
    * @brief Advect u and v using a semi-Lagrangian (RK2 backward-trace +
-   *        bilinear interpolation) scheme.
+   *        bilinear or monotone cubic interpolation) scheme.
    */
-  void Advect() const;
+  void Advect();
+
+  /**
+   * @brief Advect u, v and smokeMap in one semi-Lagrangian pass.
+   *
+   * Same scheme as @c Advect() followed by @c AdvectSmoke() through the
+   * same velocity, with the three traces of a row fused so that the
+   * velocity is streamed once, and the first RK2 stage read from fixed
+   * node stencils instead of interpolated. Used for the semi-Lagrangian
+   * transport with uncorrected advection.
+   */
+  void AdvectFused();
+
+  /// @brief Row @p j of @c AdvectFused(): u-face, v-face and smoke row j
+  ///        into the back-buffers (rows past a field's last are skipped).
+  void advectFusedRow(int j, AdvectRow &row);
 
   // Smoke Advection
 
   /**
    * @brief Advect smokeMap using a semi-Lagrangian (RK2 backward-trace +
-   *        bilinear interpolation) scheme.
+   *        bilinear or monotone cubic interpolation) scheme.
    */
-  void AdvectSmoke() const;
+  void AdvectSmoke();
 
   /**
-   * @brief Trace the departure point of a u-face at grid position (i, j)
-   *        backward in time using RK2.
+   * @brief Select the smoke tiles to advect this step (sparse smoke): those
+   *        within reach of an occupied tile, the reach being the distance
+   *        a trace at @p rate (see @c velocityRate()) covers in dt, plus
+   *        the interpolation stencil and @c SparseSmokeConfig::band.
+   */
+  void updateSmokeTiles(double rate);
+
+  /**
+   * @brief Smoke row @p j of the back-buffer, restricted to the active
+   *        tiles with sparse smoke.
+   *
+   * @p traceSpan(i0, i1, out) computes cells [i0, i1) of the row into
+   * @p out, which is the row of @c smokeNext itself or, for a tiled
+   * @c SmokeLayout, @p buf (stored into the tiles afterwards): once for the
+   * whole row without tiles, else once per run of active tiles. The other
+   * tiles are zeroed where needed, and the occupancy of every tile segment
+   * of the row is recorded. Defined in Advect.cpp, where both smoke
+   * advections use it.
+   */
+  template <typename TraceSpan>
+  void smokeRow(int j, varType *buf, TraceSpan &&traceSpan);
+
+  /**
+   * @brief Advect one field with the error-corrected scheme selected by
+   *        @c TransportConfig::advection.
+   *
+   * With \f$A\f$ the semi-Lagrangian step (backward trace through the
+   * current velocity) and \f$A^R\f$ its reverse (forward trace):
+   * - MacCormack: \f$\hat q = A(q)\f$,
+   *   \f$q^{n+1} = \hat q + \tfrac12\,(q - A^R(\hat q))\f$;
+   * - BFECC: \f$\tilde q = q + \tfrac12\,(q - A^R(A(q)))\f$,
+   *   \f$q^{n+1} = A(\tilde q)\f$.
    *
-   * The u-face is located at physical position (i.dx, (j+0.5).dy).
+   * The result is clamped to the range of the four values of @p q the
+   * backward trace interpolates from, which keeps it free of new extrema.
+   * Each step is a row-parallel pass; @p q is read-only throughout, so u
+   * and v can be advected one after the other from the same velocity.
    *
-   * @param[in]  i  Face x-index.
-   * @param[in]  j  Face y-index.
-   * @param[out] x  Physical x-coordinate of the departure point.
-   * @param[out] y  Physical y-coordinate of the departure point.
+   * @param q       Field at the current step.
+   * @param qNext   Receives the advected field.
+   * @param scratch Buffers sized like @p q.
+   * @param offX    x-position of q(0, 0) in cells (stagger offset).
+   * @param offY    y-position of q(0, 0) in cells.
+   * @param cubic   Interpolate with the monotone cubic (else bilinear).
    */
-  void traceParticleU(int i, int j, varType &x, varType &y) const;
+  template <typename Layout>
+  void advectCorrected(const BasicGrid2D<Layout> &q,
+                       BasicGrid2D<Layout> &qNext,
+                       CorrectionScratch<Layout> &scratch, varType offX,
+                       varType offY, bool cubic);
 
   /**
-   * @brief Trace the departure point of a v-face at grid position (i, j)
-   *        backward in time using RK2.
+   * @brief Sample both velocity components at @p n physical positions.
+   *
+   * The positions are scaled to index space once (into @c row.xs /
+   * @c row.ys) and shared by the u and v interpolations, which differ only
+   * by their stagger offsets.
+   *
+   * @param[in]     n   Number of points.
+   * @param[in]     x   Physical x-coordinates.
+   * @param[in]     y   Physical y-coordinates.
+   * @param[in,out] row Buffers; @c u and @c v receive the result.
+   */
+  void sampleVelocity(int n, const varType *x, const varType *y,
+                      AdvectRow &row) const;
+
+  /**
+   * @brief Trace @p n points backward in time using RK2.
+   *
+   * Reads the start positions from @c row.x0 / @c row.y0 and leaves the
+   * departure points, clamped to the domain, in @c row.x / @c row.y and
+   * scaled to index space in @c row.xs / @c row.ys, ready for
+   * @c Grid2D::InterpolateBatch().
+   *
+   * @param[in]     n       Number of points.
+   * @param[in,out] row     Buffers of the calling thread.
+   * @param[in]     traceDt Time to trace back over (negative: forward).
+   */
+  void traceDepartureRow(int n, AdvectRow &row, varType traceDt) const;
+
+  /**
+   * @brief Second half of @c traceDepartureRow(): departure points from the
+   *        midpoints already in @c row.x / @c row.y.
+   *
+   * @param[in]     n       Number of points.
+   * @param[in,out] row     Buffers of the calling thread.
+   * @param[in]     traceDt Time to trace back over (negative: forward).
+   */
+  void traceFromMidpoint(int n, AdvectRow &row, varType traceDt) const;
+
+  // Viscosity
+
+  /**
+   * @brief Diffuse u and v implicitly over one time step.
+   *
+   * Solves \f$(I - \theta\,\nu\,\Delta t\,L)\,u^{n+1} =
+   * (I + (1-\theta)\,\nu\,\Delta t\,L)\,u^n\f$ for both components, with
+   * \f$\theta = 1\f$ (backward Euler) or \f$\tfrac12\f$ (Crank-Nicolson)
+   * and L the 5-point Laplacian on the face grid. Fixed faces enter as
+   * Dirichlet values (usolid next to SOLID cells); neighbours outside the
+   * domain drop out of L (zero normal gradient). The solve starts from the
+   * current velocity and runs both components in the same passes, so one
+   * thread team works on u and v together. A no-op for \f$\nu = 0\f$.
+   */
+  void Diffuse();
+
+  /// @brief Rebuild the unknown-face masks if the solid mask changed.
+  void prepareViscosity();
+
+
+  // Domain decomposition
+
+  /**
+   * @brief Run the projection, and with @p transport the fused advection
+   *        and the diagnostics, in one parallel region over per-thread row
+   *        slabs.
+   *
+   * Each slab relaxes its rows of the pressure with red-black Gauss-Seidel
+   * and exchanges halo rows with its two neighbours through point-to-point
+   * flags; the residual is reduced over the team only every
+   * @c DecompositionConfig::checkInterval iterations. The velocity update,
+   * advection and diagnostics then work on the slab's own rows, with one
+   * barrier before the advection (which reads the whole velocity) and one
+   * at the buffer swap. Equivalent to @c MakeIncompressible() with the
+   * red-black solver, followed by @c AdvectFused() and the diagnostics.
    *
-   * The v-face is located at physical position ((i+0.5).dx, j.dy).
+   * The region must get one thread per slab. If the runtime grants fewer
+   * (OMP_DYNAMIC, a thread limit), nothing is done and the caller falls
+   * back to the shared step.
    *
-   * @param[in]  i  Face x-index.
-   * @param[in]  j  Face y-index.
-   * @param[out] x  Physical x-coordinate of the departure point.
-   * @param[out] y  Physical y-coordinate of the departure point.
+   * @param transport Also advect and update the diagnostics (the
+   *                  semi-Lagrangian transport with uncorrected advection).
+   * @return @c false if the team was too small and nothing was done.
    */
-  void traceParticleV(int i, int j, varType &x, varType &y) const;
+  [[nodiscard]] bool StepDecomposed(bool transport);
+
+  /// @brief Size @c decomposition for @p parts slabs (reset on a change).
+  void prepareDecomposition(int parts);
 
   /**
-   * @brief Bilinearly interpolate the u field at physical position (x, y).
-   * @param x Physical x-coordinate (clamped to the domain).
-   * @param y Physical y-coordinate (clamped to the domain).
-   * @return  Interpolated u value.
+   * @brief Relax the cells of one colour in the owned rows of @p sd.
+   * @param red Relax cells with (i + j) even (domain rows), else odd.
+   * @return Sum of the squared residuals of the relaxed cells before their
+   *         update.
    */
-  [[nodiscard]] varType interpolateU(varType x, varType y) const;
+  static double relaxColour(Subdomain &sd, int nx, bool red);
+
+  /// @return Sum of the squared residuals of the owned cells of @p sd.
+  static double slabResidual(const Subdomain &sd, int nx);
+
+  // Distributed run
 
   /**
-   * @brief Bilinearly interpolate the v field at physical position (x, y).
-   * @param x Physical x-coordinate (clamped to the domain).
-   * @param y Physical y-coordinate (clamped to the domain).
-   * @return  Interpolated v value.
+   * @brief Time step of one rank of a distributed run, after the sources.
+   *
+   * Projection with @c solveDistributed(), velocity update of the local
+   * grid from p with its halo rows, fused semi-Lagrangian advection of the
+   * owned rows, halo exchange of u, v and the smoke, and the diagnostics
+   * of the owned rows. Equivalent to @c MakeIncompressible() with the
+   * red-black solver followed by @c AdvectFused() on the whole domain.
+   *
+   * When the fastest face of any rank would carry a trace, with its
+   * interpolation stencil, past the halo rows, the advection is split into
+   * as many sub-steps (each with its own halo exchange) as keep it inside.
    */
-  [[nodiscard]] varType interpolateV(varType x, varType y) const;
+  void StepDistributed();
 
   /**
-   * @brief Bilinearly interpolate the smoke field at physical position (x, y).
-   * @param x Physical x-coordinate (clamped to the domain).
-   * @param y Physical y-coordinate (clamped to the domain).
-   * @return  Interpolated smoke value.
+   * @brief Red-black Gauss-Seidel on the owned pressure rows.
+   *
+   * One row is exchanged with each neighbouring rank after every colour;
+   * the residual is summed over the ranks only every
+   * @c DistributedConfig::checkInterval iterations (lagging one iteration,
+   * as in @c StepDecomposed()).
    */
-  [[nodiscard]] varType interpolateSmoke(varType x, varType y) const;
+  void solveDistributed();
 
   /**
-   * @brief Return both velocity components at physical position (x, y).
-   * @param[in]  x Physical x-coordinate.
-   * @param[in]  y Physical y-coordinate.
-   * @param[out] u Interpolated u value.
-   * @param[out] v Interpolated v value.
+   * @brief Replace the halo rows of @p g by the rows their owners hold.
+   *
+   * Sends the top halo-depth owned rows up and the bottom ones down, in two
+   * neighbour exchanges. @p g is u, v, p or the smoke: its row count sets
+   * how many rows the upper halo has.
    */
-  void getVelocity(varType x, varType y, varType &u, varType &v) const;
+  template <typename Layout> void exchangeHalo(BasicGrid2D<Layout> &g);
+
+  /**
+   * @return Local rows [first, last) of @p g owned by this rank: the owned
+   *         pressure rows, and on the last rank every row up to the end of
+   *         @p g (the whole grid without distribution).
+   */
+  template <typename Layout>
+  [[nodiscard]] std::pair<int, int>
+  ownedRows(const BasicGrid2D<Layout> &g) const {
+    const DistributedWorkspace &ws = distributed;
+    const bool last = !ws.comm || ws.comm->rank() + 1 == ws.comm->size();
+    return {ws.own0, last ? g.ny : ws.own1};
+  }
+
+  /// @return @c true on the rank that reports progress and timings (the
+  ///         only one without distribution).
+  [[nodiscard]] bool isRoot() const {
+    return !distributed.comm || distributed.comm->rank() == 0;
+  }
 
   // Projection
   /**
@@ -155,11 +858,15 @@ private:
   void MakeIncompressible();
 
   /**
-   * @brief Dispatch to the pressure solver selected in @c params.
+   * @brief Dispatch to a pressure solver.
+   * @param type     Solver algorithm (normally @c params.solver.type).
    * @param maxIters Maximum number of solver iterations.
    * @param tol      Relative residual convergence threshold.
    */
-  void solvePressure(int maxIters, double tol);
+  void solvePressure(SolverConfig::Type type, int maxIters, double tol);
+
+  /// @brief @c Fields2D::Div() ahead of a pressure solve, timed on its own.
+  void computeDivergence();
 
   /**
    * @brief Apply the pressure gradient to correct face velocities.
@@ -184,18 +891,42 @@ private:
   [[nodiscard]] double computeResidualNorm(varType coef) const;
 
   /**
-   * @brief Compute the Gauss-Seidel update for cell (i, j).
+   * @brief Store the per-cell Poisson residual in @p r and return its RMS.
    *
-   * \f$ p^{\text{new}}_{ij} =
-   *     \frac{-\text{coef}\cdot\text{div}_{ij} + \sum_{\text{nb}}
+   * Same residual as @c computeResidualNorm(); non-FLUID entries of @p r are
+   * set to zero. @p r must hold nx × ny values.
+   *
+   * @param coef Scaling coefficient \f$\rho\,\Delta x^2 / \Delta t \f$.
+   * @param r    Output residual, row-major.
+   * @return RMS residual over all FLUID cells (0 if none).
+   */
+  double computeResidual(varType coef, std::vector<double> &r) const;
+
+  /// @brief p += @p e, for a row-major nx × ny correction @p e.
+  void addCorrection(const std::vector<double> &e);
+
+  /// @brief Rebuild @c stencil if the solid mask changed since the last call.
+  void updateFluidStencil();
+
+  /**
+   * @brief Compute the Gauss-Seidel update for stencil entry @p t.
+   *
+   * \f$ p^{\text{new}}_{k} =
+   *     \frac{-\text{coef}\cdot\text{div}_{k} + \sum_{\text{nb}}
    * p_{\text{nb}}}{N} \f$
    *
-   * @param i    Cell x-index.
-   * @param j    Cell y-index.
+   * @param t    Index into @c stencil (not a grid index).
    * @param coef Scaling coefficient.
-   * @return     New pressure value, or NAN if the cell is not FLUID.
+   * @return     New pressure value for cell @c stencil.cell[t].
    */
-  [[nodiscard]] double getUpdate(int i, int j, varType coef) const;
+  [[nodiscard]] double getUpdate(int t, varType coef) const {
+    const varType *p = fields->p.A.data() + stencil.cell[t];
+    const int s = stencil.stride;
+    const double sumP =
+        static_cast<double>(p[1]) + p[-1] + p[s] + p[-s]; // ghosts are 0
+    return (-coef * fields->div.A[stencil.cell[t]] + sumP) *
+           stencil.invCount[t];
+  }
 
   /// @brief Jacobi pressure solver (fully parallel, slower convergence).
   void SolveJacobi(int maxIters, double tol);
@@ -204,6 +935,211 @@ private:
   void SolveGaussSeidel(int maxIters, double tol);
 
   /// @brief Red-Black Gauss-Seidel pressure solver (parallel + fast
-  /// convergence).
+  /// convergence) over the colour lists of @c stencil.
   void SolveRedBlackGaussSeidel(int maxIters, double tol);
+
+  /**
+   * @brief Preconditioned Conjugate Gradient pressure solver:
+   *        @c solvePCG() on @c pressure with the configured preconditioner.
+   *
+   * Solves the same discrete Poisson system as the relaxation solvers,
+   * restricted to FLUID cells. Pressures of SOLID neighbours enter A·p as
+   * fixed values, so the residual tracked by CG is exactly the one
+   * measured by @c computeResidualNorm().
+   */
+  void SolvePCG(int maxIters, double tol);
+
+  /// Preconditioner of @c solvePCG(): @p z = M⁻¹·@p r for one system.
+  using Precondition =
+      std::function<void(const std::vector<double> &r, std::vector<double> &z)>;
+
+  /**
+   * @brief Preconditioned CG on up to two independent systems, warm-started
+   *        from their current @c x.
+   *
+   * Every pass runs over the rows of all systems in one parallel loop, so
+   * they share the thread team and its barriers; a converged system drops
+   * out of the passes. Fills the statistics of each @c LinearSystem.
+   *
+   * @param sys          Systems to solve.
+   * @param count        Number of systems, 1 or 2.
+   * @param maxIters     Maximum number of iterations.
+   * @param tol          Relative residual convergence threshold.
+   * @param precondition Preconditioner; Jacobi (fused into the row passes)
+   *                     when empty.
+   */
+  static void solvePCG(LinearSystem *sys, int count, int maxIters, double tol,
+                       const Precondition &precondition = {});
+
+  /**
+   * @brief Red-black Gauss-Seidel on up to two independent systems, in the
+   *        same shared passes as @c solvePCG().
+   *
+   * The sweeps visit every cell and skip the fixed ones, which suits the
+   * viscous systems: nearly all their faces are unknowns. The pressure
+   * solver relaxes the colour lists of @c stencil instead. The residual is
+   * measured before the first sweep and after every one.
+   */
+  static void solveRedBlack(LinearSystem *sys, int count, int maxIters,
+                            double tol);
+
+  /**
+   * @brief Run @p fn(c, j, acc) for every row j of the systems c < @p count
+   *        that are not done, in one parallel loop.
+   * @return The sums of the two accumulators @c acc[0], @c acc[1] of each
+   *         system, the first system first.
+   */
+  template <typename RowFn>
+  static std::array<double, 4> forEachRow(LinearSystem *sys, const int count,
+                                          RowFn &&fn) {
+    const int rows0 = sys[0].op.ny;
+    const int rows = rows0 + (count > 1 ? sys[1].op.ny : 0);
+    double acc[4] = {0.0, 0.0, 0.0, 0.0};
+
+    OMP_PRAGMA(omp parallel for reduction(+ : acc[:4]) schedule(static))
+    for (int t = 0; t < rows; ++t) {
+      const int c = (t < rows0) ? 0 : 1;
+      if (!sys[c].done)
+        fn(c, (c == 0) ? t : t - rows0, acc + 2 * c);
+    }
+    return {acc[0], acc[1], acc[2], acc[3]};
+  }
+
+  /**
+   * @brief Rebuild the mask of @c pressure if the solid mask changed, and
+   *        set its right-hand side to -coef·div (after computeDivergence()).
+   * @param coef Scaling coefficient \f$\rho\,\Delta x^2 / \Delta t \f$.
+   */
+  void preparePressureSystem(varType coef);
+
+  /**
+   * @brief Build the MIC(0) preconditioner for the current solid mask.
+   *
+   * Only called when @c Fields2D::LabelsVersion() differs from the version
+   * cached in @c pcg.
+   */
+  void buildMICPreconditioner();
+
+  /**
+   * @brief Apply the configured preconditioner: @c z = M⁻¹ @c r.
+   * @param r Residual (input).
+   * @param z Preconditioned residual (output).
+   */
+  void applyPreconditioner(const std::vector<double> &r,
+                           std::vector<double> &z);
+
+  /**
+   * @brief Geometric multigrid pressure solver.
+   *
+   * Each iteration runs one V- or W-cycle on the residual equation
+   * \f$ A\,e = r \f$ and adds the correction to @c p.
+   */
+  void SolveMultigrid(int maxIters, double tol);
+
+  /**
+   * @brief (Re)build the level hierarchy and coarsened label masks if the
+   *        solid mask or @c SolverConfig::precision changed.
+   */
+  void prepareMultigrid();
+
+  /// @brief Build @p levels (finest first) for the current solid mask.
+  template <typename Real>
+  void buildMultigridHierarchy(std::vector<MultigridLevel<Real>> &levels);
+
+  /**
+   * @brief Approximate @c z = A⁻¹ @c r with one multigrid cycle from a zero
+   *        initial guess.
+   *
+   * The cycle is symmetric (red→black before, black→red after, restriction
+   * is the transpose of prolongation), so it is a valid CG preconditioner.
+   * With mixed precision @p r is rounded to float on the way in and the
+   * cycle runs on the float hierarchy; @p z is returned in double.
+   */
+  void applyMultigrid(const std::vector<double> &r,
+                      std::vector<double> &z);
+
+  /// @brief Cycle of @c applyMultigrid() on the hierarchy @p levels.
+  template <typename Real>
+  void applyMultigrid(std::vector<MultigridLevel<Real>> &levels,
+                      const std::vector<double> &r, std::vector<double> &z);
+
+  /// @brief Recursive V/W-cycle on @p levels starting at @p level.
+  template <typename Real>
+  void multigridCycle(std::vector<MultigridLevel<Real>> &levels,
+                      std::size_t level);
+
+  /**
+   * @brief Red-black Gauss-Seidel sweeps on one multigrid level.
+   * @param lvl     Level to smooth.
+   * @param sweeps  Number of red+black sweep pairs.
+   * @param reverse Visit black before red (used for post-smoothing).
+   */
+  template <typename Real>
+  static void smoothRedBlack(MultigridLevel<Real> &lvl, int sweeps,
+                             bool reverse);
+
+  /// @brief Store b - A·x of @p lvl in @c lvl.r (zero on SOLID cells).
+  template <typename Real>
+  static void levelResidual(MultigridLevel<Real> &lvl);
+
+  /// @brief Restrict @c fine.r into @c coarse.b (transpose of prolongation).
+  template <typename Real>
+  static void restrictResidual(const MultigridLevel<Real> &fine,
+                               MultigridLevel<Real> &coarse);
+
+  /// @brief Add the bilinearly prolongated @c coarse.x to @c fine.x.
+  template <typename Real>
+  static void prolongateCorrection(const MultigridLevel<Real> &coarse,
+                                   MultigridLevel<Real> &fine);
+
+  /**
+   * @brief Spectral pressure solver for rectangular fluid regions.
+   *
+   * Solves the residual equation exactly in O(N log N) with the in-tree
+   * DCT/DST transforms. Falls back to @c params.solver.fallback when the
+   * FLUID cells do not form an obstacle-free rectangle.
+   */
+  void SolveSpectral(int maxIters, double tol);
+
+  /// @brief Detect the fluid bounding box and set up its transforms.
+  void setupSpectral();
+
+  /**
+   * @brief Solve the box operator: @c z = A_box⁻¹ @c r, zero outside FLUID.
+   *
+   * Interior SOLID cells are treated as FLUID by A_box, which makes this an
+   * exact solve for obstacle-free boxes and an SPD preconditioner otherwise.
+   *
+   * @param r          Residual (input), nx × ny.
+   * @param z          Correction (output), nx × ny.
+   * @param regularise Replace the zero (all-Neumann) eigenvalue by the
+   *                   smallest non-zero one instead of dropping the mode,
+   *                   so the preconditioner stays definite.
+   */
+  void applySpectral(const std::vector<double> &r, std::vector<double> &z,
+                     bool regularise);
+
+  /**
+   * @brief Record the outcome of a pressure solve in @c solveStats and, in
+   *        debug builds, print it.
+   * @param name       Solver name used in the log line.
+   * @param iterations Iterations / cycles performed.
+   * @param res        Final RMS residual.
+   * @param res0       Reference residual of the relative criterion.
+   * @param converged  Whether the tolerance was reached.
+   */
+  void finishSolve(const char *name, int iterations, double res, double res0,
+                   bool converged);
+
+  /**
+   * @brief Relative-residual stopping test shared by all pressure solvers.
+   *
+   * On the first call (@p it == 0) @p res is stored in @p res0 as the
+   * reference; subsequent calls test \f$ \|r_k\| / \|r_0\| < \text{tol} \f$.
+   *
+   * @return @c true when the solver should stop.
+   */
+  static bool checkConvergence(double res, double &res0, int it, double tol);
 };
+
+} // namespace PIC_REAL
@@ -0,0 +1,192 @@
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <iostream>
+
+// Spectral pressure solve
+//
+// On a rectangle of FLUID cells the 5-point operator separates into
+// A = T_x ⊗ I + I ⊗ T_y, where each T is the 1-D tridiagonal Laplacian with
+// the boundary condition of that axis. Both are diagonalised by a real
+// trigonometric transform (DCT-II for Neumann, DST-I for Dirichlet), so
+//
+//   A⁻¹ r = S_x⁻¹ S_y⁻¹ [ (S_y S_x r)_kl / (λx_k + λy_l) ]
+//
+// which costs four batches of 1-D transforms, i.e. O(N log N) in total.
+// The solver is applied to the residual equation A·e = r, so fixed SOLID
+// pressures on Dirichlet edges are already accounted for in r.
+
+namespace PIC_REAL {
+
+void SemiLagrangian::setupSpectral() {
+  SpectralWorkspace &sp = spectral;
+  sp.labelsVersion = fields->LabelsVersion();
+  sp.valid = sp.exact = false;
+
+  // Bounding box of the FLUID cells.
+  int i0 = nx, i1 = -1, j0 = ny, j1 = -1;
+  for (int j = 0; j < ny; ++j) {
+    for (int i = 0; i < nx; ++i) {
+      if (fields->Label(i, j) != Fields2D::FLUID)
+        continue;
+      i0 = std::min(i0, i);
+      i1 = std::max(i1, i);
+      j0 = std::min(j0, j);
+      j1 = std::max(j1, j);
+    }
+  }
+  if (i1 < 0)
+    return; // no FLUID cell at all
+
+  // Outside the box every cell is SOLID, so a box edge is Dirichlet unless it
+  // touches the domain edge (Neumann). Mixed pairs have no fast transform.
+  const bool leftN = (i0 == 0), rightN = (i1 == nx - 1);
+  const bool bottomN = (j0 == 0), topN = (j1 == ny - 1);
+  if (leftN != rightN || bottomN != topN) {
+#ifndef NDEBUG
+    std::cout << "  Spectral: mixed Neumann/Dirichlet box edges, "
+                 "not applicable\n";
+#endif
+    return;
+  }
+
+  bool exact = true;
+  for (int j = j0; j <= j1 && exact; ++j)
+    for (int i = i0; i <= i1 && exact; ++i)
+      exact = (fields->Label(i, j) == Fields2D::FLUID);
+
+  sp.i0 = i0;
+  sp.j0 = j0;
+  sp.w = i1 - i0 + 1;
+  sp.h = j1 - j0 + 1;
+  sp.tx = std::make_unique<TrigTransform>(
+      sp.w, leftN ? TrigTransform::Kind::DCT2 : TrigTransform::Kind::DST1);
+  sp.ty = std::make_unique<TrigTransform>(
+      sp.h, bottomN ? TrigTransform::Kind::DCT2 : TrigTransform::Kind::DST1);
+  sp.box.assign(static_cast<std::size_t>(sp.w) * sp.h, 0.0);
+  sp.workPerThread = std::max(sp.tx->workSize(), sp.ty->workSize());
+  sp.work.assign(sp.workPerThread * MAX_THREADS(), {0.0, 0.0});
+  sp.valid = true;
+  sp.exact = exact;
+
+#ifndef NDEBUG
+  std::cout << "  Spectral: box " << sp.w << " x " << sp.h << " at (" << i0
+            << ", " << j0 << "), " << (leftN ? "Neumann" : "Dirichlet")
+            << " in x, " << (bottomN ? "Neumann" : "Dirichlet") << " in y"
+            << (exact ? "" : ", interior solids") << '\n';
+#endif
+}
+
+void SemiLagrangian::applySpectral(const std::vector<double> &r,
+                                   std::vector<double> &z,
+                                   const bool regularise) {
+  SpectralWorkspace &sp = spectral;
+  const int w = sp.w;
+  const int h = sp.h;
+  double *box = sp.box.data();
+  const TrigTransform &tx = *sp.tx;
+  const TrigTransform &ty = *sp.ty;
+
+  // Only an all-Neumann box has a zero eigenvalue (the constant mode).
+  // Dropping it gives the mean-free solution; the preconditioner instead
+  // uses the smallest non-zero eigenvalue so that M⁻¹ stays definite.
+  double lambdaZero = 0.0;
+  if (regularise) {
+    lambdaZero = 1.0;
+    if (w > 1)
+      lambdaZero = std::min(lambdaZero, tx.eigenvalue(1));
+    if (h > 1)
+      lambdaZero = std::min(lambdaZero, ty.eigenvalue(1));
+  }
+
+  OMP_PRAGMA(omp parallel)
+  {
+    std::complex<double> *work =
+        sp.work.data() + sp.workPerThread * THREAD_NUM();
+
+    // Gather the box and transform its rows.
+    OMP_PRAGMA(omp for schedule(static))
+    for (int jj = 0; jj < h; ++jj) {
+      const double *src = r.data() + static_cast<std::size_t>(nx) *
+                                         (sp.j0 + jj) + sp.i0;
+      std::copy(src, src + w, box + static_cast<std::size_t>(w) * jj);
+      tx.forward(box + static_cast<std::size_t>(w) * jj, 1, work);
+    }
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int ii = 0; ii < w; ++ii)
+      ty.forward(box + ii, w, work);
+
+    // Divide by the eigenvalues of A in the transformed basis.
+    OMP_PRAGMA(omp for schedule(static))
+    for (int jj = 0; jj < h; ++jj) {
+      for (int ii = 0; ii < w; ++ii) {
+        const double lambda = tx.eigenvalue(ii) + ty.eigenvalue(jj);
+        double &c = box[static_cast<std::size_t>(w) * jj + ii];
+        if (lambda > 0.0)
+          c /= lambda;
+        else
+          c = regularise ? c / lambdaZero : 0.0;
+      }
+    }
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int ii = 0; ii < w; ++ii)
+      ty.inverse(box + ii, w, work);
+
+    OMP_PRAGMA(omp for schedule(static))
+    for (int jj = 0; jj < h; ++jj)
+      tx.inverse(box + static_cast<std::size_t>(w) * jj, 1, work);
+
+    // Scatter back, keeping the correction zero outside FLUID cells.
+    OMP_PRAGMA(omp for collapse(2) schedule(static))
+    for (int j = 0; j < ny; ++j) {
+      for (int i = 0; i < nx; ++i) {
+        const int ii = i - sp.i0;
+        const int jj = j - sp.j0;
+        const bool inBox = ii >= 0 && ii < w && jj >= 0 && jj < h;
+        z[nx * j + i] = (inBox && fields->Label(i, j) == Fields2D::FLUID)
+                            ? box[static_cast<std::size_t>(w) * jj + ii]
+                            : 0.0;
+      }
+    }
+  }
+}
+
+void SemiLagrangian::SolveSpectral(int maxIters, double tol) {
+  if (spectral.labelsVersion != fields->LabelsVersion())
+    setupSpectral();
+
+  if (!spectral.exact) {
+    // Interior obstacles (or an unsupported box): the transform no longer
+    // diagonalises A, hand over to the configured iterative solver.
+    solvePressure(params.solver.fallback, maxIters, tol);
+    return;
+  }
+
+  const varType coef = density * dx * dx / dt;
+  computeDivergence();
+
+  const std::size_t n = static_cast<std::size_t>(nx) * ny;
+  if (spectral.r.size() != n) {
+    spectral.r.assign(n, 0.0);
+    spectral.z.assign(n, 0.0);
+  }
+
+  double res0 = 1.0;
+  const double res = computeResidual(coef, spectral.r);
+  if (checkConvergence(res, res0, 0, tol)) {
+    finishSolve("Spectral", 0, res, res0, true);
+    return;
+  }
+
+  // Direct solve of A·e = r, then p ← p + e.
+  applySpectral(spectral.r, spectral.z, false);
+
+  addCorrection(spectral.z);
+
+  // A direct solve always "converges"; the residual is still measured so the
+  // statistics stay comparable with the iterative solvers.
+  finishSolve("Spectral", 1, computeResidual(coef, spectral.r), res0, true);
+}
+
+} // namespace PIC_REAL
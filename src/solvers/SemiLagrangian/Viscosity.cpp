@@ -0,0 +1,126 @@
+#include "SemiLagrangian.hpp"
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+
+// Implicit viscous diffusion
+//
+// Each velocity component is diffused on its own face grid with the
+// Helmholtz operator
+//
+//   (A·x)_k = x_k + cx·(2x_k - x_W - x_E) + cy·(2x_k - x_S - x_N),
+//   cx = θ·ν·Δt/Δx²,  cy = θ·ν·Δt/Δy²,
+//
+// a StencilOperator with shift 1, symmetric and strictly diagonally
+// dominant, with a condition number below 1 + 4·(cx + cy): solvePCG(),
+// shared with the pressure, with its Jacobi preconditioner, or
+// solveRedBlack(), converge in a handful of iterations, so no multigrid
+// hierarchy is needed.
+// A neighbour outside the domain is replaced by the face itself, which
+// drops it from the stencil (zero normal gradient). Fixed faces keep their
+// value in x and enter A·x as Dirichlet data.
+//
+// Both solvers number the rows of u and v one after the other and run
+// every pass over both in a single parallel loop: the two solves share the
+// thread team and its barriers instead of running back to back.
+
+namespace PIC_REAL {
+
+// Setup
+
+void SemiLagrangian::prepareViscosity() {
+  if (viscosity.labelsVersion == fields->LabelsVersion())
+    return;
+
+  const bool pcgBuffers = params.viscosity.solver == SolverConfig::Type::PCG;
+  viscosity.sys[0].resize(fields->u, pcgBuffers);
+  viscosity.sys[1].resize(fields->v, pcgBuffers);
+
+  // Unknown faces: inside the domain and between two FLUID cells, the
+  // faces updateVelocities() corrects.
+  LinearSystem &u = viscosity.sys[0];
+  LinearSystem &v = viscosity.sys[1];
+  for (int j = 0; j < fields->u.ny; ++j)
+    for (int i = 1; i < fields->u.nx - 1; ++i)
+      u.free[static_cast<std::size_t>(fields->u.nx) * j + i] =
+          fields->Label(i - 1, j) == Fields2D::FLUID &&
+          fields->Label(i, j) == Fields2D::FLUID;
+  for (int j = 1; j < fields->v.ny - 1; ++j)
+    for (int i = 0; i < fields->v.nx; ++i)
+      v.free[static_cast<std::size_t>(fields->v.nx) * j + i] =
+          fields->Label(i, j - 1) == Fields2D::FLUID &&
+          fields->Label(i, j) == Fields2D::FLUID;
+
+  for (LinearSystem &h : viscosity.sys)
+    h.unknowns = static_cast<int>(
+        std::count(h.free.begin(), h.free.end(), uint8_t{1}));
+  viscosity.labelsVersion = fields->LabelsVersion();
+}
+
+// Stage
+
+void SemiLagrangian::Diffuse() {
+  const ViscosityConfig &vc = params.viscosity;
+  prepareViscosity();
+  // Advection swaps u and v with their back-buffers.
+  viscosity.sys[0].bind(fields->u);
+  viscosity.sys[1].bind(fields->v);
+
+  // Faces next to SOLID cells take the wall velocity, which the projection
+  // imposes again afterwards; the domain-boundary faces keep theirs.
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 0; j < fields->u.ny; ++j)
+    for (int i = 1; i < fields->u.nx - 1; ++i)
+      if (!viscosity.sys[0].free[static_cast<std::size_t>(fields->u.nx) * j +
+                                 i])
+        fields->u.Set(i, j, fields->usolid);
+  OMP_PRAGMA(omp parallel for schedule(static))
+  for (int j = 1; j < fields->v.ny - 1; ++j)
+    for (int i = 0; i < fields->v.nx; ++i)
+      if (!viscosity.sys[1].free[static_cast<std::size_t>(fields->v.nx) * j +
+                                 i])
+        fields->v.Set(i, j, fields->usolid);
+
+  const double theta =
+      (vc.scheme == ViscosityConfig::Scheme::CRANK_NICOLSON) ? 0.5 : 1.0;
+
+  // b = (I + (1-θ)·ν·Δt·L)·x, i.e. the operator with the opposite sign of
+  // the explicit weight; plain x for backward Euler. A = I - θ·ν·Δt·L.
+  std::array<StencilOperator, 2> rhs;
+  const double implicitW = theta * vc.nu * dt;
+  const double explicitW = -(1.0 - theta) * vc.nu * dt;
+  for (int c = 0; c < 2; ++c) {
+    LinearSystem &h = viscosity.sys[c];
+    h.op = {h.op.nx, h.op.ny, 1.0, implicitW / (dx * dx),
+            implicitW / (dy * dy)};
+    rhs[c] = {h.op.nx, h.op.ny, 1.0, explicitW / (dx * dx),
+              explicitW / (dy * dy)};
+    h.begin();
+  }
+  forEachRow(viscosity.sys.data(), 2,
+             [&](const int c, const int j, double *) {
+               LinearSystem &h = viscosity.sys[c];
+               rhs[c].applyRow(h.x, h.stride, h.free.data(), j,
+                               h.b.data());
+             });
+
+  if (vc.solver == SolverConfig::Type::RED_BLACK_GAUSS_SEIDEL)
+    solveRedBlack(viscosity.sys.data(), 2, vc.maxIters, vc.tolerance);
+  else
+    solvePCG(viscosity.sys.data(), 2, vc.maxIters, vc.tolerance);
+
+  profiler.count(VISCOSITY_ITERATIONS,
+                 std::max(viscosity.sys[0].iterations,
+                          viscosity.sys[1].iterations));
+
+#ifndef NDEBUG
+  for (int c = 0; c < 2; ++c) {
+    const LinearSystem &h = viscosity.sys[c];
+    std::cout << "  Viscosity (" << (c == 0 ? 'u' : 'v') << "): "
+              << h.iterations << " iters, rel.res = "
+              << (h.res0 > 0.0 ? h.res / h.res0 : 0.0) << '\n';
+  }
+#endif
+}
+
+} // namespace PIC_REAL